@@ -40,6 +40,7 @@
 #include <netinet/in.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 
 #include <dirent.h>
@@ -154,6 +155,17 @@ typedef struct
 #endif
 } NETSOCKET_BUFFER;
 
+#ifdef CONF_PLATFORM_LINUX
+typedef struct
+{
+	int size;
+	struct mmsghdr msgs[VLEN];
+	struct iovec iovecs[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+	struct sockaddr_in6 sockaddrs[VLEN];
+} NETSOCKET_SEND_QUEUE;
+#endif
+
 void net_buffer_init(NETSOCKET_BUFFER *buffer);
 void net_buffer_reinit(NETSOCKET_BUFFER *buffer);
 void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size);
@@ -166,6 +178,10 @@ struct NETSOCKET_INTERNAL
 	int web_ipv4sock;
 
 	NETSOCKET_BUFFER buffer;
+#ifdef CONF_PLATFORM_LINUX
+	/* packets waiting for net_udp_flush, for the ipv4 and ipv6 socket */
+	NETSOCKET_SEND_QUEUE *send_queues[2];
+#endif
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1};
 
@@ -427,6 +443,44 @@ int io_close(IOHANDLE io)
 	return fclose((FILE *)io) != 0;
 }
 
+void *io_map(IOHANDLE io, unsigned *size)
+{
+	*size = 0;
+	const long int length = io_length(io);
+	if(length <= 0 || (unsigned long)length > 0xffffffffUL)
+		return nullptr;
+
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno((FILE *)io));
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping)
+		return nullptr;
+	// the view keeps the mapping alive
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if(!data)
+		return nullptr;
+#else
+	void *data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno((FILE *)io), 0);
+	if(data == MAP_FAILED)
+		return nullptr;
+#endif
+
+	*size = length;
+	return data;
+}
+
+void io_unmap(void *data, unsigned size)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
 int io_flush(IOHANDLE io)
 {
 	return fflush((FILE *)io);
@@ -1618,6 +1672,49 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+static void priv_net_send_queue_flush(NETSOCKET_SEND_QUEUE *queue, int socket)
+{
+	int sent = 0;
+	while(sent < queue->size)
+	{
+		int result = sendmmsg(socket, queue->msgs + sent, queue->size - sent, 0);
+		network_stats.send_calls++;
+		if(result > 0)
+			sent += result;
+		else if(errno != EINTR)
+			sent++; /* drop the failing packet like a failed sendto would */
+	}
+	queue->size = 0;
+}
+#endif
+
+static int priv_net_udp_send(NETSOCKET sock, int family, int socket, const void *sockaddr, socklen_t sockaddr_len, const void *data, int size)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queues[family];
+	if(queue && size <= PACKETSIZE)
+	{
+		if(queue->size == VLEN)
+			priv_net_send_queue_flush(queue, socket);
+
+		const int i = queue->size++;
+		mem_copy(queue->bufs[i], data, size);
+		mem_copy(&queue->sockaddrs[i], sockaddr, sockaddr_len);
+		queue->iovecs[i].iov_len = size;
+		queue->msgs[i].msg_hdr.msg_namelen = sockaddr_len;
+		return size;
+	}
+	else if(queue)
+	{
+		/* keep the order of the packets */
+		priv_net_send_queue_flush(queue, socket);
+	}
+#endif
+	network_stats.send_calls++;
+	return sendto(socket, (const char *)data, size, 0, (const struct sockaddr *)sockaddr, sockaddr_len);
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
@@ -1637,7 +1734,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 			else
 				netaddr_to_sockaddr_in(addr, &sa);
 
-			d = sendto((int)sock->ipv4sock, (const char *)data, size, 0, (struct sockaddr *)&sa, sizeof(sa));
+			d = priv_net_udp_send(sock, 0, sock->ipv4sock, &sa, sizeof(sa), data, size);
 		}
 		else
 			dbg_msg("net", "can't send ipv4 traffic to this socket");
@@ -1675,7 +1772,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 			else
 				netaddr_to_sockaddr_in6(addr, &sa);
 
-			d = sendto((int)sock->ipv6sock, (const char *)data, size, 0, (struct sockaddr *)&sa, sizeof(sa));
+			d = priv_net_udp_send(sock, 1, sock->ipv6sock, &sa, sizeof(sa), data, size);
 		}
 		else
 			dbg_msg("net", "can't send ipv6 traffic to this socket");
@@ -1821,8 +1918,50 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 	return -1; /* error */
 }
 
+void net_udp_set_batching(NETSOCKET sock, bool batching)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	const int sockets[2] = {sock->ipv4sock, sock->ipv6sock};
+	for(int family = 0; family < 2; family++)
+	{
+		NETSOCKET_SEND_QUEUE *queue = sock->send_queues[family];
+		if(batching && !queue && sockets[family] >= 0)
+		{
+			queue = (NETSOCKET_SEND_QUEUE *)malloc(sizeof(*queue));
+			queue->size = 0;
+			mem_zero(queue->msgs, sizeof(queue->msgs));
+			for(int i = 0; i < VLEN; ++i)
+			{
+				queue->iovecs[i].iov_base = queue->bufs[i];
+				queue->msgs[i].msg_hdr.msg_iov = &queue->iovecs[i];
+				queue->msgs[i].msg_hdr.msg_iovlen = 1;
+				queue->msgs[i].msg_hdr.msg_name = &queue->sockaddrs[i];
+			}
+			sock->send_queues[family] = queue;
+		}
+		else if(!batching && queue)
+		{
+			priv_net_send_queue_flush(queue, sockets[family]);
+			free(queue);
+			sock->send_queues[family] = nullptr;
+		}
+	}
+#endif
+}
+
+void net_udp_flush(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(sock->send_queues[0])
+		priv_net_send_queue_flush(sock->send_queues[0], sock->ipv4sock);
+	if(sock->send_queues[1])
+		priv_net_send_queue_flush(sock->send_queues[1], sock->ipv6sock);
+#endif
+}
+
 int net_udp_close(NETSOCKET sock)
 {
+	net_udp_set_batching(sock, false);
 	return priv_net_close_all_sockets(sock);
 }
 
@@ -369,6 +369,33 @@ long int io_length(IOHANDLE io);
  */
 int io_close(IOHANDLE io);
 
+/**
+ * Maps the whole contents of a file read-only into memory.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to a file opened with IOFLAG_READ.
+ * @param size Receives the size of the mapping.
+ *
+ * @return Pointer to the contents of the file or null on failure and for
+ * empty files.
+ *
+ * @remark The mapping stays valid after the file is closed.
+ * @remark The file must not be truncated while it is mapped.
+ * @remark The result must be released with io_unmap.
+ */
+void *io_map(IOHANDLE io, unsigned *size);
+
+/**
+ * Releases a mapping returned by io_map.
+ *
+ * @ingroup File-IO
+ *
+ * @param data The mapped contents, can be null.
+ * @param size The size returned by io_map.
+ */
+void io_unmap(void *data, unsigned size);
+
 /**
  * Empties all buffers and writes all pending data.
  *
@@ -913,6 +940,34 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 */
 int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data);
 
+/**
+ * Queues the packets sent over an UDP socket instead of sending each of
+ * them with its own system call.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ * @param batching Whether to queue the packets. Disabling it sends the
+ * queued packets.
+ *
+ * @remark The queued packets are sent by @link net_udp_flush @endlink, when
+ * the queue is full and when the socket is closed.
+ * @remark Only supported on Linux, where the queue is sent with sendmmsg.
+ * Other platforms keep sending every packet directly.
+ */
+void net_udp_set_batching(NETSOCKET sock, bool batching);
+
+/**
+ * Sends the packets queued on an UDP socket.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ *
+ * @see net_udp_set_batching
+ */
+void net_udp_flush(NETSOCKET sock);
+
 /**
  * Closes an UDP socket.
  *
@@ -2085,6 +2140,7 @@ typedef struct
 	uint64_t sent_bytes;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
+	uint64_t send_calls;
 } NETSTATS;
 
 void net_stats(NETSTATS *stats);
@@ -0,0 +1,135 @@
+#ifndef BASE_TL_IC_SLAB_ALLOCATOR_H
+#define BASE_TL_IC_SLAB_ALLOCATOR_H
+
+#include <base/system.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Freed slots are filled with a pattern which is checked when they are
+// handed out again, to catch the writes through dangling pointers. This is
+// the default of the allocators, the tests turn it on for theirs.
+#ifndef IC_SLAB_POISON
+#ifdef CONF_DEBUG
+#define IC_SLAB_POISON 1
+#else
+#define IC_SLAB_POISON 0
+#endif
+#endif
+
+// Hands out slots of a fixed size carved out of slabs aligned on cache
+// lines. The freed slots are kept in a list and reused before a new slab
+// is allocated, the slabs are only released with the allocator.
+class icSlabAllocator
+{
+public:
+	constexpr static std::size_t sAlignment = 64;
+	constexpr static unsigned char sPoison = 0xdd;
+
+	explicit icSlabAllocator(std::size_t SlotSize, int SlotsPerSlab = 64, bool Poison = IC_SLAB_POISON);
+	~icSlabAllocator();
+
+	icSlabAllocator(const icSlabAllocator &) = delete;
+	icSlabAllocator &operator=(const icSlabAllocator &) = delete;
+
+	void *Allocate();
+	void Free(void *pSlot);
+
+	std::size_t SlotSize() const { return m_SlotSize; }
+	int NumSlabs() const { return m_vpSlabs.size(); }
+	int Capacity() const { return NumSlabs() * m_SlotsPerSlab; }
+	int NumUsed() const { return m_NumUsed; }
+	int PeakUsed() const { return m_PeakUsed; }
+	int64_t NumAllocations() const { return m_NumAllocations; }
+
+private:
+	struct CFreeSlot
+	{
+		CFreeSlot *m_pNext;
+	};
+
+	void AddSlab();
+
+	std::size_t m_SlotSize;
+	int m_SlotsPerSlab;
+	bool m_Poison;
+	std::vector<void *> m_vpSlabs;
+	CFreeSlot *m_pFirstFree = nullptr;
+	int m_NumUsed = 0;
+	int m_PeakUsed = 0;
+	int64_t m_NumAllocations = 0;
+};
+
+inline icSlabAllocator::icSlabAllocator(std::size_t SlotSize, int SlotsPerSlab, bool Poison) :
+	m_SlotSize((SlotSize + sAlignment - 1) / sAlignment * sAlignment),
+	m_SlotsPerSlab(SlotsPerSlab),
+	m_Poison(Poison)
+{
+	if(m_SlotSize == 0)
+		m_SlotSize = sAlignment;
+	dbg_assert(m_SlotsPerSlab > 0, "a slab needs at least one slot");
+}
+
+inline icSlabAllocator::~icSlabAllocator()
+{
+	for(void *pSlab : m_vpSlabs)
+		::operator delete(pSlab, std::align_val_t(sAlignment));
+}
+
+inline void *icSlabAllocator::Allocate()
+{
+	if(!m_pFirstFree)
+		AddSlab();
+
+	CFreeSlot *pSlot = m_pFirstFree;
+	m_pFirstFree = pSlot->m_pNext;
+	if(m_Poison)
+	{
+		const unsigned char *pBytes = reinterpret_cast<const unsigned char *>(pSlot);
+		std::size_t i = sizeof(CFreeSlot);
+		while(i < m_SlotSize && pBytes[i] == sPoison)
+			i++;
+		dbg_assert(i == m_SlotSize, "slab slot written after it was freed");
+	}
+
+	m_NumUsed++;
+	m_NumAllocations++;
+	if(m_NumUsed > m_PeakUsed)
+		m_PeakUsed = m_NumUsed;
+	return pSlot;
+}
+
+inline void icSlabAllocator::Free(void *pSlot)
+{
+	if(!pSlot)
+		return;
+
+	dbg_assert(m_NumUsed > 0, "more slab slots freed than allocated");
+	if(m_Poison)
+		std::memset(pSlot, sPoison, m_SlotSize);
+	CFreeSlot *pFreeSlot = static_cast<CFreeSlot *>(pSlot);
+	pFreeSlot->m_pNext = m_pFirstFree;
+	m_pFirstFree = pFreeSlot;
+	m_NumUsed--;
+}
+
+inline void icSlabAllocator::AddSlab()
+{
+	char *pSlab = static_cast<char *>(::operator new(m_SlotSize * m_SlotsPerSlab, std::align_val_t(sAlignment)));
+	m_vpSlabs.push_back(pSlab);
+	if(m_Poison)
+		std::memset(pSlab, sPoison, m_SlotSize * m_SlotsPerSlab);
+
+	// the first slot of the slab is handed out first
+	for(int i = m_SlotsPerSlab - 1; i >= 0; i--)
+	{
+		CFreeSlot *pSlot = reinterpret_cast<CFreeSlot *>(pSlab + i * m_SlotSize);
+		pSlot->m_pNext = m_pFirstFree;
+		m_pFirstFree = pSlot;
+	}
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef BASE_TL_IC_SPATIAL_GRID_H
+#define BASE_TL_IC_SPATIAL_GRID_H
+
+#include <base/system.h>
+#include <base/vmath.h>
+
+#include <vector>
+
+// Uniform grid over a rectangular area (in world units) with intrusive
+// per-cell lists. The items own their nodes, so inserting, moving and
+// removing an item never allocates. Positions outside of the area are
+// clamped to the border cells, thus every item is always indexed.
+template<class T>
+class icSpatialGrid
+{
+public:
+	class CNode
+	{
+		friend class icSpatialGrid;
+
+		T *m_pItem = nullptr;
+		CNode *m_pPrev = nullptr;
+		CNode *m_pNext = nullptr;
+		int m_Cell = -1;
+
+	public:
+		bool IsLinked() const { return m_Cell >= 0; }
+		int Cell() const { return m_Cell; }
+	};
+
+	icSpatialGrid() { Init(0, 0, 1); }
+
+	void Init(float Width, float Height, float CellSize);
+
+	int CellsX() const { return m_CellsX; }
+	int CellsY() const { return m_CellsY; }
+	int NumItems() const { return m_NumItems; }
+
+	int CellIndex(vec2 Pos) const;
+
+	void Insert(CNode *pNode, T *pItem, vec2 Pos);
+	void Remove(CNode *pNode);
+	void Update(CNode *pNode, vec2 Pos);
+
+	// Calls Callback(T *) for every item in the cells overlapping the
+	// [Min, Max] box. The caller is expected to do the exact test.
+	template<class F>
+	void Query(vec2 Min, vec2 Max, F &&Callback) const;
+
+protected:
+	int CellCoord(float Value, int NumCells) const;
+	void Link(CNode *pNode, int Cell);
+
+	std::vector<CNode *> m_apCells;
+	float m_InvCellSize = 1.0f;
+	int m_CellsX = 1;
+	int m_CellsY = 1;
+	int m_NumItems = 0;
+};
+
+template<class T>
+inline void icSpatialGrid<T>::Init(float Width, float Height, float CellSize)
+{
+	// Rebucketing is not supported
+	dbg_assert(m_NumItems == 0, "spatial grid initialized while not empty");
+
+	m_InvCellSize = 1.0f / CellSize;
+	m_CellsX = maximum(1, static_cast<int>(std::ceil(Width * m_InvCellSize)));
+	m_CellsY = maximum(1, static_cast<int>(std::ceil(Height * m_InvCellSize)));
+	m_apCells.assign(static_cast<std::size_t>(m_CellsX) * m_CellsY, nullptr);
+}
+
+template<class T>
+inline int icSpatialGrid<T>::CellCoord(float Value, int NumCells) const
+{
+	const float Cell = Value * m_InvCellSize;
+	// Written this way to also map NaN to the first cell
+	if(!(Cell > 0.0f))
+		return 0;
+	if(Cell >= NumCells - 1)
+		return NumCells - 1;
+	return static_cast<int>(Cell);
+}
+
+template<class T>
+inline int icSpatialGrid<T>::CellIndex(vec2 Pos) const
+{
+	return CellCoord(Pos.y, m_CellsY) * m_CellsX + CellCoord(Pos.x, m_CellsX);
+}
+
+template<class T>
+inline void icSpatialGrid<T>::Link(CNode *pNode, int Cell)
+{
+	pNode->m_Cell = Cell;
+	pNode->m_pPrev = nullptr;
+	pNode->m_pNext = m_apCells[Cell];
+	if(pNode->m_pNext)
+		pNode->m_pNext->m_pPrev = pNode;
+	m_apCells[Cell] = pNode;
+}
+
+template<class T>
+inline void icSpatialGrid<T>::Insert(CNode *pNode, T *pItem, vec2 Pos)
+{
+	dbg_assert(!pNode->IsLinked(), "spatial grid node inserted twice");
+
+	pNode->m_pItem = pItem;
+	Link(pNode, CellIndex(Pos));
+	m_NumItems++;
+}
+
+template<class T>
+inline void icSpatialGrid<T>::Remove(CNode *pNode)
+{
+	if(!pNode->IsLinked())
+		return;
+
+	if(pNode->m_pPrev)
+		pNode->m_pPrev->m_pNext = pNode->m_pNext;
+	else
+		m_apCells[pNode->m_Cell] = pNode->m_pNext;
+	if(pNode->m_pNext)
+		pNode->m_pNext->m_pPrev = pNode->m_pPrev;
+
+	pNode->m_pPrev = nullptr;
+	pNode->m_pNext = nullptr;
+	pNode->m_Cell = -1;
+	m_NumItems--;
+}
+
+template<class T>
+inline void icSpatialGrid<T>::Update(CNode *pNode, vec2 Pos)
+{
+	if(!pNode->IsLinked())
+		return;
+
+	const int Cell = CellIndex(Pos);
+	if(Cell == pNode->m_Cell)
+		return;
+
+	T *pItem = pNode->m_pItem;
+	Remove(pNode);
+	pNode->m_pItem = pItem;
+	Link(pNode, Cell);
+	m_NumItems++;
+}
+
+template<class T>
+template<class F>
+inline void icSpatialGrid<T>::Query(vec2 Min, vec2 Max, F &&Callback) const
+{
+	const int X0 = CellCoord(Min.x, m_CellsX);
+	const int X1 = CellCoord(Max.x, m_CellsX);
+	const int Y0 = CellCoord(Min.y, m_CellsY);
+	const int Y1 = CellCoord(Max.y, m_CellsY);
+
+	for(int y = Y0; y <= Y1; y++)
+	{
+		for(int x = X0; x <= X1; x++)
+		{
+			for(const CNode *pNode = m_apCells[y * m_CellsX + x]; pNode; pNode = pNode->m_pNext)
+			{
+				Callback(pNode->m_pItem);
+			}
+		}
+	}
+}
+
+#endif // BASE_TL_IC_SPATIAL_GRID_H
@@ -33,6 +33,9 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap")
 public:
 	virtual bool Load(const char *pMapName) = 0;
+	// For maps which are not registered in a kernel. RememberHash keeps
+	// the hashes of the map file in a sidecar of the save directory.
+	virtual bool Load(class IStorage *pStorage, const char *pMapName, bool RememberHash) = 0;
 	virtual void Unload() = 0;
 	virtual bool IsLoaded() const = 0;
 	virtual IOHANDLE File() const = 0;
@@ -332,6 +332,14 @@ public:
 	virtual void SnapFreeId(int Id) = 0;
 	virtual void *SnapNewItem(int Type, int Id, int Size) = 0;
 
+	// Records the items added with SnapNewItem() until SnapStopRecording(),
+	// which stores them with their final content into pvRecording. The
+	// recording can then be added to the snapshot of other clients with
+	// SnapReplayItems(). Recordings can not be nested.
+	virtual void SnapStartRecording() = 0;
+	virtual void SnapStopRecording(std::vector<int> *pvRecording) = 0;
+	virtual bool SnapReplayItems(const std::vector<int> &vRecording) = 0;
+
 	template<typename T>
 	T *SnapNewItem(int Id)
 	{
@@ -20,6 +20,7 @@
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/filecollection.h>
+#include <engine/shared/filehash.h>
 #include <engine/shared/http.h>
 #include <engine/shared/json.h>
 #include <engine/shared/masterserver.h>
@@ -338,13 +339,91 @@ void CRconClientLogger::Log(const CLogMessage *pMessage)
 	m_pServer->SendRconLogLine(m_ClientId, pMessage);
 }
 
+void CServer::CClient::CInputTiming::Reset()
+{
+	m_NumInputs = 0;
+	m_NumLate = 0;
+	m_SumTimeLeft = 0;
+	m_MinTimeLeft = 0;
+	m_MaxTimeLeft = 0;
+}
+
+void CServer::CClient::CInputTiming::Add(int TimeLeft, bool Late)
+{
+	if(m_NumInputs == 0 || TimeLeft < m_MinTimeLeft)
+		m_MinTimeLeft = TimeLeft;
+	if(m_NumInputs == 0 || TimeLeft > m_MaxTimeLeft)
+		m_MaxTimeLeft = TimeLeft;
+	m_NumInputs++;
+	m_SumTimeLeft += TimeLeft;
+	if(Late)
+		m_NumLate++;
+}
+
+int CServer::CClient::InputTick(int IntendedTick, int CurrentTick)
+{
+	if(IntendedTick <= CurrentTick)
+		return CurrentTick + 1;
+	if(IntendedTick >= CurrentTick + INPUT_TICKS)
+		return CurrentTick + INPUT_TICKS - 1;
+	return IntendedTick;
+}
+
+CServer::CClient::CInput *CServer::CClient::AddInput(int GameTick)
+{
+	CInput *pInput = &m_aInputs[m_CurrentInput];
+
+	// the overwritten input is the oldest one, so the first of its tick
+	if(pInput->m_GameTick >= 0)
+	{
+		const int Slot = pInput->m_GameTick % INPUT_TICKS;
+		if(m_aFirstInput[Slot] == m_CurrentInput)
+		{
+			m_aFirstInput[Slot] = pInput->m_NextInput;
+			if(m_aFirstInput[Slot] < 0)
+				m_aLastInput[Slot] = -1;
+		}
+	}
+
+	pInput->m_GameTick = GameTick;
+	pInput->m_NextInput = -1;
+
+	const int Slot = GameTick % INPUT_TICKS;
+	const int First = m_aFirstInput[Slot];
+	if(First >= 0 && m_aInputs[First].m_GameTick == GameTick)
+		m_aInputs[m_aLastInput[Slot]].m_NextInput = m_CurrentInput;
+	else
+		m_aFirstInput[Slot] = m_CurrentInput;
+	m_aLastInput[Slot] = m_CurrentInput;
+
+	m_CurrentInput = (m_CurrentInput + 1) % NUM_INPUTS;
+	return pInput;
+}
+
+CServer::CClient::CInput *CServer::CClient::FirstInput(int GameTick)
+{
+	const int First = m_aFirstInput[GameTick % INPUT_TICKS];
+	if(First < 0 || m_aInputs[First].m_GameTick != GameTick)
+		return nullptr;
+	return &m_aInputs[First];
+}
+
 void CServer::CClient::Reset(bool ResetScore)
 {
 	// reset input
 	for(auto &Input : m_aInputs)
+	{
 		Input.m_GameTick = -1;
+		Input.m_NextInput = -1;
+	}
+	for(int i = 0; i < INPUT_TICKS; i++)
+	{
+		m_aFirstInput[i] = -1;
+		m_aLastInput[i] = -1;
+	}
 	m_CurrentInput = 0;
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
+	m_InputTiming.Reset();
 
 	m_Snapshots.PurgeAll();
 	m_LastAckedSnapshot = -1;
@@ -385,11 +464,19 @@ CServer::CServer()
 {
 	m_pConfig = &g_Config;
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
-	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false);
+		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true, true);
+	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false, true);
 
 	m_TickSpeed = SERVER_TICK_SPEED;
 
+	m_ProfileZones.m_pPumpNetwork = CProfiler::Zone("server/pump_network");
+	m_ProfileZones.m_pGameTick = CProfiler::Zone("server/game_tick");
+	m_ProfileZones.m_pSnapshot = CProfiler::Zone("server/snapshot");
+	m_ProfileZones.m_pSnapshotBuild = CProfiler::Zone("server/snapshot/build");
+	m_ProfileZones.m_pSnapshotDelta = CProfiler::Zone("server/snapshot/delta");
+	m_ProfileZones.m_pSnapshotCompress = CProfiler::Zone("server/snapshot/compress");
+	m_ProfileZones.m_pSnapshotSend = CProfiler::Zone("server/snapshot/send");
+
 	m_pGameServer = 0;
 
 	m_CurrentGameTick = MIN_TICK;
@@ -401,11 +488,19 @@ CServer::CServer()
 	{
 		m_apCurrentMapData[i] = 0;
 		m_aCurrentMapSize[i] = 0;
+		m_aCurrentMapDataMapped[i] = false;
 	}
 
 	m_MapReload = false;
 	m_ReloadedWhenEmpty = false;
+
+	mem_zero(&m_NetStatsStart, sizeof(m_NetStatsStart));
+	m_NetStatsStartTick = 0;
+	m_SendCallsPerTick = 0.0f;
+	m_SentPacketsPerTick = 0.0f;
+
 	m_aCurrentMap[0] = '\0';
+	m_pClientMapCache = std::make_shared<CClientMapCache>();
 
 	m_RconClientId = IServer::RCON_CID_SERV;
 	m_RconAuthLevel = AUTHED_ADMIN;
@@ -428,9 +523,9 @@ CServer::CServer()
 
 CServer::~CServer()
 {
-	for(auto &pCurrentMapData : m_apCurrentMapData)
+	for(int MapType = 0; MapType < NUM_MAP_TYPES; MapType++)
 	{
-		free(pCurrentMapData);
+		FreeCurrentMapData(MapType);
 	}
 
 	if(m_RunServer != UNINITIALIZED)
@@ -1089,24 +1184,208 @@ void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 	m_NetServer.Send(&Packet);
 }
 
+class CSnapshotEncodeJob : public IJob
+{
+	CServer *m_pServer;
+	int m_Start;
+	int m_Stride;
+
+	void Run() override
+	{
+		m_pServer->EncodeSnapshots(m_Start, m_Stride);
+	}
+
+public:
+	CSnapshotEncodeJob(CServer *pServer, int Start, int Stride) :
+		m_pServer(pServer),
+		m_Start(Start),
+		m_Stride(Stride)
+	{
+	}
+};
+
+void CServer::UpdateSnapshotJobPool()
+{
+	const int Threads = Config()->m_SvSnapshotThreads;
+	if(Threads == m_SnapshotJobPoolThreads && !m_vSnapshotEncodings.empty())
+		return;
+
+	if(m_SnapshotJobPoolThreads > 0)
+	{
+		m_SnapshotJobPool.Shutdown();
+		sphore_destroy(&m_SnapshotJobsDone);
+	}
+
+	// The tick thread encodes a share of the snapshots itself
+	m_SnapshotJobPoolThreads = Threads;
+	if(m_SnapshotJobPoolThreads > 0)
+	{
+		sphore_init(&m_SnapshotJobsDone);
+		m_SnapshotJobPool.Init(m_SnapshotJobPoolThreads);
+	}
+
+	m_vSnapshotEncodings.resize(m_SnapshotJobPoolThreads > 0 ? MAX_CLIENTS : 1);
+}
+
+void CServer::BuildSnapshot(int ClientId, CSnapshotEncoding *pEncoding)
+{
+	CProfileScope ProfileScope(m_ProfileZones.m_pSnapshotBuild);
+	CClient &Client = m_aClients[ClientId];
+
+	m_SnapshotBuilder.Init(Client.m_Sixup);
+
+	GameServer()->OnSnap(ClientId);
+
+	// finish snapshot
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
+	int SnapshotSize = m_SnapshotBuilder.Finish(pData);
+
+	if(m_aDemoRecorder[ClientId].IsRecording())
+	{
+		// write snapshot
+		m_aDemoRecorder[ClientId].RecordSnapshot(Tick(), aData, SnapshotSize);
+	}
+
+	pEncoding->m_Crc = pData->Crc();
+	pEncoding->m_Sixup = Client.m_Sixup;
+
+	// remove old snapshots
+	// keep 3 seconds worth of snapshots
+	Client.m_Snapshots.PurgeUntil(m_CurrentGameTick - SERVER_TICK_SPEED * 3);
+
+	// save the snapshot
+	Client.m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0, nullptr);
+	// the stored copy stays valid until the next purge of this client
+	pEncoding->m_pSnapshot = Client.m_Snapshots.m_pLast->m_pSnap;
+
+	// find snapshot that we can perform delta against
+	pEncoding->m_DeltaTick = -1;
+	pEncoding->m_pDeltashot = CSnapshot::EmptySnapshot();
+	{
+		int DeltashotSize = Client.m_Snapshots.Get(Client.m_LastAckedSnapshot, 0, &pEncoding->m_pDeltashot, 0);
+		if(DeltashotSize >= 0)
+			pEncoding->m_DeltaTick = Client.m_LastAckedSnapshot;
+		else
+		{
+			// no acked package found, force client to recover rate
+			if(Client.m_SnapRate == CClient::SNAPRATE_FULL)
+				Client.m_SnapRate = CClient::SNAPRATE_RECOVER;
+		}
+	}
+}
+
+void CServer::EncodeSnapshot(CSnapshotEncoding *pEncoding) const
+{
+	// create delta
+	const CSnapshotDelta &SnapshotDelta = pEncoding->m_Sixup ? m_SnapshotDeltaSixup : m_SnapshotDelta;
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	int DeltaSize;
+	{
+		CProfileScope ProfileScope(m_ProfileZones.m_pSnapshotDelta);
+		DeltaSize = SnapshotDelta.CreateDelta(pEncoding->m_pDeltashot, pEncoding->m_pSnapshot, aDeltaData);
+	}
+
+	pEncoding->m_CompressedSize = 0;
+	if(DeltaSize)
+	{
+		// compress it
+		CProfileScope ProfileScope(m_ProfileZones.m_pSnapshotCompress);
+		pEncoding->m_CompressedSize = CVariableInt::Compress(aDeltaData, DeltaSize, pEncoding->m_aCompressedData, sizeof(pEncoding->m_aCompressedData));
+	}
+}
+
+void CServer::EncodeSnapshots(int Start, int Stride)
+{
+	for(std::size_t i = Start; i < m_vSnapshotClients.size(); i += Stride)
+	{
+		EncodeSnapshot(&m_vSnapshotEncodings[m_vSnapshotClients[i]]);
+	}
+
+	if(Start > 0)
+	{
+		sphore_signal(&m_SnapshotJobsDone);
+	}
+}
+
+void CServer::SendSnapshot(int ClientId, const CSnapshotEncoding &Encoding)
+{
+	CProfileScope ProfileScope(m_ProfileZones.m_pSnapshotSend);
+	if(Encoding.m_CompressedSize)
+	{
+		const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		const int SnapshotSize = Encoding.m_CompressedSize;
+		int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+		for(int n = 0, Left = SnapshotSize; Left > 0; n++)
+		{
+			int Chunk = Left < MaxSize ? Left : MaxSize;
+			Left -= Chunk;
+
+			if(NumPackets == 1)
+			{
+				CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - Encoding.m_DeltaTick);
+				Msg.AddInt(Encoding.m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&Encoding.m_aCompressedData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+			}
+			else
+			{
+				CMsgPacker Msg(NETMSG_SNAP, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - Encoding.m_DeltaTick);
+				Msg.AddInt(NumPackets);
+				Msg.AddInt(n);
+				Msg.AddInt(Encoding.m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&Encoding.m_aCompressedData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+			}
+		}
+	}
+	else
+	{
+		CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+		Msg.AddInt(m_CurrentGameTick);
+		Msg.AddInt(m_CurrentGameTick - Encoding.m_DeltaTick);
+		SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+	}
+}
+
 void CServer::DoSnapshot()
 {
+	CProfileScope ProfileScope(m_ProfileZones.m_pSnapshot);
 	GameServer()->OnPreSnap();
 
+	UpdateSnapshotJobPool();
+	const bool Parallel = m_SnapshotJobPoolThreads > 0;
+
 	// create snapshot for demo recording
 	if(m_aDemoRecorder[MAX_CLIENTS].IsRecording())
 	{
 		char aData[CSnapshot::MAX_SIZE];
 
 		// build snap and possibly add some messages
-		m_SnapshotBuilder.Init();
-		GameServer()->OnSnap(-1);
-		int SnapshotSize = m_SnapshotBuilder.Finish(aData);
+		int SnapshotSize;
+		{
+			CProfileScope BuildScope(m_ProfileZones.m_pSnapshotBuild);
+			m_SnapshotBuilder.Init();
+			GameServer()->OnSnap(-1);
+			SnapshotSize = m_SnapshotBuilder.Finish(aData);
+		}
 
 		// write snapshot
 		m_aDemoRecorder[MAX_CLIENTS].RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	// Snap() of the game entities is not thread-safe, so the snapshots are
+	// always built here. Only the delta encoding and the compression are
+	// spread over the snapshot job pool when it is enabled.
+	m_vSnapshotClients.clear();
+
 	// create snapshots for all clients
 	for(int i = 0; i < MaxClients(); i++)
 	{
@@ -1126,97 +1405,37 @@ void CServer::DoSnapshot()
 		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick() % 10) != 0)
 			continue;
 
-		{
-			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
-
-			GameServer()->OnSnap(i);
-
-			// finish snapshot
-			char aData[CSnapshot::MAX_SIZE];
-			CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
-			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
-
-			if(m_aDemoRecorder[i].IsRecording())
-			{
-				// write snapshot
-				m_aDemoRecorder[i].RecordSnapshot(Tick(), aData, SnapshotSize);
-			}
-
-			int Crc = pData->Crc();
-
-			// remove old snapshots
-			// keep 3 seconds worth of snapshots
-			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick - SERVER_TICK_SPEED * 3);
-
-			// save the snapshot
-			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0, nullptr);
-
-			// find snapshot that we can perform delta against
-			int DeltaTick = -1;
-			const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
-			{
-				int DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, 0, &pDeltashot, 0);
-				if(DeltashotSize >= 0)
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				else
-				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
-				}
-			}
-
-			// create delta
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+		CSnapshotEncoding *pEncoding = &m_vSnapshotEncodings[Parallel ? i : 0];
+		BuildSnapshot(i, pEncoding);
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
-
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+		if(Parallel)
+		{
+			m_vSnapshotClients.push_back(i);
+		}
+		else
+		{
+			EncodeSnapshot(pEncoding);
+			SendSnapshot(i, *pEncoding);
+		}
+	}
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+	if(!m_vSnapshotClients.empty())
+	{
+		const int NumJobs = minimum<int>(m_SnapshotJobPoolThreads + 1, m_vSnapshotClients.size());
+		for(int Job = 1; Job < NumJobs; Job++)
+		{
+			m_SnapshotJobPool.Add(std::make_shared<CSnapshotEncodeJob>(this, Job, NumJobs));
+		}
+		EncodeSnapshots(0, NumJobs);
+		for(int Job = 1; Job < NumJobs; Job++)
+		{
+			sphore_wait(&m_SnapshotJobsDone);
+		}
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
-			}
-			else
-			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
-			}
+		// sending goes through the network and demo recorders, keep it serialized
+		for(int ClientId : m_vSnapshotClients)
+		{
+			SendSnapshot(ClientId, m_vSnapshotEncodings[ClientId]);
 		}
 	}
 
@@ -1600,63 +1819,95 @@ static inline int MsgFromSixup(int Msg, bool System)
 	return Msg;
 }
 
-bool CServer::GenerateClientMap(const char *pMapFilePath, const char *pMapName)
+static bool IsSeparator(char c) { return c == ';' || c == ' ' || c == ',' || c == '\t'; }
+
+bool CServer::LoadClientMap(IStorage *pStorage, IConsole *pConsole, IEngineMap *pMap, CClientMapCache *pCache, const char *pMapFilePath, const char *pMapName, const char *pConverterId, const char *pEvent, bool ForceRegeneration, unsigned *pServerMapCrc, CClientMapInfo *pInfo)
 {
-	if(!m_pMap->Load(pMapFilePath))
-		return 0;
+	if(!pMap->Load(pStorage, pMapFilePath, true))
+		return false;
 
 	//The map format of InfectionClass is different from the vanilla format.
 	//We need to convert the map to something that the client can use
 	//First, try to find if the client map is already generated
 
-	CDataFileReader dfServerMap;
-	dfServerMap.Open(Storage(), pMapFilePath, IStorage::TYPE_ALL);
-	unsigned ServerMapCrc = dfServerMap.Crc();
-	dfServerMap.Close();
+	const unsigned ServerMapCrc = pMap->Crc();
+	*pServerMapCrc = ServerMapCrc;
+
+	EventsDirector::SetPreloadedMapName(pMapName, pEvent);
+	pConverterId = EventsDirector::GetMapConverterId(pConverterId, pEvent);
+	const std::pair<unsigned, std::string> Key(ServerMapCrc, pConverterId);
 
-	EventsDirector::SetPreloadedMapName(pMapName);
+	if(!ForceRegeneration)
+	{
+		const CLockScope LockScope(pCache->m_Lock);
+		auto It = pCache->m_Maps.find(Key);
+		if(It != pCache->m_Maps.end())
+		{
+			*pInfo = It->second;
+			return true;
+		}
+	}
 
 	char aClientMapDir[256];
-	char aClientMapName[256];
-	const char *pConverterId = Config()->m_InfConverterId;
-	pConverterId = EventsDirector::GetMapConverterId(pConverterId);
 	str_format(aClientMapDir, sizeof(aClientMapDir), "clientmaps/%s", pConverterId);
-	str_format(aClientMapName, sizeof(aClientMapName), "%s/%s_%08x.map", aClientMapDir, pMapName, ServerMapCrc);
+	str_format(pInfo->m_aPath, sizeof(pInfo->m_aPath), "%s/%s_%08x.map", aClientMapDir, pMapName, ServerMapCrc);
 
-	CMapConverter MapConverter(Storage(), m_pMap, Console());
+	CMapConverter MapConverter(pStorage, pMap, pConsole);
 	if(!MapConverter.Load())
 		return false;
 
-	m_TimeShiftUnit = MapConverter.GetTimeShiftUnit();
+	pInfo->m_TimeShiftUnit = MapConverter.GetTimeShiftUnit();
 
 	CDataFileReader dfClientMap;
 	//The map is already converted
-	if(!Config()->m_InfConverterForceRegeneration && dfClientMap.Open(Storage(), aClientMapName, IStorage::TYPE_ALL))
+	if(!ForceRegeneration && dfClientMap.Open(pStorage, pInfo->m_aPath, IStorage::TYPE_ALL, false, true))
 	{
-		m_aCurrentMapCrc[MAP_TYPE_SIX] = dfClientMap.Crc();
-		m_aCurrentMapSha256[MAP_TYPE_SIX] = dfClientMap.Sha256();
+		pInfo->m_Crc = dfClientMap.Crc();
+		pInfo->m_Sha256 = dfClientMap.Sha256();
 		dfClientMap.Close();
 	}
 	//The map must be converted
 	else
 	{
 		char aFullPath[512];
-		Storage()->GetCompletePath(IStorage::TYPE_SAVE, aClientMapDir, aFullPath, sizeof(aFullPath));
+		pStorage->GetCompletePath(IStorage::TYPE_SAVE, aClientMapDir, aFullPath, sizeof(aFullPath));
 		if(fs_makedir_rec_for(aFullPath) != 0 || fs_makedir(aFullPath) != 0)
 		{
 			dbg_msg("infclass", "Can't create the directory '%s'", aClientMapDir);
 		}
 
-		if(!MapConverter.CreateMap(aClientMapName))
+		if(!MapConverter.CreateMap(pInfo->m_aPath))
 			return false;
 
 		CDataFileReader dfGeneratedMap;
-		dfGeneratedMap.Open(Storage(), aClientMapName, IStorage::TYPE_ALL);
-		m_aCurrentMapCrc[MAP_TYPE_SIX] = dfGeneratedMap.Crc();
-		m_aCurrentMapSha256[MAP_TYPE_SIX] = dfGeneratedMap.Sha256();
+		if(!dfGeneratedMap.Open(pStorage, pInfo->m_aPath, IStorage::TYPE_ALL, false, true))
+			return false;
+		pInfo->m_Crc = dfGeneratedMap.Crc();
+		pInfo->m_Sha256 = dfGeneratedMap.Sha256();
 		dfGeneratedMap.Close();
 	}
 
+	const CLockScope LockScope(pCache->m_Lock);
+	pCache->m_Maps[Key] = *pInfo;
+	return true;
+}
+
+bool CServer::GenerateClientMap(const char *pMapFilePath, const char *pMapName)
+{
+	// the client map file is rewritten in place, it must not be mapped anymore
+	if(Config()->m_InfConverterForceRegeneration)
+		FreeCurrentMapData(MAP_TYPE_SIX);
+
+	unsigned ServerMapCrc = 0;
+	CClientMapInfo Info;
+	if(!LoadClientMap(Storage(), Console(), m_pMap, m_pClientMapCache.get(), pMapFilePath, pMapName,
+		   Config()->m_InfConverterId, Config()->m_InfEvent, Config()->m_InfConverterForceRegeneration, &ServerMapCrc, &Info))
+		return false;
+
+	m_TimeShiftUnit = Info.m_TimeShiftUnit;
+	m_aCurrentMapCrc[MAP_TYPE_SIX] = Info.m_Crc;
+	m_aCurrentMapSha256[MAP_TYPE_SIX] = Info.m_Sha256;
+
 	char aBufMsg[128];
 	char aSha256[SHA256_MAXSTRSIZE];
 	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aSha256, sizeof(aSha256));
@@ -1665,17 +1916,187 @@ bool CServer::GenerateClientMap(const char *pMapFilePath, const char *pMapName)
 	str_format(aBufMsg, sizeof(aBufMsg), "map crc is %08x, generated map crc is %08x", ServerMapCrc, m_aCurrentMapCrc[MAP_TYPE_SIX]);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
-	// load complete map into memory for download
+	// with sv_map_mmap the client map is mapped for download, its pages are
+	// then read on demand when a client downloads it. A mapped file must
+	// not be rewritten in place, so it is copied by default.
 	{
-		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aClientMapName, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
+		FreeCurrentMapData(MAP_TYPE_SIX);
+		void *pData = nullptr;
+		IOHANDLE File = Storage()->OpenFile(Info.m_aPath, IOFLAG_READ, IStorage::TYPE_ALL);
+		if(File)
+		{
+			if(Config()->m_SvMapMmap)
+				pData = io_map(File, &m_aCurrentMapSize[MAP_TYPE_SIX]);
+			if(pData)
+				m_aCurrentMapDataMapped[MAP_TYPE_SIX] = true;
+			else
+				io_read_all(File, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
+			io_close(File);
+		}
 		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
 	}
 
 	return true;
 }
 
+void CServer::FreeCurrentMapData(int MapType)
+{
+	if(m_aCurrentMapDataMapped[MapType])
+		io_unmap(m_apCurrentMapData[MapType], m_aCurrentMapSize[MapType]);
+	else
+		free(m_apCurrentMapData[MapType]);
+	m_apCurrentMapData[MapType] = nullptr;
+	m_aCurrentMapSize[MapType] = 0;
+	m_aCurrentMapDataMapped[MapType] = false;
+}
+
+// Converts the client map of a server map on a job thread, with its own
+// engine map so the running game is not touched
+class CServer::CClientMapJob : public IJob
+{
+	IStorage *m_pStorage;
+	IConsole *m_pConsole;
+	std::shared_ptr<CClientMapCache> m_pCache;
+	std::string m_RequestKey;
+	std::vector<std::string> m_vMapFileNames;
+	std::string m_ConverterId;
+	std::string m_Event;
+
+	void Run() override
+	{
+		std::unique_ptr<IEngineMap> pMap(CreateEngineMap());
+		for(const std::string &MapFileName : m_vMapFileNames)
+		{
+			char aPath[IO_MAX_PATH_LENGTH];
+			str_format(aPath, sizeof(aPath), "maps/%s.map", MapFileName.c_str());
+			unsigned ServerMapCrc;
+			CClientMapInfo Info;
+			if(LoadClientMap(m_pStorage, m_pConsole, pMap.get(), m_pCache.get(), aPath, MapFileName.c_str(), m_ConverterId.c_str(), m_Event.c_str(), false, &ServerMapCrc, &Info))
+				break;
+		}
+
+		const CLockScope LockScope(m_pCache->m_Lock);
+		m_pCache->m_Requests[m_RequestKey] = true;
+	}
+
+public:
+	CClientMapJob(IStorage *pStorage, IConsole *pConsole, std::shared_ptr<CClientMapCache> pCache, const char *pRequestKey, std::vector<std::string> &&vMapFileNames, const char *pConverterId, const char *pEvent) :
+		m_pStorage(pStorage),
+		m_pConsole(pConsole),
+		m_pCache(std::move(pCache)),
+		m_RequestKey(pRequestKey),
+		m_vMapFileNames(std::move(vMapFileNames)),
+		m_ConverterId(pConverterId),
+		m_Event(pEvent)
+	{
+	}
+};
+
+void CServer::ClientMapRequestKey(const char *pMapName, unsigned ServerMapCrc, char *pBuf, int BufSize) const
+{
+	// Everything the generated map depends on
+	str_format(pBuf, BufSize, "%s/%08x/%s/%s", pMapName, ServerMapCrc, Config()->m_InfConverterId, Config()->m_InfEvent);
+}
+
+bool CServer::FindServerMapCrc(const char *pMapName, unsigned *pCrc)
+{
+	// Same candidates as in LoadMap(), the hashes of a loaded or converted
+	// map are remembered so the file is not read again
+	const char *pEventMapName = EventsDirector::GetEventMapName(pMapName);
+	for(const char *pMapFileName : {pEventMapName, pMapName})
+	{
+		if(!pMapFileName)
+			continue;
+
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "maps/%s.map", pMapFileName);
+		CFileHash Hash;
+		if(Hash.Compute(Storage(), aPath, IStorage::TYPE_ALL, true))
+		{
+			*pCrc = Hash.m_Crc;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CServer::QueueClientMapConversion(const char *pMapName)
+{
+	unsigned ServerMapCrc;
+	if(!FindServerMapCrc(pMapName, &ServerMapCrc))
+		return;
+
+	char aKey[256];
+	ClientMapRequestKey(pMapName, ServerMapCrc, aKey, sizeof(aKey));
+	{
+		const CLockScope LockScope(m_pClientMapCache->m_Lock);
+		if(m_pClientMapCache->m_Requests.count(aKey))
+			return;
+		m_pClientMapCache->m_Requests[aKey] = false;
+	}
+
+	// Same candidates as in LoadMap()
+	std::vector<std::string> vMapFileNames;
+	const char *pEventMapName = EventsDirector::GetEventMapName(pMapName);
+	if(pEventMapName)
+		vMapFileNames.emplace_back(pEventMapName);
+	vMapFileNames.emplace_back(pMapName);
+
+	Kernel()->RequestInterface<IEngine>()->AddJob(std::make_shared<CClientMapJob>(
+		Storage(), Console(), m_pClientMapCache, aKey, std::move(vMapFileNames), Config()->m_InfConverterId, Config()->m_InfEvent));
+}
+
+void CServer::PreconvertClientMaps()
+{
+	if(Config()->m_InfConverterForceRegeneration)
+		return;
+
+	const char *pNextMap = Config()->m_SvMaprotation;
+	char aMapName[128];
+	while(*pNextMap)
+	{
+		while(*pNextMap && IsSeparator(*pNextMap))
+			pNextMap++;
+
+		int Length = 0;
+		while(pNextMap[Length] && !IsSeparator(pNextMap[Length]))
+			Length++;
+		if(!Length)
+			break;
+
+		str_truncate(aMapName, sizeof(aMapName), pNextMap, Length);
+		pNextMap += Length;
+		if(str_startswith(aMapName, "infc_"))
+			QueueClientMapConversion(aMapName);
+	}
+}
+
+bool CServer::ClientMapReady(const char *pMapName)
+{
+	if(!str_startswith(pMapName, "infc_") || Config()->m_InfConverterForceRegeneration)
+		return true;
+
+	// LoadMap() reports the missing map
+	unsigned ServerMapCrc;
+	if(!FindServerMapCrc(pMapName, &ServerMapCrc))
+		return true;
+
+	char aKey[256];
+	ClientMapRequestKey(pMapName, ServerMapCrc, aKey, sizeof(aKey));
+	{
+		const CLockScope LockScope(m_pClientMapCache->m_Lock);
+		auto It = m_pClientMapCache->m_Requests.find(aKey);
+		if(It != m_pClientMapCache->m_Requests.end())
+			return It->second;
+	}
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "converting map '%s' in the background, the map change is delayed", pMapName);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	QueueClientMapConversion(pMapName);
+	return false;
+}
+
 void CServer::ProcessClientPacket(CNetChunk *pPacket)
 {
 	int ClientId = pPacket->m_ClientId;
@@ -1864,12 +2285,13 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			if(m_aClients[ClientId].m_Snapshots.Get(m_aClients[ClientId].m_LastAckedSnapshot, &TagTime, 0, 0) >= 0)
 				m_aClients[ClientId].m_Latency = (int)(((time_get() - TagTime) * 1000) / time_freq());
 
+			const int TimeLeft = (TickStartTime(IntendedTick) - time_get()) / (time_freq() / 1000);
+			m_aClients[ClientId].m_InputTiming.Add(TimeLeft, IntendedTick <= Tick());
+
 			// add message to report the input timing
 			// skip packets that are old
 			if(IntendedTick > m_aClients[ClientId].m_LastInputTick)
 			{
-				const int TimeLeft = (TickStartTime(IntendedTick) - time_get()) / (time_freq() / 1000);
-
 				CMsgPacker Msgp(NETMSG_INPUTTIMING, true);
 				Msgp.AddInt(IntendedTick);
 				Msgp.AddInt(TimeLeft);
@@ -1878,12 +2300,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 			m_aClients[ClientId].m_LastInputTick = IntendedTick;
 
-			CClient::CInput *pInput = &m_aClients[ClientId].m_aInputs[m_aClients[ClientId].m_CurrentInput];
-
-			if(IntendedTick <= Tick())
-				IntendedTick = Tick() + 1;
-
-			pInput->m_GameTick = IntendedTick;
+			CClient::CInput *pInput = m_aClients[ClientId].AddInput(CClient::InputTick(IntendedTick, Tick()));
 
 			for(int i = 0; i < Size / 4; i++)
 				pInput->m_aData[i] = Unpacker.GetInt();
@@ -1891,9 +2308,6 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			GameServer()->OnClientPrepareInput(ClientId, pInput->m_aData);
 			mem_copy(m_aClients[ClientId].m_LatestInput.m_aData, pInput->m_aData, MAX_INPUT_SIZE * sizeof(int));
 
-			m_aClients[ClientId].m_CurrentInput++;
-			m_aClients[ClientId].m_CurrentInput %= 200;
-
 			// call the mod with the fresh input data
 			if(m_aClients[ClientId].m_State == CClient::STATE_INGAME)
 				GameServer()->OnClientDirectInput(ClientId, m_aClients[ClientId].m_LatestInput.m_aData);
@@ -2699,6 +3113,7 @@ void CServer::UpdateServerInfo(bool Resend)
 
 void CServer::PumpNetwork(bool PacketWaiting)
 {
+	CProfileScope ProfileScope(m_ProfileZones.m_pPumpNetwork);
 	CNetChunk Packet;
 	SECURITY_TOKEN ResponseToken;
 
@@ -2834,6 +3249,13 @@ int CServer::LoadMap(const char *pMapName)
 
 	str_format(aBuf, sizeof(aBuf), "map_loaded name='%s' file='maps/%s.map'", pMapName, pLoadedMapFileName);
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+
+	{
+		char aKey[256];
+		ClientMapRequestKey(pMapName, m_pMap->Crc(), aKey, sizeof(aKey));
+		const CLockScope LockScope(m_pClientMapCache->m_Lock);
+		m_pClientMapCache->m_Requests[aKey] = true;
+	}
 /* INFECTION MODIFICATION END *****************************************/
 
 	// stop recording when we change map
@@ -2869,8 +3291,6 @@ int CServer::LoadMap(const char *pMapName)
 	return 1;
 }
 
-static bool IsSeparator(char c) { return c == ';' || c == ' ' || c == ',' || c == '\t'; }
-
 int CServer::Run()
 {
 	if(m_RunServer == UNINITIALIZED)
@@ -2999,6 +3419,7 @@ int CServer::Run()
 	}
 
 	IEngine *pEngine = Kernel()->RequestInterface<IEngine>();
+	PreconvertClientMaps();
 	m_pRegister = CreateRegister(&g_Config, m_pConsole, pEngine, &m_Http, this->Port(), m_NetServer.GetGlobalToken());
 
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
@@ -3054,7 +3475,9 @@ int CServer::Run()
 #endif
 
 			// load new map TODO: don't poll this
-			if(str_comp(g_Config.m_SvMap, m_aCurrentMap) != 0 || m_MapReload || m_CurrentGameTick >= MAX_TICK) // force reload to make sure the ticks stay within a valid range
+			// the current map is kept until the client map of the new one is converted
+			if((str_comp(g_Config.m_SvMap, m_aCurrentMap) != 0 || m_MapReload || m_CurrentGameTick >= MAX_TICK) && // force reload to make sure the ticks stay within a valid range
+				ClientMapReady(Config()->m_SvMap))
 			{
 				// load map
 				if(LoadMap(Config()->m_SvMap))
@@ -3119,18 +3542,20 @@ int CServer::Run()
 
 			while(t > TickStartTime(m_CurrentGameTick+1))
 			{
+				// one profiler sample per game tick, also while catching up.
+				// The last tick of the loop ends after the snapshot.
+				if(NewTicks)
+					CProfiler::EndTick();
+
 				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
 					if(m_aClients[c].m_State != CClient::STATE_INGAME)
 						continue;
 					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
+					for(CClient::CInput *pInput = m_aClients[c].FirstInput(Tick() + 1); pInput; pInput = m_aClients[c].NextInput(pInput))
 					{
-						if(Input.m_GameTick == Tick() + 1)
-						{
-							GameServer()->OnClientPredictedEarlyInput(c, Input.m_aData);
-							ClientHadInput = true;
-						}
+						GameServer()->OnClientPredictedEarlyInput(c, pInput->m_aData);
+						ClientHadInput = true;
 					}
 					if(!ClientHadInput)
 						GameServer()->OnClientPredictedEarlyInput(c, nullptr);
@@ -3178,21 +3603,15 @@ int CServer::Run()
 				{
 					if(m_aClients[c].m_State != CClient::STATE_INGAME)
 						continue;
-					bool ClientHadInput = false;
-					for(auto &Input : m_aClients[c].m_aInputs)
-					{
-						if(Input.m_GameTick == Tick())
-						{
-							GameServer()->OnClientPredictedInput(c, Input.m_aData);
-							ClientHadInput = true;
-							break;
-						}
-					}
-					if(!ClientHadInput)
-						GameServer()->OnClientPredictedInput(c, nullptr);
+					// the first input received for the tick
+					CClient::CInput *pInput = m_aClients[c].FirstInput(Tick());
+					GameServer()->OnClientPredictedInput(c, pInput ? pInput->m_aData : nullptr);
 				}
 
-				GameServer()->OnTick();
+				{
+					CProfileScope ProfileScope(m_ProfileZones.m_pGameTick);
+					GameServer()->OnTick();
+				}
 				
 #ifdef CONF_SQL
 				if(m_lGameServerCmds.size())
@@ -3219,7 +3638,29 @@ int CServer::Run()
 				if(Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0)
 					DoSnapshot();
 
+				CProfiler::EndTick();
+				if(CProfiler::IsEnabled() && Config()->m_SvProfileEconInterval && t >= m_NextProfileReport)
+				{
+					SendProfileReport();
+					m_NextProfileReport = t + Config()->m_SvProfileEconInterval * time_freq();
+				}
+
 				UpdateClientRconCommands();
+
+				// the game tick starts over on map change
+				const int NetStatsTicks = m_CurrentGameTick - m_NetStatsStartTick;
+				if(NetStatsTicks >= TickSpeed() || NetStatsTicks < 0)
+				{
+					NETSTATS NetStats;
+					net_stats(&NetStats);
+					if(NetStatsTicks > 0)
+					{
+						m_SendCallsPerTick = (NetStats.send_calls - m_NetStatsStart.send_calls) / (float)NetStatsTicks;
+						m_SentPacketsPerTick = (NetStats.sent_packets - m_NetStatsStart.sent_packets) / (float)NetStatsTicks;
+					}
+					m_NetStatsStart = NetStats;
+					m_NetStatsStartTick = m_CurrentGameTick;
+				}
 			}
 
 			// master server stuff
@@ -3242,6 +3683,8 @@ int CServer::Run()
 				}
 			}
 
+			m_NetServer.Flush();
+
 			NonActive = true;
 			for(const auto &Client : m_aClients)
 			{
@@ -3313,6 +3756,13 @@ int CServer::Run()
 	m_pRegister->OnShutdown();
 	m_Econ.Shutdown();
 
+	if(m_SnapshotJobPoolThreads > 0)
+	{
+		m_SnapshotJobPool.Shutdown();
+		sphore_destroy(&m_SnapshotJobsDone);
+		m_SnapshotJobPoolThreads = 0;
+	}
+
 	GameServer()->OnShutdown();
 	m_pMap->Unload();
 
@@ -3644,6 +4094,135 @@ void CServer::ConLogout(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConSnapshotStorageStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+
+	int64_t ArenaSize = 0;
+	for(const CClient &Client : pServer->m_aClients)
+		ArenaSize += Client.m_Snapshots.ArenaSize();
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "snapshot storage: %lld KiB in arenas, %lld allocations since start",
+		(long long)(ArenaSize / 1024), (long long)CSnapshotStorage::NumAllocations());
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
+void CServer::ConDemoRecorderStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+
+	int NumRecording = 0;
+	for(auto &Recorder : pServer->m_aDemoRecorder)
+	{
+		if(!Recorder.IsRecording())
+			continue;
+
+		char aBuf[512];
+		str_format(aBuf, sizeof(aBuf), "'%s': %d frames queued, %d at most, %d dropped",
+			Recorder.GetCurrentFilename(), Recorder.QueueDepth(), Recorder.MaxQueueDepth(), Recorder.NumDroppedFrames());
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		NumRecording++;
+	}
+	if(!NumRecording)
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "no demo is being recorded");
+}
+
+void CServer::ConInputTimingStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+
+	int NumClients = 0;
+	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+	{
+		const CClient &Client = pServer->m_aClients[ClientId];
+		if(Client.m_State != CClient::STATE_INGAME || Client.m_IsBot)
+			continue;
+
+		const CClient::CInputTiming &Timing = Client.m_InputTiming;
+		char aBuf[256];
+		if(Timing.m_NumInputs)
+		{
+			str_format(aBuf, sizeof(aBuf), "id=%d name='%s' inputs=%d late=%d (%.1f%%) time left min=%dms avg=%.1fms max=%dms",
+				ClientId, pServer->ClientName(ClientId), Timing.m_NumInputs, Timing.m_NumLate, Timing.m_NumLate * 100.0f / Timing.m_NumInputs,
+				Timing.m_MinTimeLeft, (double)Timing.m_SumTimeLeft / Timing.m_NumInputs, Timing.m_MaxTimeLeft);
+		}
+		else
+		{
+			str_format(aBuf, sizeof(aBuf), "id=%d name='%s' inputs=0", ClientId, pServer->ClientName(ClientId));
+		}
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		NumClients++;
+	}
+	if(!NumClients)
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "no player is in the game");
+
+	// start a new measurement
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+	{
+		for(CClient &Client : pServer->m_aClients)
+			Client.m_InputTiming.Reset();
+	}
+}
+
+void CServer::ConProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+
+	if(!CProfiler::IsEnabled())
+	{
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "the profiler is disabled, enable it with sv_profile 1");
+		return;
+	}
+
+	int NumZones = 0;
+	for(int i = 0; i < CProfiler::NumZones(); i++)
+	{
+		const CProfiler::CZone *pZone = CProfiler::GetZone(i);
+		CProfiler::CStats Stats;
+		if(!CProfiler::GetStats(pZone, &Stats))
+			continue;
+
+		char aBuf[256];
+		CProfiler::FormatStats(pZone, Stats, aBuf, sizeof(aBuf));
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", aBuf);
+		NumZones++;
+	}
+	if(!NumZones)
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profile", "no tick was measured yet");
+
+	// start a new measurement
+	if(pResult->NumArguments() && pResult->GetInteger(0))
+		CProfiler::Reset();
+}
+
+void CServer::SendProfileReport()
+{
+	for(int i = 0; i < CProfiler::NumZones(); i++)
+	{
+		const CProfiler::CZone *pZone = CProfiler::GetZone(i);
+		CProfiler::CStats Stats;
+		if(!CProfiler::GetStats(pZone, &Stats))
+			continue;
+
+		char aStats[256];
+		CProfiler::FormatStats(pZone, Stats, aStats, sizeof(aStats));
+		char aBuf[320];
+		str_format(aBuf, sizeof(aBuf), "profile: %s", aStats);
+		m_Econ.Send(-1, aBuf);
+	}
+}
+
+void CServer::ConNetSendStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "network sends: %.1f packets per tick in %.1f system calls per tick",
+		pServer->m_SentPacketsPerTick, pServer->m_SendCallsPerTick);
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
 void CServer::ConShowIps(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pServer = (CServer *)pUser;
@@ -3910,6 +4489,13 @@ void CServer::ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, ICo
 	}
 }
 
+void CServer::ConchainProfile(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	CServer *pThis = static_cast<CServer *>(pUserData);
+	CProfiler::SetEnabled(pThis->Config()->m_SvProfile);
+}
+
 void CServer::ConchainSixupUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -3982,6 +4568,11 @@ void CServer::RegisterCommands()
 	Console()->Register("shutdown2", "?r[reason]", CFGFLAG_SERVER, ConShutdown2, this, "Shut down and reconnect clients");
 	Console()->Register("logout", "", CFGFLAG_SERVER, ConLogout, this, "Logout of rcon");
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
+	Console()->Register("snapshot_storage_stats", "", CFGFLAG_SERVER, ConSnapshotStorageStats, this, "Show the memory used to keep the client snapshots");
+	Console()->Register("net_send_stats", "", CFGFLAG_SERVER, ConNetSendStats, this, "Show the packets and send system calls per tick");
+	Console()->Register("demo_recorder_stats", "", CFGFLAG_SERVER, ConDemoRecorderStats, this, "Show the write queues of the demos being recorded");
+	Console()->Register("input_timing_stats", "?i[reset]", CFGFLAG_SERVER, ConInputTimingStats, this, "Show how early the inputs of the players arrive (1 = reset afterwards)");
+	Console()->Register("profile", "?i[reset]", CFGFLAG_SERVER, ConProfile, this, "Show the time spent in the parts of the tick, see sv_profile (1 = reset afterwards)");
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
@@ -4000,6 +4591,7 @@ void CServer::RegisterCommands()
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
+	Console()->Chain("sv_profile", ConchainProfile, this);
 	Console()->Chain("mod_command", ConchainModCommandUpdate, this);
 
 	Console()->Chain("sv_map", ConchainMapUpdate, this);
@@ -4046,12 +4638,69 @@ void CServer::SnapFreeId(int Id)
 void *CServer::SnapNewItem(int Type, int Id, int Size)
 {
 	dbg_assert(Id >= -1 && Id <= 0xffff, "incorrect id");
-	return Id < 0 ? 0 : m_SnapshotBuilder.NewItem(Type, Id, Size);
+	if(Id < 0)
+		return 0;
+
+	void *pData = m_SnapshotBuilder.NewItem(Type, Id, Size);
+	if(pData && m_SnapRecording)
+		m_vRecordedSnapItems.push_back({Type, Id, Size, pData});
+	return pData;
+}
+
+void CServer::SnapStartRecording()
+{
+	dbg_assert(!m_SnapRecording, "snap recordings can not be nested");
+	m_SnapRecording = true;
+	m_vRecordedSnapItems.clear();
+}
+
+void CServer::SnapStopRecording(std::vector<int> *pvRecording)
+{
+	dbg_assert(m_SnapRecording, "no snap recording to stop");
+	m_SnapRecording = false;
+
+	// Layout: type, id, size in bytes followed by the item data, per item
+	pvRecording->clear();
+	for(const CRecordedSnapItem &Item : m_vRecordedSnapItems)
+	{
+		pvRecording->push_back(Item.m_Type);
+		pvRecording->push_back(Item.m_Id);
+		pvRecording->push_back(Item.m_Size);
+		const int *pData = static_cast<const int *>(Item.m_pData);
+		pvRecording->insert(pvRecording->end(), pData, pData + Item.m_Size / sizeof(int));
+	}
+	m_vRecordedSnapItems.clear();
+}
+
+bool CServer::SnapReplayItems(const std::vector<int> &vRecording)
+{
+	std::size_t Offset = 0;
+	while(Offset + 3 <= vRecording.size())
+	{
+		const int Type = vRecording[Offset];
+		const int Id = vRecording[Offset + 1];
+		const int Size = vRecording[Offset + 2];
+		Offset += 3;
+
+		void *pData = SnapNewItem(Type, Id, Size);
+		if(!pData)
+			return false;
+		mem_copy(pData, &vRecording[Offset], Size);
+		Offset += Size / sizeof(int);
+	}
+	return true;
 }
 
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	m_SnapshotDeltaSixup.SetStaticsize(ItemType, Size);
+
+	// The 0.7 events have their size stripped from the delta only for 0.7 clients
+	m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, false);
+	m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, false);
+	m_SnapshotDeltaSixup.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, true);
+	m_SnapshotDeltaSixup.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, true);
 }
 
 int CServer::GetClientInfclassVersion(int ClientId) const
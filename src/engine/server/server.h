@@ -16,12 +16,18 @@
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/http.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/snapshot.h>
 #include <game/voting.h>
 
 #include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 /* DDNET MODIFICATION START *******************************************/
 #include "base/logger.h"
@@ -156,6 +162,27 @@ public:
 		public:
 			int m_aData[MAX_INPUT_SIZE];
 			int m_GameTick; // the tick that was chosen for the input
+			int m_NextInput; // the next input received for the same tick, -1 if none
+		};
+
+		// How long before the start of their tick the inputs arrived
+		class CInputTiming
+		{
+		public:
+			int m_NumInputs;
+			int m_NumLate; // arrived after their tick started, applied one tick later
+			int64_t m_SumTimeLeft;
+			int m_MinTimeLeft;
+			int m_MaxTimeLeft;
+
+			void Reset();
+			void Add(int TimeLeft, bool Late);
+		};
+
+		enum
+		{
+			NUM_INPUTS = 200,
+			INPUT_TICKS = 256,
 		};
 
 		// connection state info
@@ -173,8 +200,21 @@ public:
 		CSnapshotStorage m_Snapshots;
 
 		CInput m_LatestInput;
-		CInput m_aInputs[200]; // TODO: handle input better
+		CInput m_aInputs[NUM_INPUTS]; // the last inputs received, overwritten in order
 		int m_CurrentInput;
+		// The first and last inputs of m_aInputs for each tick, indexed by
+		// the tick modulo INPUT_TICKS
+		int m_aFirstInput[INPUT_TICKS];
+		int m_aLastInput[INPUT_TICKS];
+		CInputTiming m_InputTiming;
+
+		// The tick an input intended for IntendedTick is applied at: late
+		// inputs go to the next tick, and the pending ticks must not share a
+		// slot of the ring
+		static int InputTick(int IntendedTick, int CurrentTick);
+		CInput *AddInput(int GameTick);
+		CInput *FirstInput(int GameTick);
+		CInput *NextInput(const CInput *pInput) { return pInput->m_NextInput >= 0 ? &m_aInputs[pInput->m_NextInput] : nullptr; }
 
 		char m_aName[MAX_NAME_LENGTH];
 		char m_aClan[MAX_CLAN_LENGTH];
@@ -228,7 +268,56 @@ public:
 	int m_aIdMap[MAX_CLIENTS * VANILLA_MAX_CLIENTS];
 
 	CSnapshotDelta m_SnapshotDelta;
+	CSnapshotDelta m_SnapshotDeltaSixup;
 	CSnapshotBuilder m_SnapshotBuilder;
+
+	// Result of the delta encoding and compression of a client snapshot
+	class CSnapshotEncoding
+	{
+	public:
+		const CSnapshot *m_pSnapshot;
+		const CSnapshot *m_pDeltashot;
+		int m_DeltaTick;
+		int m_Crc;
+		bool m_Sixup;
+		int m_CompressedSize; // 0 for an empty delta
+		char m_aCompressedData[CSnapshot::MAX_SIZE];
+	};
+
+	// One encoding slot per client when the snapshots are encoded in
+	// parallel (sv_snapshot_threads), a single reused slot otherwise.
+	std::vector<CSnapshotEncoding> m_vSnapshotEncodings;
+	std::vector<int> m_vSnapshotClients;
+	CJobPool m_SnapshotJobPool;
+	int m_SnapshotJobPoolThreads = 0;
+	SEMAPHORE m_SnapshotJobsDone;
+
+	// Zones of the tick profiler, see sv_profile
+	class CProfileZones
+	{
+	public:
+		CProfiler::CZone *m_pPumpNetwork;
+		CProfiler::CZone *m_pGameTick;
+		CProfiler::CZone *m_pSnapshot;
+		CProfiler::CZone *m_pSnapshotBuild;
+		CProfiler::CZone *m_pSnapshotDelta;
+		CProfiler::CZone *m_pSnapshotCompress;
+		CProfiler::CZone *m_pSnapshotSend;
+	};
+	CProfileZones m_ProfileZones;
+	int64_t m_NextProfileReport = 0;
+
+	// Item added to the snapshot while a recording is active
+	class CRecordedSnapItem
+	{
+	public:
+		int m_Type;
+		int m_Id;
+		int m_Size;
+		const void *m_pData;
+	};
+	std::vector<CRecordedSnapItem> m_vRecordedSnapItems;
+	bool m_SnapRecording = false;
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -252,6 +341,13 @@ public:
 
 	bool m_MapReload;
 	bool m_ReloadedWhenEmpty;
+
+	// network sends per tick, measured over the last second
+	NETSTATS m_NetStatsStart;
+	int m_NetStatsStartTick;
+	float m_SendCallsPerTick;
+	float m_SentPacketsPerTick;
+
 	int m_RconClientId;
 	int m_RconAuthLevel;
 	char m_aShutdownReason[128];
@@ -279,6 +375,8 @@ public:
 	unsigned m_aCurrentMapCrc[NUM_MAP_TYPES];
 	unsigned char *m_apCurrentMapData[NUM_MAP_TYPES];
 	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
+	// the map data is a read-only mapping of the map file, not a heap copy
+	bool m_aCurrentMapDataMapped[NUM_MAP_TYPES];
 
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 
@@ -342,6 +440,12 @@ public:
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
 
 	void DoSnapshot();
+	void UpdateSnapshotJobPool();
+	void BuildSnapshot(int ClientId, CSnapshotEncoding *pEncoding);
+	void EncodeSnapshot(CSnapshotEncoding *pEncoding) const;
+	void EncodeSnapshots(int Start, int Stride);
+	void SendSnapshot(int ClientId, const CSnapshotEncoding &Encoding);
+	void SendProfileReport();
 
 	int NewBot(int ClientId) override;
 	int DelBot(int ClientId) override;
@@ -428,10 +532,16 @@ public:
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapshotStorageStats(IConsole::IResult *pResult, void *pUser);
+	static void ConNetSendStats(IConsole::IResult *pResult, void *pUser);
+	static void ConDemoRecorderStats(IConsole::IResult *pResult, void *pUser);
+	static void ConInputTimingStats(IConsole::IResult *pResult, void *pUser);
+	static void ConProfile(IConsole::IResult *pResult, void *pUser);
 
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainModCommandUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainProfile(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
 	static void ConMute(class IConsole::IResult *pResult, void *pUser);
 	static void ConUnmute(class IConsole::IResult *pResult, void *pUser);
@@ -469,6 +579,9 @@ public:
 	int SnapNewId() override;
 	void SnapFreeId(int Id) override;
 	void *SnapNewItem(int Type, int Id, int Size) override;
+	void SnapStartRecording() override;
+	void SnapStopRecording(std::vector<int> *pvRecording) override;
+	bool SnapReplayItems(const std::vector<int> &vRecording) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
 
 	// DDRace
@@ -540,7 +653,39 @@ public:
 	void Logout(int ClientId) override;
 #endif
 private:
+	// Client maps generated by the map converter, shared with the
+	// background conversion jobs
+	struct CClientMapInfo
+	{
+		char m_aPath[IO_MAX_PATH_LENGTH];
+		unsigned m_Crc;
+		SHA256_DIGEST m_Sha256;
+		int m_TimeShiftUnit;
+	};
+
+	class CClientMapCache
+	{
+	public:
+		CLock m_Lock;
+		// Keyed by the server map crc and the converter id
+		std::map<std::pair<unsigned, std::string>, CClientMapInfo> m_Maps GUARDED_BY(m_Lock);
+		// Requested conversions, keyed by the map name, the server map crc,
+		// the converter id and the event, true once the conversion is done
+		std::map<std::string, bool> m_Requests GUARDED_BY(m_Lock);
+	};
+
+	class CClientMapJob;
+
+	static bool LoadClientMap(IStorage *pStorage, IConsole *pConsole, IEngineMap *pMap, CClientMapCache *pCache, const char *pMapFilePath, const char *pMapName, const char *pConverterId, const char *pEvent, bool ForceRegeneration, unsigned *pServerMapCrc, CClientMapInfo *pInfo);
 	bool GenerateClientMap(const char *pMapFilePath, const char *pMapName);
+	void FreeCurrentMapData(int MapType);
+	void ClientMapRequestKey(const char *pMapName, unsigned ServerMapCrc, char *pBuf, int BufSize) const;
+	bool FindServerMapCrc(const char *pMapName, unsigned *pCrc);
+	void QueueClientMapConversion(const char *pMapName);
+	void PreconvertClientMaps();
+	bool ClientMapReady(const char *pMapName);
+
+	std::shared_ptr<CClientMapCache> m_pClientMapCache;
 	
 public:
 	class CGameServerCmd
@@ -42,6 +42,8 @@ MACRO_CONFIG_INT(SvDemoChat, sv_demo_chat, 0, 0, 1, CFGFLAG_SERVER, "Record chat
 MACRO_CONFIG_INT(SvServerInfoPerSecond, sv_server_info_per_second, 10, 1, 1000, CFGFLAG_SERVER, "Maximum number of complete server info responses that are sent out per second")
 MACRO_CONFIG_INT(SvVanConnPerSecond, sv_van_conn_per_second, 10, 0, 10000, CFGFLAG_SERVER, "Antispoof specific ratelimit (0 for no limit)")
 MACRO_CONFIG_INT(SvSixup, sv_sixup, 0, 0, 1, CFGFLAG_SERVER, "Enable sixup connections")
+MACRO_CONFIG_INT(SvProfile, sv_profile, 0, 0, 1, CFGFLAG_SERVER, "Measure the time spent in the parts of the tick, see the profile command")
+MACRO_CONFIG_INT(SvProfileEconInterval, sv_profile_econ_interval, 0, 0, 3600, CFGFLAG_SERVER, "Seconds between the profile reports sent to the external console (0 = never)")
 MACRO_CONFIG_INT(SvSkillLevel, sv_skill_level, 1, SERVERINFO_LEVEL_MIN, SERVERINFO_LEVEL_MAX, CFGFLAG_SERVER, "Difficulty level for Teeworlds 0.7 (0: Casual, 1: Normal, 2: Competitive)")
 
 MACRO_CONFIG_STR(EcBindaddr, ec_bindaddr, 128, "localhost", CFGFLAG_ECON, "Address to bind the external console to. Anything but 'localhost' is dangerous")
@@ -88,7 +90,10 @@ MACRO_CONFIG_INT(SvVoteTime, sv_vote_time, 25, 1, 9999, CFGFLAG_SERVER, "The tim
 MACRO_CONFIG_INT(SvVoteMapTimeDelay, sv_vote_map_delay, 0, 0, 9999, CFGFLAG_SERVER, "The minimum time in seconds between map votes")
 MACRO_CONFIG_INT(SvVoteDelay, sv_vote_delay, 3, 0, 9999, CFGFLAG_SERVER, "The time in seconds between any vote")
 
+MACRO_CONFIG_INT(SvSnapshotThreads, sv_snapshot_threads, 0, 0, 16, CFGFLAG_SERVER, "Number of worker threads that encode and compress the client snapshots (0 = encode on the main thread)")
 MACRO_CONFIG_INT(SvMapWindow, sv_map_window, 15, 0, 100, CFGFLAG_SERVER, "Map downloading send-ahead window")
+MACRO_CONFIG_INT(SvMapMmap, sv_map_mmap, 0, 0, 1, CFGFLAG_SERVER, "Read the loaded maps through a memory mapping (map files must then be replaced, never overwritten in place)")
+MACRO_CONFIG_INT(SvMapDataCache, sv_map_data_cache, 8192, 0, 1048576, CFGFLAG_SERVER, "Size in KiB of the unloaded map data kept inflated with sv_map_mmap")
 MACRO_CONFIG_INT(SvFastDownload, sv_fast_download, 1, 0, 1, CFGFLAG_SERVER, "Enables fast download of maps")
 
 MACRO_CONFIG_STR(SvRegionName, sv_region_name, 5, "UNK", CFGFLAG_SERVER, "Server region. Used for regional bans")
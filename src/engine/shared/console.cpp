@@ -583,7 +583,7 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandBuckets[CommandBucket(pName)]; pCommand; pCommand = pCommand->m_pNextInBucket)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -1053,6 +1053,7 @@ CConsole::CConsole(int FlagMask)
 	m_apStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandBuckets, sizeof(m_apCommandBuckets));
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -1169,14 +1170,56 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 	}
 }
 
+unsigned CConsole::CommandBucket(const char *pName)
+{
+	// FNV-1a of the lowercase name, like str_comp_nocase only ASCII is folded
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = (Hash ^ c) * 16777619u;
+	}
+	return Hash % NUM_COMMAND_BUCKETS;
+}
+
+void CConsole::IndexCommand(CCommand *pCommand)
+{
+	// same position as in the sorted list
+	CCommand **ppBucket = &m_apCommandBuckets[CommandBucket(pCommand->m_pName)];
+	while(*ppBucket && str_comp(pCommand->m_pName, (*ppBucket)->m_pName) > 0)
+		ppBucket = &(*ppBucket)->m_pNextInBucket;
+	pCommand->m_pNextInBucket = *ppBucket;
+	*ppBucket = pCommand;
+}
+
+void CConsole::UnindexCommand(CCommand *pCommand)
+{
+	for(CCommand **ppBucket = &m_apCommandBuckets[CommandBucket(pCommand->m_pName)]; *ppBucket; ppBucket = &(*ppBucket)->m_pNextInBucket)
+	{
+		if(*ppBucket == pCommand)
+		{
+			*ppBucket = pCommand->m_pNextInBucket;
+			break;
+		}
+	}
+}
+
 void CConsole::AddCommandSorted(CCommand *pCommand)
 {
+	IndexCommand(pCommand);
+
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
 		if(m_pFirstCommand && m_pFirstCommand->m_pNext)
 			pCommand->m_pNext = m_pFirstCommand;
 		else
+		{
+			if(m_pFirstCommand)
+				UnindexCommand(m_pFirstCommand);
 			pCommand->m_pNext = 0;
+		}
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -1281,6 +1324,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		UnindexCommand(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -1304,6 +1348,17 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(CCommand *&pBucket : m_apCommandBuckets)
+	{
+		for(CCommand **ppCommand = &pBucket; *ppCommand;)
+		{
+			if((*ppCommand)->m_Temp)
+				*ppCommand = (*ppCommand)->m_pNextInBucket;
+			else
+				ppCommand = &(*ppCommand)->m_pNextInBucket;
+		}
+	}
+
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
 }
@@ -1352,7 +1407,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandBuckets[CommandBucket(pName)]; pCommand; pCommand = pCommand->m_pNextInBucket)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -14,6 +14,7 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pNextInBucket;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -38,6 +39,14 @@ class CConsole : public IConsole
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
 
+	// Case insensitive index of the commands by name, the commands of a
+	// bucket are kept in the order of the sorted list
+	enum
+	{
+		NUM_COMMAND_BUCKETS = 1024,
+	};
+	CCommand *m_apCommandBuckets[NUM_COMMAND_BUCKETS];
+
 	class CExecFile
 	{
 	public:
@@ -197,6 +206,9 @@ class CConsole : public IConsole
 		}
 	} m_ExecutionQueue;
 
+	static unsigned CommandBucket(const char *pName);
+	void IndexCommand(CCommand *pCommand);
+	void UnindexCommand(CCommand *pCommand);
 	void AddCommandSorted(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
@@ -3,12 +3,12 @@
 
 #include "datafile.h"
 
-#include <base/hash_ctxt.h>
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
 #include <engine/storage.h>
 
+#include "filehash.h"
 #include "uuid_manager.h"
 
 #include <cstdlib>
@@ -88,13 +88,27 @@ struct CDatafile
 	int m_DataStartOffset;
 	char **m_ppDataPtrs;
 	char *m_pData;
+
+	// mapped mode, see CDataFileReader::Open
+	unsigned char *m_pMapping;
+	unsigned m_MappingSize;
+	// use counter at which each inflated data was unloaded, 0 while in use
+	uint64_t *m_pDataUnloadedAt;
+	uint64_t m_UnloadCounter;
+	size_t m_UnloadedDataSize;
+
+	bool IsMapped(const char *pData) const
+	{
+		return m_pMapping && (const unsigned char *)pData >= m_pMapping && (const unsigned char *)pData < m_pMapping + m_MappingSize;
+	}
 };
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped, bool RememberHash)
 {
 	log_trace("datafile", "loading. filename='%s'", pFilename);
 
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	char aPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
 	if(!File)
 	{
 		dbg_msg("datafile", "could not open '%s'", pFilename);
@@ -102,30 +116,10 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	}
 
 	// take the CRC of the file and store it
-	unsigned Crc = 0;
-	SHA256_DIGEST Sha256;
-	{
-		enum
-		{
-			BUFFER_SIZE = 64 * 1024
-		};
-
-		SHA256_CTX Sha256Ctxt;
-		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[BUFFER_SIZE];
-
-		while(true)
-		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes == 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
-		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
-
-		io_seek(File, 0, IOSEEK_START);
-	}
+	CFileHash Hash;
+	Hash.Compute(pStorage, pFilename, StorageType, File, aPath, RememberHash);
+	const unsigned Crc = Hash.m_Crc;
+	const SHA256_DIGEST Sha256 = Hash.m_Sha256;
 
 	// TODO: change this header
 	CDatafileHeader Header;
@@ -162,18 +156,25 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	unsigned AllocSize = Size;
 	AllocSize += sizeof(CDatafile); // add space for info structure
+	AllocSize += Header.m_NumRawData * sizeof(uint64_t); // add space for the unload counters
 	AllocSize += Header.m_NumRawData * sizeof(void *); // add space for data pointers
 
 	CDatafile *pTmpDataFile = (CDatafile *)malloc(AllocSize);
 	pTmpDataFile->m_Header = Header;
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
-	pTmpDataFile->m_ppDataPtrs = (char **)(pTmpDataFile + 1);
-	pTmpDataFile->m_pData = (char *)(pTmpDataFile + 1) + Header.m_NumRawData * sizeof(char *);
+	pTmpDataFile->m_pDataUnloadedAt = (uint64_t *)(pTmpDataFile + 1);
+	pTmpDataFile->m_ppDataPtrs = (char **)(pTmpDataFile->m_pDataUnloadedAt + Header.m_NumRawData);
+	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_ppDataPtrs + Header.m_NumRawData);
 	pTmpDataFile->m_File = File;
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
+	pTmpDataFile->m_pMapping = nullptr;
+	pTmpDataFile->m_MappingSize = 0;
+	pTmpDataFile->m_UnloadCounter = 0;
+	pTmpDataFile->m_UnloadedDataSize = 0;
 
 	// clear the data pointers
+	mem_zero(pTmpDataFile->m_pDataUnloadedAt, Header.m_NumRawData * sizeof(uint64_t));
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
 
 	// read types, offsets, sizes and item data
@@ -186,6 +187,15 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
+	// the data is read from the mapping, falling back to reads if the file
+	// can't be mapped
+	if(Mapped)
+	{
+		pTmpDataFile->m_pMapping = (unsigned char *)io_map(File, &pTmpDataFile->m_MappingSize);
+		if(!pTmpDataFile->m_pMapping)
+			dbg_msg("datafile", "could not map '%s', reading it instead", pFilename);
+	}
+
 	Close();
 	m_pDataFile = pTmpDataFile;
 
@@ -224,8 +234,12 @@ bool CDataFileReader::Close()
 
 	// free the data that is loaded
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
-		free(m_pDataFile->m_ppDataPtrs[i]);
+	{
+		if(!m_pDataFile->IsMapped(m_pDataFile->m_ppDataPtrs[i]))
+			free(m_pDataFile->m_ppDataPtrs[i]);
+	}
 
+	io_unmap(m_pDataFile->m_pMapping, m_pDataFile->m_MappingSize);
 	io_close(m_pDataFile->m_File);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
@@ -285,6 +299,13 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return nullptr;
 
+	// unloaded data kept in the cache is in use again
+	if(m_pDataFile->m_pDataUnloadedAt[Index])
+	{
+		m_pDataFile->m_pDataUnloadedAt[Index] = 0;
+		m_pDataFile->m_UnloadedDataSize -= GetDataSize(Index);
+	}
+
 	// load it if needed
 	if(!m_pDataFile->m_ppDataPtrs[Index])
 	{
@@ -294,10 +315,21 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 		int SwapSize = DataSize;
 #endif
 
+		const unsigned char *pMapped = nullptr;
+		if(m_pDataFile->m_pMapping)
+		{
+			const int64_t Offset = (int64_t)m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index];
+			if(DataSize < 0 || Offset < 0 || Offset + DataSize > m_pDataFile->m_MappingSize)
+			{
+				dbg_msg("datafile", "data index=%d is outside of the file", Index);
+				return nullptr;
+			}
+			pMapped = m_pDataFile->m_pMapping + Offset;
+		}
+
 		if(m_pDataFile->m_Header.m_Version == 4)
 		{
 			// v4 has compressed data
-			void *pTemp = malloc(DataSize);
 			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
 			unsigned long s;
 
@@ -305,12 +337,18 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(UncompressedSize);
 
 			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
+			void *pTemp = nullptr;
+			if(!pMapped)
+			{
+				pTemp = malloc(DataSize);
+				io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
+				io_read(m_pDataFile->m_File, pTemp, DataSize);
+				pMapped = (const unsigned char *)pTemp;
+			}
 
 			// decompress the data, TODO: check for errors
 			s = UncompressedSize;
-			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef *)pTemp, DataSize);
+			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (const Bytef *)pMapped, DataSize);
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
@@ -318,13 +356,28 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 			// clean up the temporary buffers
 			free(pTemp);
 		}
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+		else if(pMapped)
+		{
+			// uncompressed data is used in place
+			log_trace("datafile", "mapping data index=%d size=%d", Index, DataSize);
+			m_pDataFile->m_ppDataPtrs[Index] = (char *)pMapped;
+		}
+#endif
 		else
 		{
 			// load the data
 			log_trace("datafile", "loading data index=%d size=%d", Index, DataSize);
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(DataSize);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+			if(pMapped)
+			{
+				mem_copy(m_pDataFile->m_ppDataPtrs[Index], pMapped, DataSize);
+			}
+			else
+			{
+				io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
+				io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+			}
 		}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
@@ -351,9 +404,53 @@ void CDataFileReader::UnloadData(int Index)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
-	//
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+	char *pData = m_pDataFile->m_ppDataPtrs[Index];
+	if(!m_pDataFile->m_pMapping || !pData)
+	{
+		free(pData);
+		m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+		return;
+	}
+
+	// data used in place in the mapping costs nothing to keep
+	if(m_pDataFile->IsMapped(pData) || m_pDataFile->m_pDataUnloadedAt[Index])
+		return;
+
+	// keep the inflated data until the cache is full
+	m_pDataFile->m_pDataUnloadedAt[Index] = ++m_pDataFile->m_UnloadCounter;
+	m_pDataFile->m_UnloadedDataSize += GetDataSize(Index);
+	while(m_pDataFile->m_UnloadedDataSize > m_DataCacheSize)
+	{
+		int Oldest = -1;
+		for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+		{
+			if(m_pDataFile->m_pDataUnloadedAt[i] && (Oldest < 0 || m_pDataFile->m_pDataUnloadedAt[i] < m_pDataFile->m_pDataUnloadedAt[Oldest]))
+				Oldest = i;
+		}
+		m_pDataFile->m_UnloadedDataSize -= GetDataSize(Oldest);
+		m_pDataFile->m_pDataUnloadedAt[Oldest] = 0;
+		free(m_pDataFile->m_ppDataPtrs[Oldest]);
+		m_pDataFile->m_ppDataPtrs[Oldest] = nullptr;
+	}
+}
+
+bool CDataFileReader::IsMapped() const
+{
+	return m_pDataFile && m_pDataFile->m_pMapping;
+}
+
+size_t CDataFileReader::LoadedDataSize() const
+{
+	if(!m_pDataFile)
+		return 0;
+
+	size_t Size = 0;
+	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+	{
+		if(m_pDataFile->m_ppDataPtrs[i] && !m_pDataFile->IsMapped(m_pDataFile->m_ppDataPtrs[i]))
+			Size += GetDataSize(i);
+	}
+	return Size;
 }
 
 int CDataFileReader::GetItemSize(int Index) const
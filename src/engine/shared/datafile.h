@@ -19,6 +19,7 @@ enum
 class CDataFileReader
 {
 	struct CDatafile *m_pDataFile;
+	size_t m_DataCacheSize;
 	void *GetDataImpl(int Index, int Swap);
 	int GetFileDataSize(int Index) const;
 
@@ -26,11 +27,21 @@ class CDataFileReader
 	int GetInternalItemType(int ExternalType);
 
 public:
+	enum
+	{
+		DEFAULT_DATA_CACHE_SIZE = 8 * 1024 * 1024,
+	};
+
 	CDataFileReader() :
-		m_pDataFile(nullptr) {}
+		m_pDataFile(nullptr), m_DataCacheSize(DEFAULT_DATA_CACHE_SIZE) {}
 	~CDataFileReader() { Close(); }
 
-	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	// A mapped reader uses the uncompressed data in place in a read-only
+	// mapping of the file and inflates the compressed data from it. Unloaded
+	// data is then kept up to the cache size in case it is used again. The
+	// file must not be overwritten in place while it is open.
+	// RememberHash keeps the hashes of the file in a sidecar, see CFileHash.
+	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped = false, bool RememberHash = false);
 	bool Close();
 	bool IsOpen() const { return m_pDataFile != nullptr; }
 	IOHANDLE File() const;
@@ -41,6 +52,11 @@ public:
 	void UnloadData(int Index);
 	int NumData() const;
 
+	bool IsMapped() const;
+	void SetDataCacheSize(size_t Size) { m_DataCacheSize = Size; }
+	// size of the data copied or inflated in memory, including the cache
+	size_t LoadedDataSize() const;
+
 	void *GetItem(int Index, int *pType = nullptr, int *pId = nullptr);
 	int GetItemSize(int Index) const;
 	void GetType(int Type, int *pStart, int *pNum);
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
 #include <engine/console.h>
 #include <engine/storage.h>
@@ -18,6 +19,8 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <atomic>
+
 const double g_aSpeeds[g_DemoSpeeds] = {0.1, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 20.0, 24.0, 28.0, 32.0, 40.0, 48.0, 56.0, 64.0};
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
@@ -33,15 +36,20 @@ static const int gs_NumMarkersOffset = 176;
 
 static const ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 
-CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
+CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData, bool Async)
 {
 	m_File = 0;
 	m_aCurrentFilename[0] = '\0';
 	m_pfnFilter = 0;
 	m_pUser = 0;
 	m_LastTickMarker = -1;
+	m_FirstTick = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_NoMapData = NoMapData;
+	m_Async = Async;
+	m_pWriter = nullptr;
+	m_MaxQueueDepth = 0;
+	m_NumDroppedFrames = 0;
 }
 
 // Record
@@ -176,8 +184,11 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 
 	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
+	m_LastWrittenTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_MaxQueueDepth = 0;
+	m_NumDroppedFrames = 0;
 
 	if(m_pConsole)
 	{
@@ -188,6 +199,9 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_File = DemoFile;
 	str_copy(m_aCurrentFilename, pFilename);
 
+	if(m_Async)
+		StartWriter();
+
 	return 0;
 }
 
@@ -221,9 +235,152 @@ enum
 	CHUNKFLAG_BIGSIZE = 0x10
 };
 
+// Single producer, single consumer ring of variable sized frames. The
+// recording thread queues the raw frames, the writer thread encodes and
+// writes them in order.
+class CDemoRecorder::CWriter
+{
+public:
+	enum
+	{
+		CAPACITY = 512 * 1024,
+		FRAMETYPE_WRAP = -1,
+	};
+
+	struct CFrameHeader
+	{
+		int m_Type;
+		int m_Tick;
+		int m_Size;
+	};
+
+	// positions in bytes since the start of the recording
+	std::atomic<uint64_t> m_Head{0};
+	std::atomic<uint64_t> m_Tail{0};
+	std::atomic<int> m_NumFrames{0};
+	std::atomic<bool> m_Stop{false};
+	CSemaphore m_Wakeup;
+	void *m_pThread = nullptr;
+	unsigned char m_aBuffer[CAPACITY];
+
+	static int FrameSize(int DataSize) { return (sizeof(CFrameHeader) + DataSize + 3) & ~3; }
+
+	bool Push(int Type, int Tick, const void *pData, int Size)
+	{
+		const uint64_t Head = m_Head.load(std::memory_order_relaxed);
+		const int Offset = Head % CAPACITY;
+		const int Needed = FrameSize(Size);
+		// frames are never split, skip the end of the buffer if needed
+		const int Padding = CAPACITY - Offset < Needed ? CAPACITY - Offset : 0;
+		if(Head + Padding + Needed - m_Tail.load(std::memory_order_acquire) > CAPACITY)
+			return false;
+
+		if(Padding >= (int)sizeof(CFrameHeader))
+		{
+			const CFrameHeader Wrap = {FRAMETYPE_WRAP, 0, 0};
+			mem_copy(m_aBuffer + Offset, &Wrap, sizeof(Wrap));
+		}
+		const int FrameOffset = (Head + Padding) % CAPACITY;
+		const CFrameHeader Header = {Type, Tick, Size};
+		mem_copy(m_aBuffer + FrameOffset, &Header, sizeof(Header));
+		mem_copy(m_aBuffer + FrameOffset + sizeof(Header), pData, Size);
+
+		m_NumFrames.fetch_add(1, std::memory_order_relaxed);
+		m_Head.store(Head + Padding + Needed, std::memory_order_release);
+		return true;
+	}
+
+	template<class F>
+	void Drain(F &&Consume)
+	{
+		uint64_t Tail = m_Tail.load(std::memory_order_relaxed);
+		const uint64_t Head = m_Head.load(std::memory_order_acquire);
+		while(Tail != Head)
+		{
+			const int Offset = Tail % CAPACITY;
+			CFrameHeader Header;
+			if(CAPACITY - Offset >= (int)sizeof(Header))
+				mem_copy(&Header, m_aBuffer + Offset, sizeof(Header));
+			if(CAPACITY - Offset < (int)sizeof(Header) || Header.m_Type == FRAMETYPE_WRAP)
+			{
+				Tail += CAPACITY - Offset;
+				continue;
+			}
+
+			Consume(Header.m_Type, Header.m_Tick, m_aBuffer + Offset + sizeof(Header), Header.m_Size);
+			Tail += FrameSize(Header.m_Size);
+			m_NumFrames.fetch_sub(1, std::memory_order_relaxed);
+			m_Tail.store(Tail, std::memory_order_release);
+		}
+	}
+};
+
+void CDemoRecorder::WriterThread(void *pUser)
+{
+	CDemoRecorder *pSelf = static_cast<CDemoRecorder *>(pUser);
+	CWriter *pWriter = pSelf->m_pWriter;
+	while(true)
+	{
+		pWriter->m_Wakeup.Wait();
+		// everything queued before the stop request gets written
+		const bool Stop = pWriter->m_Stop.load();
+		pWriter->Drain([pSelf](int Type, int Tick, const void *pData, int Size) {
+			pSelf->WriteFrame(Type, Tick, pData, Size);
+		});
+		if(Stop)
+			break;
+	}
+}
+
+void CDemoRecorder::StartWriter()
+{
+	m_pWriter = new CWriter();
+	m_pWriter->m_pThread = thread_init(WriterThread, this, "demo writer");
+}
+
+void CDemoRecorder::StopWriter()
+{
+	m_pWriter->m_Stop.store(true);
+	m_pWriter->m_Wakeup.Signal();
+	thread_wait(m_pWriter->m_pThread);
+	delete m_pWriter;
+	m_pWriter = nullptr;
+}
+
+int CDemoRecorder::QueueDepth() const
+{
+	return m_pWriter ? m_pWriter->m_NumFrames.load(std::memory_order_relaxed) : 0;
+}
+
+void CDemoRecorder::QueueFrame(int Type, int Tick, const void *pData, int Size)
+{
+	if(!m_pWriter)
+	{
+		WriteFrame(Type, Tick, pData, Size);
+		return;
+	}
+
+	if(!m_pWriter->Push(Type, Tick, pData, Size))
+	{
+		// the writer can't keep up, never stall the caller
+		m_NumDroppedFrames++;
+		return;
+	}
+	m_MaxQueueDepth = maximum(m_MaxQueueDepth, QueueDepth());
+	m_pWriter->m_Wakeup.Signal();
+}
+
+void CDemoRecorder::WriteFrame(int Type, int Tick, const void *pData, int Size)
+{
+	if(Type == CHUNKTYPE_SNAPSHOT)
+		WriteSnapshot(Tick, pData, Size);
+	else
+		Write(Type, pData, Size);
+}
+
 void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 {
-	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
+	if(m_LastWrittenTickMarker == -1 || Tick - m_LastWrittenTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
 		unsigned char aChunk[sizeof(int32_t) + 1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER;
@@ -237,13 +394,11 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 	else
 	{
 		unsigned char aChunk[1];
-		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
+		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastWrittenTickMarker);
 		io_write(m_File, aChunk, sizeof(aChunk));
 	}
 
-	m_LastTickMarker = Tick;
-	if(m_FirstTick < 0)
-		m_FirstTick = Tick;
+	m_LastWrittenTickMarker = Tick;
 }
 
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
@@ -297,6 +452,15 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+
+	QueueFrame(CHUNKTYPE_SNAPSHOT, Tick, pData, Size);
+}
+
+void CDemoRecorder::WriteSnapshot(int Tick, const void *pData, int Size)
 {
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
 	{
@@ -337,7 +501,7 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 			return;
 		}
 	}
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	QueueFrame(CHUNKTYPE_MESSAGE, -1, pData, Size);
 }
 
 int CDemoRecorder::Stop()
@@ -345,6 +509,9 @@ int CDemoRecorder::Stop()
 	if(!m_File)
 		return -1;
 
+	if(m_pWriter)
+		StopWriter();
+
 	// add the demo length to the header
 	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
 	unsigned char aLength[sizeof(int32_t)];
@@ -366,7 +533,16 @@ int CDemoRecorder::Stop()
 	io_close(m_File);
 	m_File = 0;
 	if(m_pConsole)
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording", gs_DemoPrintColor);
+	{
+		if(m_NumDroppedFrames)
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "Stopped recording, %d frames dropped", m_NumDroppedFrames);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf, gs_DemoPrintColor);
+		}
+		else
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording", gs_DemoPrintColor);
+	}
 
 	return 0;
 }
@@ -15,27 +15,44 @@ typedef std::function<void()> TUpdateIntraTimesFunc;
 
 class CDemoRecorder : public IDemoRecorder
 {
+	class CWriter;
+
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
 	char m_aCurrentFilename[256];
 	int m_LastTickMarker;
-	int m_LastKeyFrame;
 	int m_FirstTick;
-	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	class CSnapshotDelta *m_pSnapshotDelta;
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
 	bool m_NoMapData;
 	unsigned char *m_pMapData;
 
+	// Encoder state, owned by the writer thread of an asynchronous recorder
+	int m_LastWrittenTickMarker;
+	int m_LastKeyFrame;
+	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
+
+	// Asynchronous recorders hand the frames to a writer thread
+	bool m_Async;
+	CWriter *m_pWriter;
+	int m_MaxQueueDepth;
+	int m_NumDroppedFrames;
+
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
+	static void WriterThread(void *pUser);
+	void StartWriter();
+	void StopWriter();
+	void QueueFrame(int Type, int Tick, const void *pData, int Size);
+	void WriteFrame(int Type, int Tick, const void *pData, int Size);
 	void WriteTickMarker(int Tick, int Keyframe);
+	void WriteSnapshot(int Tick, const void *pData, int Size);
 	void Write(int Type, const void *pData, int Size);
 
 public:
-	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
+	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false, bool Async = false);
 	CDemoRecorder() {}
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile = nullptr, DEMOFUNC_FILTER pfnFilter = nullptr, void *pUser = nullptr);
@@ -52,6 +69,11 @@ public:
 	void ClearCurrentFilename() { m_aCurrentFilename[0] = '\0'; }
 
 	int Length() const override { return (m_LastTickMarker - m_FirstTick) / SERVER_TICK_SPEED; }
+
+	// queue statistics of the current recording, always 0 when synchronous
+	int QueueDepth() const;
+	int MaxQueueDepth() const { return m_MaxQueueDepth; }
+	int NumDroppedFrames() const { return m_NumDroppedFrames; }
 };
 
 class CDemoPlayer : public IDemoPlayer
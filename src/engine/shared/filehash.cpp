@@ -0,0 +1,123 @@
+#include "filehash.h"
+
+#include <base/hash_ctxt.h>
+#include <base/system.h>
+#include <engine/storage.h>
+
+#include <atomic>
+
+#include <zlib.h>
+
+static std::atomic<int64_t> gs_NumHashedFiles{0};
+
+static const char gs_aSidecarMarker[8] = "HASHES1";
+
+struct CHashSidecar
+{
+	char m_aMarker[sizeof(gs_aSidecarMarker)];
+	int64_t m_Size;
+	int64_t m_Modified;
+	unsigned m_Crc;
+	SHA256_DIGEST m_Sha256;
+};
+
+static void HashContents(IOHANDLE File, unsigned *pCrc, SHA256_DIGEST *pSha256)
+{
+	SHA256_CTX Sha256Ctxt;
+	sha256_init(&Sha256Ctxt);
+	unsigned Crc = 0;
+
+	unsigned Size;
+	if(void *pData = io_map(File, &Size))
+	{
+		Crc = crc32(Crc, (const Bytef *)pData, Size);
+		sha256_update(&Sha256Ctxt, pData, Size);
+		io_unmap(pData, Size);
+	}
+	else
+	{
+		unsigned char aBuffer[64 * 1024];
+		while(true)
+		{
+			unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
+			if(Bytes == 0)
+				break;
+			Crc = crc32(Crc, aBuffer, Bytes);
+			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+		}
+	}
+
+	*pCrc = Crc;
+	*pSha256 = sha256_finish(&Sha256Ctxt);
+	gs_NumHashedFiles++;
+}
+
+bool CFileHash::Compute(IStorage *pStorage, const char *pFilename, int StorageType, IOHANDLE File, const char *pPath, bool Remember)
+{
+	const int64_t Size = io_length(File);
+	time_t Created, Modified;
+	const bool UseSidecar = Remember && StorageType != IStorage::TYPE_ABSOLUTE && Size >= 0 && fs_file_time(pPath, &Created, &Modified) == 0;
+
+	char aSidecar[IO_MAX_PATH_LENGTH];
+	str_format(aSidecar, sizeof(aSidecar), "%s.hash", pFilename);
+
+	if(UseSidecar)
+	{
+		if(IOHANDLE SidecarFile = pStorage->OpenFile(aSidecar, IOFLAG_READ, IStorage::TYPE_SAVE))
+		{
+			CHashSidecar Sidecar;
+			const bool Complete = io_read(SidecarFile, &Sidecar, sizeof(Sidecar)) == sizeof(Sidecar);
+			io_close(SidecarFile);
+			if(Complete && mem_comp(Sidecar.m_aMarker, gs_aSidecarMarker, sizeof(gs_aSidecarMarker)) == 0 &&
+				Sidecar.m_Size == Size && Sidecar.m_Modified == (int64_t)Modified)
+			{
+				m_Crc = Sidecar.m_Crc;
+				m_Sha256 = Sidecar.m_Sha256;
+				return true;
+			}
+		}
+	}
+
+	HashContents(File, &m_Crc, &m_Sha256);
+	io_seek(File, 0, IOSEEK_START);
+
+	// a file modified in the last seconds could still change without a
+	// different modification time, don't remember it yet
+	if(!UseSidecar || (int64_t)Modified >= time_timestamp() - 1)
+		return true;
+
+	CHashSidecar Sidecar;
+	mem_zero(&Sidecar, sizeof(Sidecar));
+	mem_copy(Sidecar.m_aMarker, gs_aSidecarMarker, sizeof(gs_aSidecarMarker));
+	Sidecar.m_Size = Size;
+	Sidecar.m_Modified = Modified;
+	Sidecar.m_Crc = m_Crc;
+	Sidecar.m_Sha256 = m_Sha256;
+
+	char aSidecarPath[IO_MAX_PATH_LENGTH];
+	pStorage->GetCompletePath(IStorage::TYPE_SAVE, aSidecar, aSidecarPath, sizeof(aSidecarPath));
+	fs_makedir_rec_for(aSidecarPath);
+	if(IOHANDLE SidecarFile = io_open(aSidecarPath, IOFLAG_WRITE))
+	{
+		io_write(SidecarFile, &Sidecar, sizeof(Sidecar));
+		io_close(SidecarFile);
+	}
+	return true;
+}
+
+bool CFileHash::Compute(IStorage *pStorage, const char *pFilename, int StorageType, bool Remember)
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
+	if(!File)
+		return false;
+
+	const bool Result = Compute(pStorage, pFilename, StorageType, File, aPath, Remember);
+	io_close(File);
+	return Result;
+}
+
+int64_t CFileHash::NumHashedFiles()
+{
+	return gs_NumHashedFiles.load();
+}
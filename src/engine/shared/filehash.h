@@ -0,0 +1,29 @@
+#ifndef ENGINE_SHARED_FILEHASH_H
+#define ENGINE_SHARED_FILEHASH_H
+
+#include <base/hash.h>
+#include <base/types.h>
+
+#include <cstdint>
+
+class IStorage;
+
+// Crc and sha256 of a whole file. With Remember the hashes are kept in a
+// sidecar file of the save directory, "<filename>.hash", and reused as
+// long as the size and the modification time of the file are the same.
+class CFileHash
+{
+public:
+	unsigned m_Crc = 0;
+	SHA256_DIGEST m_Sha256 = {};
+
+	// pPath is the complete path of the already opened file, the file
+	// position is reset to the start
+	bool Compute(IStorage *pStorage, const char *pFilename, int StorageType, IOHANDLE File, const char *pPath, bool Remember = false);
+	bool Compute(IStorage *pStorage, const char *pFilename, int StorageType, bool Remember = false);
+
+	// number of files actually read to hash them, for the tests
+	static int64_t NumHashedFiles();
+};
+
+#endif
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "map.h"
+#include <engine/shared/config.h>
 #include <engine/storage.h>
 
 CMap::CMap() = default;
@@ -60,7 +61,13 @@ bool CMap::Load(const char *pMapName)
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 	if(!pStorage)
 		return false;
-	return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL);
+	return Load(pStorage, pMapName, false);
+}
+
+bool CMap::Load(IStorage *pStorage, const char *pMapName, bool RememberHash)
+{
+	m_DataFile.SetDataCacheSize((size_t)g_Config.m_SvMapDataCache * 1024);
+	return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL, g_Config.m_SvMapMmap, RememberHash);
 }
 
 void CMap::Unload()
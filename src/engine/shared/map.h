@@ -28,6 +28,7 @@ public:
 	int NumItems() const override;
 
 	bool Load(const char *pMapName) override;
+	bool Load(class IStorage *pStorage, const char *pMapName, bool RememberHash) override;
 	void Unload() override;
 	bool IsLoaded() const override;
 	IOHANDLE File() const override;
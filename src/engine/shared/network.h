@@ -9,6 +9,8 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#include <unordered_map>
+
 class CHuffman;
 class CNetBan;
 class CPacker;
@@ -397,14 +399,19 @@ class CNetServer
 
 	CSpamConn m_aSpamConns[NET_CONNLIMIT_IPS];
 
+	// peer address of the slots, updated whenever a slot gets an address
+	std::unordered_map<NETADDR, int> m_AddrSlots;
+
 	CNetRecvUnpacker m_RecvUnpacker;
 
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
 	void OnConnCtrlMsg(NETADDR &Addr, int ClientId, int ControlMsg, const CNetPacketConstruct &Packet);
-	bool ClientExists(const NETADDR &Addr) { return GetClientSlot(Addr) != -1; }
-	int GetClientSlot(const NETADDR &Addr);
+	int GetClientSlot(const NETADDR &Addr) const;
+	bool ClientExists(const NETADDR &Addr) const { return GetClientSlot(Addr) != -1; }
+	void IndexSlot(int Slot);
+	void UnindexSlot(int Slot);
 	void SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra, int ExtraSize, SECURITY_TOKEN SecurityToken);
 
 	int TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, bool VanillaAuth = false, bool Sixup = false, SECURITY_TOKEN Token = 0);
@@ -424,6 +431,8 @@ public:
 	int Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken);
 	int Send(CNetChunk *pChunk);
 	int Update();
+	// sends the packets queued since the last call
+	void Flush();
 
 	//
 	int Drop(int ClientId, EClientDropType Type, const char *pReason);
@@ -64,11 +64,16 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 	m_VConnNum = 0;
 	m_VConnFirst = 0;
 
+	m_AddrSlots.reserve(NET_MAX_CLIENTS);
+
 	secure_random_fill(m_aSecurityTokenSeed, sizeof(m_aSecurityTokenSeed));
 
 	for(auto &Slot : m_aSlots)
 		Slot.m_Connection.Init(m_Socket, true);
 
+	// the snapshots of all clients go out at once, send them together
+	net_udp_set_batching(m_Socket, true);
+
 	return true;
 }
 
@@ -105,6 +110,7 @@ int CNetServer::Drop(int ClientId, EClientDropType Type, const char *pReason)
 		m_pfnDelClient(ClientId, Type, pReason, m_pUser);
 
 	m_aSlots[ClientId].m_Connection.Disconnect(pReason);
+	UnindexSlot(ClientId);
 
 	return 0;
 }
@@ -125,6 +131,11 @@ int CNetServer::Update()
 	return 0;
 }
 
+void CNetServer::Flush()
+{
+	net_udp_flush(m_Socket);
+}
+
 SECURITY_TOKEN CNetServer::GetGlobalToken()
 {
 	static NETADDR NullAddr = {0};
@@ -246,7 +257,9 @@ int CNetServer::TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, boo
 	}
 
 	// init connection slot
+	UnindexSlot(Slot);
 	m_aSlots[Slot].m_Connection.DirectInit(Addr, SecurityToken, Token, Sixup);
+	IndexSlot(Slot);
 
 	if(VanillaAuth)
 	{
@@ -576,22 +589,34 @@ int CNetServer::OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg,
 	return 0;
 }
 
-int CNetServer::GetClientSlot(const NETADDR &Addr)
+void CNetServer::IndexSlot(int Slot)
 {
-	int Slot = -1;
+	m_AddrSlots[*m_aSlots[Slot].m_Connection.PeerAddress()] = Slot;
+}
 
-	for(int i = 0; i < MaxClients(); i++)
-	{
-		if(m_aSlots[i].m_Connection.State() != NET_CONNSTATE_OFFLINE &&
-			m_aSlots[i].m_Connection.State() != NET_CONNSTATE_ERROR &&
-			net_addr_comp(m_aSlots[i].m_Connection.PeerAddress(), &Addr) == 0)
+void CNetServer::UnindexSlot(int Slot)
+{
+	auto It = m_AddrSlots.find(*m_aSlots[Slot].m_Connection.PeerAddress());
+	if(It != m_AddrSlots.end() && It->second == Slot)
+		m_AddrSlots.erase(It);
+}
 
-		{
-			Slot = i;
-		}
-	}
+int CNetServer::GetClientSlot(const NETADDR &Addr) const
+{
+	// A slot only gets a new address on accept and on timeout rejoin, so
+	// the index always knows the latest slot of an address. Slots that went
+	// offline in between are filtered out here.
+	auto It = m_AddrSlots.find(Addr);
+	if(It == m_AddrSlots.end())
+		return -1;
+
+	const CNetConnection &Connection = m_aSlots[It->second].m_Connection;
+	if(Connection.State() == NET_CONNSTATE_OFFLINE ||
+		Connection.State() == NET_CONNSTATE_ERROR ||
+		net_addr_comp(Connection.PeerAddress(), &Addr) != 0)
+		return -1;
 
-	return Slot;
+	return It->second;
 }
 
 static bool IsDDNetControlMsg(const CNetPacketConstruct *pPacket)
@@ -800,8 +825,10 @@ bool CNetServer::SetTimedOut(int ClientId, int OrigId)
 	if(m_aSlots[ClientId].m_Connection.State() != NET_CONNSTATE_ERROR)
 		return false;
 
+	UnindexSlot(ClientId);
 	m_aSlots[ClientId].m_Connection.SetTimedOut(ClientAddr(OrigId), m_aSlots[OrigId].m_Connection.SeqSequence(), m_aSlots[OrigId].m_Connection.AckSequence(), m_aSlots[OrigId].m_Connection.SecurityToken(), m_aSlots[OrigId].m_Connection.ResendBuffer(), m_aSlots[OrigId].m_Connection.m_Sixup);
 	m_aSlots[OrigId].m_Connection.Reset();
+	IndexSlot(ClientId);
 	return true;
 }
 
@@ -0,0 +1,92 @@
+#include "profiler.h"
+
+#include <base/math.h>
+
+#include <algorithm>
+#include <vector>
+
+std::atomic<bool> CProfiler::ms_Enabled{false};
+std::deque<CProfiler::CZone> CProfiler::ms_Zones;
+
+CProfiler::CZone *CProfiler::Zone(const char *pName)
+{
+	for(CZone &Zone : ms_Zones)
+	{
+		if(str_comp(Zone.m_aName, pName) == 0)
+			return &Zone;
+	}
+
+	CZone &Zone = ms_Zones.emplace_back();
+	str_copy(Zone.m_aName, pName, sizeof(Zone.m_aName));
+	return &Zone;
+}
+
+void CProfiler::SetEnabled(bool Enabled)
+{
+	if(Enabled == IsEnabled())
+		return;
+
+	ms_Enabled.store(Enabled, std::memory_order_relaxed);
+	Reset();
+}
+
+void CProfiler::EndTick()
+{
+	if(!IsEnabled())
+		return;
+
+	for(CZone &Zone : ms_Zones)
+	{
+		const int Calls = Zone.m_TickCalls.exchange(0, std::memory_order_relaxed);
+		const int64_t Time = Zone.m_TickTime.exchange(0, std::memory_order_relaxed);
+		if(!Calls)
+			continue;
+
+		Zone.m_aWindow[Zone.m_WindowPos] = Time;
+		Zone.m_aCalls[Zone.m_WindowPos] = Calls;
+		Zone.m_WindowPos = (Zone.m_WindowPos + 1) % WINDOW_TICKS;
+		Zone.m_NumSamples = minimum(Zone.m_NumSamples + 1, (int)WINDOW_TICKS);
+	}
+}
+
+void CProfiler::Reset()
+{
+	for(CZone &Zone : ms_Zones)
+	{
+		Zone.m_TickTime.store(0, std::memory_order_relaxed);
+		Zone.m_TickCalls.store(0, std::memory_order_relaxed);
+		Zone.m_WindowPos = 0;
+		Zone.m_NumSamples = 0;
+	}
+}
+
+bool CProfiler::GetStats(const CZone *pZone, CStats *pStats)
+{
+	if(!pZone->m_NumSamples)
+		return false;
+
+	std::vector<int64_t> vSamples(pZone->m_aWindow, pZone->m_aWindow + pZone->m_NumSamples);
+	const auto Percentile = [&](int Percent) {
+		auto It = vSamples.begin() + (vSamples.size() - 1) * Percent / 100;
+		std::nth_element(vSamples.begin(), It, vSamples.end());
+		return *It;
+	};
+
+	int64_t NumCalls = 0;
+	for(int i = 0; i < pZone->m_NumSamples; i++)
+		NumCalls += pZone->m_aCalls[i];
+
+	pStats->m_NumTicks = pZone->m_NumSamples;
+	pStats->m_CallsPerTick = NumCalls / (float)pZone->m_NumSamples;
+	pStats->m_Median = Percentile(50);
+	pStats->m_Percentile99 = Percentile(99);
+	pStats->m_Max = *std::max_element(vSamples.begin(), vSamples.end());
+	return true;
+}
+
+void CProfiler::FormatStats(const CZone *pZone, const CStats &Stats, char *pBuf, int BufSize)
+{
+	str_format(pBuf, BufSize, "%s: p50 %.1fus p99 %.1fus max %.1fus, %.1f calls/tick over %d ticks",
+		pZone->m_aName, Stats.m_Median / 1000.0f, Stats.m_Percentile99 / 1000.0f, Stats.m_Max / 1000.0f,
+		Stats.m_CallsPerTick, Stats.m_NumTicks);
+}
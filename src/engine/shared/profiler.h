@@ -0,0 +1,101 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+// Measures the time spent in zones of the server tick. The time of each
+// zone is summed over a tick and the sums of the last WINDOW_TICKS ticks
+// the zone was entered in are kept. While the profiler is disabled the
+// scopes do not read the clock.
+class CProfiler
+{
+public:
+	enum
+	{
+		WINDOW_TICKS = 500,
+	};
+
+	class CZone
+	{
+		friend class CProfiler;
+
+		char m_aName[64];
+		std::atomic<int64_t> m_TickTime{0};
+		std::atomic<int> m_TickCalls{0};
+
+		int64_t m_aWindow[WINDOW_TICKS];
+		int m_aCalls[WINDOW_TICKS];
+		int m_WindowPos = 0;
+		int m_NumSamples = 0;
+
+	public:
+		const char *Name() const { return m_aName; }
+
+		// Thread-safe, the zones of the snapshot encoding are entered by the jobs
+		void Add(int64_t Nanoseconds)
+		{
+			m_TickTime.fetch_add(Nanoseconds, std::memory_order_relaxed);
+			m_TickCalls.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+
+	struct CStats
+	{
+		int m_NumTicks;
+		float m_CallsPerTick;
+		int64_t m_Median;
+		int64_t m_Percentile99;
+		int64_t m_Max;
+	};
+
+	// Returns the zone with this name, it is created on the first call
+	static CZone *Zone(const char *pName);
+
+	// Read by the snapshot jobs too
+	static bool IsEnabled() { return ms_Enabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool Enabled);
+
+	// Moves the times of the tick to the windows of the zones
+	static void EndTick();
+	static void Reset();
+
+	static int NumZones() { return ms_Zones.size(); }
+	static const CZone *GetZone(int Index) { return &ms_Zones[Index]; }
+	static bool GetStats(const CZone *pZone, CStats *pStats);
+
+	// "<name>: p50 <us> p99 <us> max <us>, <calls> calls/tick over <ticks> ticks"
+	static void FormatStats(const CZone *pZone, const CStats &Stats, char *pBuf, int BufSize);
+
+private:
+	static std::atomic<bool> ms_Enabled;
+	static std::deque<CZone> ms_Zones;
+};
+
+class CProfileScope
+{
+	CProfiler::CZone *m_pZone;
+	int64_t m_Start = 0;
+
+public:
+	explicit CProfileScope(CProfiler::CZone *pZone) :
+		m_pZone(CProfiler::IsEnabled() ? pZone : nullptr)
+	{
+		if(m_pZone)
+			m_Start = time_get_nanoseconds().count();
+	}
+
+	~CProfileScope()
+	{
+		if(m_pZone)
+			m_pZone->Add(time_get_nanoseconds().count() - m_Start);
+	}
+
+	CProfileScope(const CProfileScope &) = delete;
+	CProfileScope &operator=(const CProfileScope &) = delete;
+};
+
+#endif
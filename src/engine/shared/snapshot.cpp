@@ -7,6 +7,10 @@
 #include <climits>
 #include <cstdlib>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <base/math.h>
 #include <base/system.h>
 
@@ -200,9 +204,109 @@ static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
 	return -1;
 }
 
+// The hash list only indexes HASHLIST_BUCKET_SIZE items per bucket, the
+// other ones are treated as absent by the delta. The delta format does not
+// depend on it, but the generated deltas do.
+static bool HashlistOverflows(const CSnapshot *pSnapshot)
+{
+	if(pSnapshot->NumItems() <= HASHLIST_BUCKET_SIZE)
+		return false;
+
+	unsigned char aBucketSizes[HASHLIST_SIZE] = {0};
+	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	{
+		if(++aBucketSizes[CalcHashId(pSnapshot->GetItem(i)->Key())] > HASHLIST_BUCKET_SIZE)
+			return true;
+	}
+	return false;
+}
+
+// Finds for each item of pTo the index of the first item of pFrom with the
+// same key (-1 if none) and flags the items of pFrom whose key is in pTo
+static void MatchItemsHashlist(const CSnapshot *pFrom, const CSnapshot *pTo, int *pPastIndices, bool *pKept)
+{
+	CItemList aHashlist[HASHLIST_SIZE];
+	GenerateHash(aHashlist, pTo);
+	for(int i = 0; i < pFrom->NumItems(); i++)
+		pKept[i] = GetItemIndexHashed(pFrom->GetItem(i)->Key(), aHashlist) != -1;
+
+	GenerateHash(aHashlist, pFrom);
+	for(int i = 0; i < pTo->NumItems(); i++)
+		pPastIndices[i] = GetItemIndexHashed(pTo->GetItem(i)->Key(), aHashlist);
+}
+
+// Same as MatchItemsHashlist() for snapshots that do not overflow the hash
+// list, using a single open addressing table over the keys of pFrom
+static void MatchItems(const CSnapshot *pFrom, const CSnapshot *pTo, int *pPastIndices, bool *pKept)
+{
+	enum
+	{
+		MAX_SLOTS = CSnapshot::MAX_ITEMS * 2,
+	};
+
+	int Bits = 4;
+	while((1 << Bits) < pFrom->NumItems() * 2)
+		Bits++;
+	const unsigned Mask = (1u << Bits) - 1;
+
+	int aSlotKeys[MAX_SLOTS];
+	short aSlotIndices[MAX_SLOTS];
+	bool aSlotMatched[MAX_SLOTS];
+	short aFromSlots[CSnapshot::MAX_ITEMS];
+	for(unsigned Slot = 0; Slot <= Mask; Slot++)
+		aSlotIndices[Slot] = -1;
+
+	for(int i = 0; i < pFrom->NumItems(); i++)
+	{
+		const int Key = pFrom->GetItem(i)->Key();
+		unsigned Slot = ((unsigned)Key * 2654435761u) >> (32 - Bits);
+		while(aSlotIndices[Slot] != -1 && aSlotKeys[Slot] != Key)
+			Slot = (Slot + 1) & Mask;
+
+		// duplicated keys share the slot of the first item
+		if(aSlotIndices[Slot] == -1)
+		{
+			aSlotKeys[Slot] = Key;
+			aSlotIndices[Slot] = i;
+			aSlotMatched[Slot] = false;
+		}
+		aFromSlots[i] = Slot;
+	}
+
+	for(int i = 0; i < pTo->NumItems(); i++)
+	{
+		const int Key = pTo->GetItem(i)->Key();
+		unsigned Slot = ((unsigned)Key * 2654435761u) >> (32 - Bits);
+		while(aSlotIndices[Slot] != -1 && aSlotKeys[Slot] != Key)
+			Slot = (Slot + 1) & Mask;
+
+		pPastIndices[i] = aSlotIndices[Slot];
+		if(aSlotIndices[Slot] != -1)
+			aSlotMatched[Slot] = true;
+	}
+
+	for(int i = 0; i < pFrom->NumItems(); i++)
+		pKept[i] = aSlotMatched[aFromSlots[i]];
+}
+
 int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
+#if defined(__SSE2__)
+	__m128i Needed4 = _mm_setzero_si128();
+	for(; Size >= 4; Size -= 4)
+	{
+		const __m128i Diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)pCurrent), _mm_loadu_si128((const __m128i *)pPast));
+		_mm_storeu_si128((__m128i *)pOut, Diff);
+		Needed4 = _mm_or_si128(Needed4, Diff);
+		pOut += 4;
+		pPast += 4;
+		pCurrent += 4;
+	}
+	Needed4 = _mm_or_si128(Needed4, _mm_srli_si128(Needed4, 8));
+	Needed4 = _mm_or_si128(Needed4, _mm_srli_si128(Needed4, 4));
+	Needed = _mm_cvtsi128_si32(Needed4);
+#endif
 	while(Size)
 	{
 		// subtraction with wrapping by casting to unsigned
@@ -219,6 +323,35 @@ int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, i
 
 void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, int *pDataRate)
 {
+#if defined(__SSE2__)
+	// The data rate is 1 bit per unchanged int and 8 bits per byte of the
+	// packed diff otherwise, the packed size is computed like
+	// CVariableInt::Pack does: 6 bits in the first byte, 7 in the next ones
+	const __m128i Zero = _mm_setzero_si128();
+	__m128i DataRate4 = _mm_setzero_si128();
+	for(; Size >= 4; Size -= 4)
+	{
+		const __m128i Diff = _mm_loadu_si128((const __m128i *)pDiff);
+		_mm_storeu_si128((__m128i *)pOut, _mm_add_epi32(_mm_loadu_si128((const __m128i *)pPast), Diff));
+
+		const __m128i Folded = _mm_xor_si128(Diff, _mm_srai_epi32(Diff, 31));
+		__m128i Bytes = _mm_set1_epi32(1);
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Folded, _mm_set1_epi32((1 << 6) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Folded, _mm_set1_epi32((1 << 13) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Folded, _mm_set1_epi32((1 << 20) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Folded, _mm_set1_epi32((1 << 27) - 1)));
+		const __m128i IsZero = _mm_cmpeq_epi32(Diff, Zero);
+		const __m128i Bits = _mm_or_si128(_mm_and_si128(IsZero, _mm_set1_epi32(1)), _mm_andnot_si128(IsZero, _mm_slli_epi32(Bytes, 3)));
+		DataRate4 = _mm_add_epi32(DataRate4, Bits);
+
+		pOut += 4;
+		pPast += 4;
+		pDiff += 4;
+	}
+	DataRate4 = _mm_add_epi32(DataRate4, _mm_srli_si128(DataRate4, 8));
+	DataRate4 = _mm_add_epi32(DataRate4, _mm_srli_si128(DataRate4, 4));
+	*pDataRate += _mm_cvtsi128_si32(DataRate4);
+#endif
 	while(Size)
 	{
 		// addition with wrapping by casting to unsigned
@@ -268,8 +401,7 @@ const CSnapshotDelta::CData *CSnapshotDelta::EmptyDelta() const
 	return &m_Empty;
 }
 
-// TODO: OPT: this should be made much faster
-int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, CSnapshot *pTo, void *pDstData)
+int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData) const
 {
 	CData *pDelta = (CData *)pDstData;
 	int *pData = (int *)pDelta->m_aData;
@@ -278,14 +410,20 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, CSnapshot *pTo, void *pD
 	pDelta->m_NumUpdateItems = 0;
 	pDelta->m_NumTempItems = 0;
 
-	CItemList aHashlist[HASHLIST_SIZE];
-	GenerateHash(aHashlist, pTo);
+	// fetch previous indices
+	// we do this as a separate pass because it helps the cache
+	int aPastIndices[CSnapshot::MAX_ITEMS];
+	bool aKept[CSnapshot::MAX_ITEMS];
+	if(HashlistOverflows(pFrom) || HashlistOverflows(pTo))
+		MatchItemsHashlist(pFrom, pTo, aPastIndices, aKept);
+	else
+		MatchItems(pFrom, pTo, aPastIndices, aKept);
 
 	// pack deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
-		if(GetItemIndexHashed(pFromItem->Key(), aHashlist) == -1)
+		if(!aKept[i])
 		{
 			// deleted
 			pDelta->m_NumDeletedItems++;
@@ -294,18 +432,7 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, CSnapshot *pTo, void *pD
 		}
 	}
 
-	GenerateHash(aHashlist, pFrom);
-
-	// fetch previous indices
-	// we do this as a separate pass because it helps the cache
-	int aPastIndices[CSnapshot::MAX_ITEMS];
 	const int NumItems = pTo->NumItems();
-	for(int i = 0; i < NumItems; i++)
-	{
-		const CSnapshotItem *pCurItem = pTo->GetItem(i); // O(1) .. O(n)
-		aPastIndices[i] = GetItemIndexHashed(pCurItem->Key(), aHashlist); // O(n) .. O(n^n)
-	}
-
 	for(int i = 0; i < NumItems; i++)
 	{
 		// do delta
@@ -463,6 +590,13 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 
 // CSnapshotStorage
 
+int64_t CSnapshotStorage::ms_NumAllocations = 0;
+
+CSnapshotStorage::~CSnapshotStorage()
+{
+	free(m_pArena);
+}
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = 0;
@@ -471,18 +605,86 @@ void CSnapshotStorage::Init()
 
 void CSnapshotStorage::PurgeAll()
 {
-	CHolder *pHolder = m_pFirst;
+	// no more snapshots in storage, the arena is kept for the next ones
+	m_pFirst = 0;
+	m_pLast = 0;
+}
 
-	while(pHolder)
+int CSnapshotStorage::HolderAllocSize(int DataSize, int AltDataSize)
+{
+	const int Size = sizeof(CHolder) + DataSize + maximum(AltDataSize, 0);
+	const int Alignment = alignof(CHolder);
+	return (Size + Alignment - 1) / Alignment * Alignment;
+}
+
+void *CSnapshotStorage::Allocate(int Size)
+{
+	if(!m_pFirst)
 	{
-		CHolder *pNext = pHolder->m_pNext;
-		free(pHolder);
-		pHolder = pNext;
+		if(Size > m_ArenaSize)
+			Grow(Size);
+		return m_pArena;
 	}
 
-	// no more snapshots in storage
-	m_pFirst = 0;
-	m_pLast = 0;
+	const int Begin = HolderOffset(m_pFirst);
+	const int End = HolderOffset(m_pLast) + HolderAllocSize(m_pLast->m_SnapSize, m_pLast->m_AltSnapSize);
+	if(Begin < End)
+	{
+		// [Begin, End) is used, try the tail first then wrap around
+		if(End + Size <= m_ArenaSize)
+			return m_pArena + End;
+		if(Size <= Begin)
+			return m_pArena;
+	}
+	else if(End + Size <= Begin)
+	{
+		// wrapped, the free space is [End, Begin)
+		return m_pArena + End;
+	}
+
+	Grow(Size);
+	return m_pArena + HolderOffset(m_pLast) + HolderAllocSize(m_pLast->m_SnapSize, m_pLast->m_AltSnapSize);
+}
+
+void CSnapshotStorage::Grow(int MinFreeSize)
+{
+	int UsedSize = 0;
+	for(CHolder *pHolder = m_pFirst; pHolder; pHolder = pHolder->m_pNext)
+		UsedSize += HolderAllocSize(pHolder->m_SnapSize, pHolder->m_AltSnapSize);
+
+	int NewSize = maximum((int)MIN_ARENA_SIZE, m_ArenaSize * 2);
+	while(NewSize < UsedSize + MinFreeSize)
+		NewSize *= 2;
+
+	// move the kept snapshots to the beginning of the new arena
+	char *pNewArena = (char *)malloc(NewSize);
+	ms_NumAllocations++;
+
+	CHolder *pPrev = 0;
+	int Offset = 0;
+	for(CHolder *pHolder = m_pFirst; pHolder; pHolder = pHolder->m_pNext)
+	{
+		const int HolderSize = HolderAllocSize(pHolder->m_SnapSize, pHolder->m_AltSnapSize);
+		CHolder *pNewHolder = (CHolder *)(pNewArena + Offset);
+		mem_copy(pNewHolder, pHolder, HolderSize);
+		pNewHolder->m_pSnap = (CSnapshot *)(pNewHolder + 1);
+		if(pHolder->m_pAltSnap)
+			pNewHolder->m_pAltSnap = (CSnapshot *)(((char *)pNewHolder->m_pSnap) + pNewHolder->m_SnapSize);
+		pNewHolder->m_pPrev = pPrev;
+		pNewHolder->m_pNext = 0;
+		if(pPrev)
+			pPrev->m_pNext = pNewHolder;
+		else
+			m_pFirst = pNewHolder;
+		m_pLast = pNewHolder;
+
+		pPrev = pNewHolder;
+		Offset += HolderSize;
+	}
+
+	free(m_pArena);
+	m_pArena = pNewArena;
+	m_ArenaSize = NewSize;
 }
 
 void CSnapshotStorage::PurgeUntil(int Tick)
@@ -494,7 +696,6 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 		CHolder *pNext = pHolder->m_pNext;
 		if(pHolder->m_Tick >= Tick)
 			return; // no more to remove
-		free(pHolder);
 
 		// did we come to the end of the list?
 		if(!pNext)
@@ -514,14 +715,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 void CSnapshotStorage::Add(int Tick, int64_t Tagtime, int DataSize, const void *pData, int AltDataSize, const void *pAltData)
 {
 	// allocate memory for holder + snapshot_data
-	int TotalSize = sizeof(CHolder) + DataSize;
-
-	if(AltDataSize > 0)
-	{
-		TotalSize += AltDataSize;
-	}
-
-	CHolder *pHolder = (CHolder *)malloc(TotalSize);
+	CHolder *pHolder = (CHolder *)Allocate(HolderAllocSize(DataSize, AltDataSize));
 
 	// set data
 	pHolder->m_Tick = Tick;
@@ -97,7 +97,7 @@ public:
 	int GetDataUpdates(int Index) const { return m_aSnapshotDataUpdates[Index]; }
 	void SetStaticsize(int ItemType, int Size);
 	const CData *EmptyDelta() const;
-	int CreateDelta(const class CSnapshot *pFrom, class CSnapshot *pTo, void *pDstData);
+	int CreateDelta(const class CSnapshot *pFrom, const class CSnapshot *pTo, void *pDstData) const;
 	int UnpackDelta(const class CSnapshot *pFrom, class CSnapshot *pTo, const void *pSrcData, int DataSize);
 };
 
@@ -126,12 +126,38 @@ public:
 	CHolder *m_pLast;
 
 	CSnapshotStorage() { Init(); }
-	~CSnapshotStorage() { PurgeAll(); }
+	~CSnapshotStorage();
+	CSnapshotStorage(const CSnapshotStorage &) = delete;
+	CSnapshotStorage &operator=(const CSnapshotStorage &) = delete;
+
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, int DataSize, const void *pData, int AltDataSize, const void *pAltData);
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData);
+
+	int ArenaSize() const { return m_ArenaSize; }
+	// Number of arena (re)allocations done by all the storages
+	static int64_t NumAllocations() { return ms_NumAllocations; }
+
+private:
+	enum
+	{
+		MIN_ARENA_SIZE = 64 * 1024,
+	};
+
+	// The holders are allocated in FIFO order from a ring arena, which only
+	// grows when the kept history does not fit anymore. The storage is
+	// thus allocation free once the history reached its usual size.
+	char *m_pArena = nullptr;
+	int m_ArenaSize = 0;
+
+	static int HolderAllocSize(int DataSize, int AltDataSize);
+	int HolderOffset(const CHolder *pHolder) const { return (const char *)pHolder - m_pArena; }
+	void *Allocate(int Size);
+	void Grow(int MinFreeSize);
+
+	static int64_t ms_NumAllocations;
 };
 
 class CSnapshotBuilder
@@ -63,6 +63,7 @@ void CCollision::Init(class CLayers *pLayers)
 	m_Height = m_pLayers->GameLayer()->m_Height;
 	m_pTiles = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data));
 
+	InitSolidSums();
 	InitTeleports();
 
 	if(m_pLayers->SpeedupLayer())
@@ -73,6 +74,78 @@ void CCollision::Init(class CLayers *pLayers)
 	}
 }
 
+void CCollision::InitSolidSums()
+{
+	const int Stride = m_Width + 1;
+	m_vSolidSums.assign((size_t)Stride * (m_Height + 1), 0);
+	for(int y = 0; y < m_Height; y++)
+	{
+		int RowSum = 0;
+		for(int x = 0; x < m_Width; x++)
+		{
+			const int Index = m_pTiles[y * m_Width + x].m_Index;
+			RowSum += Index == TILE_SOLID || Index == TILE_NOHOOK;
+			m_vSolidSums[(y + 1) * Stride + x + 1] = m_vSolidSums[y * Stride + x + 1] + RowSum;
+		}
+	}
+}
+
+// The tile coordinates are clamped like GetTile() does, so the border tiles
+// also cover the positions outside of the map
+bool CCollision::IsTileAreaFree(float TileX0, float TileY0, float TileX1, float TileY1) const
+{
+	if(!m_pTiles)
+		return true;
+
+	const int X0 = clamp(TileX0, 0.0f, m_Width - 1.0f);
+	const int Y0 = clamp(TileY0, 0.0f, m_Height - 1.0f);
+	const int X1 = clamp(TileX1, 0.0f, m_Width - 1.0f) + 1;
+	const int Y1 = clamp(TileY1, 0.0f, m_Height - 1.0f) + 1;
+	const int Stride = m_Width + 1;
+	return m_vSolidSums[Y1 * Stride + X1] - m_vSolidSums[Y0 * Stride + X1] - m_vSolidSums[Y1 * Stride + X0] + m_vSolidSums[Y0 * Stride + X0] == 0;
+}
+
+// Whether CheckPoint() is false for every position in the area. One pixel
+// of margin covers the rounding of CheckPoint().
+bool CCollision::IsAreaFree(vec2 Min, vec2 Max) const
+{
+	// also rejects NaN
+	if(!(Min.x <= Max.x && Min.y <= Max.y))
+		return false;
+
+	return IsTileAreaFree(std::floor((Min.x - 1.0f) / 32.0f), std::floor((Min.y - 1.0f) / 32.0f),
+		std::floor((Max.x + 1.0f) / 32.0f), std::floor((Max.y + 1.0f) / 32.0f));
+}
+
+// Traversal step for IntersectLine(): returns the index of the first sample
+// which might leave the tile of the sample Pos, or 0 if the tiles around it
+// are not all free. The samples before it can not collide.
+int CCollision::FreeSamplesEnd(vec2 Pos0, vec2 Pos1Pos0, float Distance, vec2 Pos, int End) const
+{
+	const float TileX = std::floor(Pos.x / 32.0f);
+	const float TileY = std::floor(Pos.y / 32.0f);
+	if(!(TileX == TileX && TileY == TileY) || !IsTileAreaFree(TileX - 1, TileY - 1, TileX + 1, TileY + 1))
+		return 0;
+
+	// parameter of the line where it leaves the tile
+	float Exit = 2.0f;
+	if(Pos1Pos0.x > 0)
+		Exit = minimum(Exit, ((TileX + 1) * 32.0f - Pos0.x) / Pos1Pos0.x);
+	else if(Pos1Pos0.x < 0)
+		Exit = minimum(Exit, (TileX * 32.0f - Pos0.x) / Pos1Pos0.x);
+	if(Pos1Pos0.y > 0)
+		Exit = minimum(Exit, ((TileY + 1) * 32.0f - Pos0.y) / Pos1Pos0.y);
+	else if(Pos1Pos0.y < 0)
+		Exit = minimum(Exit, (TileY * 32.0f - Pos0.y) / Pos1Pos0.y);
+
+	// the samples are one pixel apart, keep one of them as margin for the
+	// rounding errors
+	const float Next = Exit * Distance - 1.0f;
+	if(Next >= End)
+		return End;
+	return maximum((int)Next, 0);
+}
+
 void CCollision::InitTeleports()
 {
 	if(!m_pLayers->TeleLayer())
@@ -233,7 +306,6 @@ int CCollision::GetTile(int x, int y) const
 	return 0;
 }
 
-// TODO: rewrite this smarter!
 int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	vec2 Pos1Pos0 = Pos1 - Pos0;
@@ -245,6 +317,19 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 	{
 		float a = i/Distance;
 		vec2 Pos = Pos0 + Pos1Pos0 * a;
+
+		// The samples are still one pixel apart. When the tile of the sample
+		// and its neighbours are free, skip to the last sample before the
+		// line leaves that tile, none of the skipped samples can hit.
+		const int Free = FreeSamplesEnd(Pos0, Pos1Pos0, Distance, Pos, End);
+		if(Free > i + 1)
+		{
+			i = Free - 1;
+			a = i/Distance;
+			Last = Pos0 + Pos1Pos0 * a;
+			continue;
+		}
+
 		if(CheckPoint(Pos.x, Pos.y))
 		{
 			if(pOutCollision)
@@ -362,6 +447,29 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elast
 		float ElasticityX = clamp(Elasticity.x, -1.0f, 1.0f);
 		float ElasticityY = clamp(Elasticity.y, -1.0f, 1.0f);
 
+		// Swept box test: when the box can not touch a solid tile during the
+		// whole move, do the same steps without testing the box. The margin
+		// covers the rounding errors of the steps.
+		const vec2 Margin = Size * 0.5f + vec2(2.0f, 2.0f);
+		const vec2 SweptMin = vec2(minimum(Pos.x, Pos.x + Vel.x), minimum(Pos.y, Pos.y + Vel.y)) - Margin;
+		const vec2 SweptMax = vec2(maximum(Pos.x, Pos.x + Vel.x), maximum(Pos.y, Pos.y + Vel.y)) + Margin;
+		if(IsAreaFree(SweptMin, SweptMax))
+		{
+			for(int i = 0; i <= Max; i++)
+			{
+				vec2 NewPos = Pos + Vel*Fraction;
+				if(NewPos == Pos)
+				{
+					break;
+				}
+				Pos = NewPos;
+			}
+
+			*pInoutPos = Pos;
+			*pInoutVel = Vel;
+			return;
+		}
+
 		for(int i = 0; i <= Max; i++)
 		{
 			// Early break as optimization to stop checking for collisions for
@@ -427,6 +535,9 @@ void CCollision::Dest()
 	m_pTiles = 0;
 	m_Width = 0;
 	m_Height = 0;
+	m_vSolidSums.clear();
+	m_Zones.clear();
+	m_vZoneLookups.clear();
 	m_pLayers = 0;
 	m_pTele = 0;
 	m_pSpeedup = 0;
@@ -568,6 +679,9 @@ int CCollision::GetZoneHandle(const char* pName)
 				LayerList.add(l);
 		}
 	}
+
+	m_vZoneLookups.emplace_back();
+	InitZoneLookup(Handle);
 	
 	return Handle;
 }
@@ -698,6 +812,178 @@ struct SAnimationTransformCache
 	int PosEnv = -1;
 };
 
+static void GetQuadPoints(const CQuad &Quad, vec2 Position, float Angle, vec2 *pPoints)
+{
+	for(int i = 0; i < 4; i++)
+		pPoints[i] = Position + vec2(fx2f(Quad.m_aPoints[i].x), fx2f(Quad.m_aPoints[i].y));
+
+	if(Angle != 0)
+	{
+		vec2 center(fx2f(Quad.m_aPoints[4].x), fx2f(Quad.m_aPoints[4].y));
+		for(int i = 0; i < 4; i++)
+			Rotate(&center, &pPoints[i], Angle);
+	}
+}
+
+static bool QuadContains(const vec2 *pPoints, float x, float y)
+{
+	if(OutOfRange(x, pPoints[0].x, pPoints[1].x, pPoints[2].x, pPoints[3].x))
+		return false;
+	if(OutOfRange(y, pPoints[0].y, pPoints[1].y, pPoints[2].y, pPoints[3].y))
+		return false;
+
+	return InsideQuad(pPoints[0], pPoints[1], pPoints[2], pPoints[3], vec2(x, y));
+}
+
+void CCollision::InitZoneQuad(const CQuad &Quad, vec2 Position, float Angle, int64_t Order, CZoneQuad *pOut)
+{
+	GetQuadPoints(Quad, Position, Angle, pOut->m_aPoints);
+	pOut->m_Min = pOut->m_Max = pOut->m_aPoints[0];
+	for(int i = 1; i < 4; i++)
+	{
+		pOut->m_Min.x = minimum(pOut->m_Min.x, pOut->m_aPoints[i].x);
+		pOut->m_Min.y = minimum(pOut->m_Min.y, pOut->m_aPoints[i].y);
+		pOut->m_Max.x = maximum(pOut->m_Max.x, pOut->m_aPoints[i].x);
+		pOut->m_Max.y = maximum(pOut->m_Max.y, pOut->m_aPoints[i].y);
+	}
+	pOut->m_Index = Quad.m_ColorEnvOffset;
+	pOut->m_ExtraData = Quad.m_aColors[0].g;
+	pOut->m_Order = Order;
+}
+
+void CCollision::InitZoneLookup(int ZoneHandle)
+{
+	CZoneLookup &Lookup = m_vZoneLookups[ZoneHandle];
+	Lookup = CZoneLookup();
+	Lookup.m_Width = m_Width;
+	Lookup.m_Height = m_Height;
+
+	struct CLayerRef
+	{
+		int m_Layer;
+		const CMapItemLayerTilemap *m_pTLayer;
+		const CTile *m_pTiles;
+		int m_QuadsBegin;
+		int m_QuadsEnd;
+	};
+	std::vector<CLayerRef> vLayers;
+
+	for(int i = 0; i < m_Zones[ZoneHandle].size(); i++)
+	{
+		int l = m_Zones[ZoneHandle][i];
+		const int64_t Order = (int64_t)l << 32;
+
+		CMapItemLayer *pLayer = m_pLayers->GetLayer(m_pLayers->ZoneGroup()->m_StartLayer+l);
+		if(pLayer->m_Type == LAYERTYPE_TILES)
+		{
+			CMapItemLayerTilemap *pTLayer = (CMapItemLayerTilemap *)pLayer;
+			const CTile *pTiles = (const CTile *) m_pLayers->Map()->GetData(pTLayer->m_Data);
+			vLayers.push_back({l, pTLayer, pTiles, 0, 0});
+			Lookup.m_Width = maximum(Lookup.m_Width, pTLayer->m_Width);
+			Lookup.m_Height = maximum(Lookup.m_Height, pTLayer->m_Height);
+		}
+		else if(pLayer->m_Type == LAYERTYPE_QUADS)
+		{
+			CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
+			const CQuad *pQuads = (const CQuad *) m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
+
+			CLayerRef Ref = {l, nullptr, nullptr, (int)Lookup.m_vStaticQuads.size(), 0};
+			for(int q = 0; q < pQLayer->m_NumQuads; q++)
+			{
+				if(pQuads[q].m_PosEnv >= 0)
+				{
+					CAnimatedZoneQuad Animated;
+					Animated.m_pQuad = &pQuads[q];
+					Animated.m_Transformed.m_Order = Order | q;
+					Lookup.m_vAnimatedQuads.push_back(Animated);
+					continue;
+				}
+
+				CZoneQuad Quad;
+				InitZoneQuad(pQuads[q], vec2(0.0f, 0.0f), 0.0f, Order | q, &Quad);
+				Lookup.m_vStaticQuads.push_back(Quad);
+			}
+			Ref.m_QuadsEnd = Lookup.m_vStaticQuads.size();
+			vLayers.push_back(Ref);
+		}
+	}
+
+	const int Width = Lookup.m_Width;
+	const int Height = Lookup.m_Height;
+	if(Width <= 0 || Height <= 0)
+		return;
+
+	// Calls Emit(Cell, Item) in layer order, first to count the items per cell, then to fill them
+	auto ForEachItem = [&](auto &&Emit) {
+		for(const CLayerRef &Layer : vLayers)
+		{
+			const int64_t Order = (int64_t)Layer.m_Layer << 32;
+			if(Layer.m_pTLayer)
+			{
+				const int TWidth = Layer.m_pTLayer->m_Width;
+				const int THeight = Layer.m_pTLayer->m_Height;
+				for(int y = 0; y < Height; y++)
+				{
+					for(int x = 0; x < Width; x++)
+					{
+						int TileIndex = Layer.m_pTiles[clamp(y, 0, THeight-1)*TWidth+clamp(x, 0, TWidth-1)].m_Index;
+						if(TileIndex > 0 && TileIndex <= 128)
+							Emit(y*Width+x, CZoneCellItem{-1, TileIndex, Order});
+					}
+				}
+				continue;
+			}
+
+			for(int q = Layer.m_QuadsBegin; q < Layer.m_QuadsEnd; q++)
+			{
+				const CZoneQuad &Quad = Lookup.m_vStaticQuads[q];
+				// A cell holds the positions rounding to its tile, keep a wide margin
+				const int X0 = (int)std::floor((Quad.m_Min.x - 64.0f) / 32.0f);
+				const int X1 = (int)std::floor((Quad.m_Max.x + 64.0f) / 32.0f);
+				const int Y0 = (int)std::floor((Quad.m_Min.y - 64.0f) / 32.0f);
+				const int Y1 = (int)std::floor((Quad.m_Max.y + 64.0f) / 32.0f);
+				if(X1 < 0 || Y1 < 0 || X0 >= Width || Y0 >= Height)
+					continue;
+
+				for(int y = maximum(Y0, 0); y <= minimum(Y1, Height-1); y++)
+				{
+					for(int x = maximum(X0, 0); x <= minimum(X1, Width-1); x++)
+						Emit(y*Width+x, CZoneCellItem{q, 0, Quad.m_Order});
+				}
+			}
+		}
+	};
+
+	Lookup.m_vCellStart.assign(Width*Height+1, 0);
+	ForEachItem([&](int Cell, const CZoneCellItem &) { Lookup.m_vCellStart[Cell+1]++; });
+	for(int i = 0; i < Width*Height; i++)
+		Lookup.m_vCellStart[i+1] += Lookup.m_vCellStart[i];
+
+	Lookup.m_vItems.resize(Lookup.m_vCellStart.back());
+	std::vector<int> vFill(Lookup.m_vCellStart.begin(), Lookup.m_vCellStart.end()-1);
+	ForEachItem([&](int Cell, const CZoneCellItem &Item) { Lookup.m_vItems[vFill[Cell]++] = Item; });
+}
+
+void CCollision::UpdateAnimatedZoneQuads(CZoneLookup *pLookup)
+{
+	if(pLookup->m_AnimatedValid && pLookup->m_AnimatedTime == m_Time)
+		return;
+
+	pLookup->m_AnimatedValid = true;
+	pLookup->m_AnimatedTime = m_Time;
+
+	SAnimationTransformCache AnimationCache;
+	for(CAnimatedZoneQuad &Animated : pLookup->m_vAnimatedQuads)
+	{
+		if(Animated.m_pQuad->m_PosEnv != AnimationCache.PosEnv)
+		{
+			AnimationCache.PosEnv = Animated.m_pQuad->m_PosEnv;
+			GetAnimationTransform(m_Time, AnimationCache.PosEnv, m_pLayers, AnimationCache.Position, AnimationCache.Angle);
+		}
+		InitZoneQuad(*Animated.m_pQuad, AnimationCache.Position, AnimationCache.Angle, Animated.m_Transformed.m_Order, &Animated.m_Transformed);
+	}
+}
+
 int CCollision::GetZoneValueAt(int ZoneHandle, float x, float y, ZoneData *pData)
 {
 	if(!m_pLayers->ZoneGroup())
@@ -705,7 +991,76 @@ int CCollision::GetZoneValueAt(int ZoneHandle, float x, float y, ZoneData *pData
 	
 	if(ZoneHandle < 0 || ZoneHandle >= m_Zones.size())
 		return 0;
-	
+
+	CZoneLookup &Lookup = m_vZoneLookups[ZoneHandle];
+	const int Cx = round_to_int(x)/32;
+	const int Cy = round_to_int(y)/32;
+	if(Cx < 0 || Cx >= Lookup.m_Width || Cy < 0 || Cy >= Lookup.m_Height)
+		return GetZoneValueAtSlow(ZoneHandle, x, y, pData);
+
+	// A later layer or quad overrides the earlier ones, the orders keep
+	// track of that when merging the animated quads in
+	int Index = 0;
+	int ExtraData = 0;
+	int64_t IndexOrder = -1;
+	int64_t ExtraDataOrder = -1;
+
+	const int Cell = Cy*Lookup.m_Width+Cx;
+	for(int i = Lookup.m_vCellStart[Cell]; i < Lookup.m_vCellStart[Cell+1]; i++)
+	{
+		const CZoneCellItem &Item = Lookup.m_vItems[i];
+		if(Item.m_Quad < 0)
+		{
+			Index = Item.m_TileIndex;
+			IndexOrder = Item.m_Order;
+			continue;
+		}
+
+		const CZoneQuad &Quad = Lookup.m_vStaticQuads[Item.m_Quad];
+		if(QuadContains(Quad.m_aPoints, x, y))
+		{
+			Index = Quad.m_Index;
+			ExtraData = Quad.m_ExtraData;
+			IndexOrder = ExtraDataOrder = Quad.m_Order;
+		}
+	}
+
+	if(!Lookup.m_vAnimatedQuads.empty())
+	{
+		UpdateAnimatedZoneQuads(&Lookup);
+		for(const CAnimatedZoneQuad &Animated : Lookup.m_vAnimatedQuads)
+		{
+			const CZoneQuad &Quad = Animated.m_Transformed;
+			if(x < Quad.m_Min.x || x > Quad.m_Max.x || y < Quad.m_Min.y || y > Quad.m_Max.y)
+				continue;
+			if(!QuadContains(Quad.m_aPoints, x, y))
+				continue;
+
+			if(Quad.m_Order > IndexOrder)
+			{
+				Index = Quad.m_Index;
+				IndexOrder = Quad.m_Order;
+			}
+			if(Quad.m_Order > ExtraDataOrder)
+			{
+				ExtraData = Quad.m_ExtraData;
+				ExtraDataOrder = Quad.m_Order;
+			}
+		}
+	}
+
+	if(pData)
+	{
+		pData->Index = Index;
+		pData->ExtraData = ExtraData;
+	}
+
+	return Index;
+}
+
+// Same as GetZoneValueAt() for the positions outside of the lookup grid
+int CCollision::GetZoneValueAtSlow(int ZoneHandle, float x, float y, ZoneData *pData)
+{
 	int Index = 0;
 	int ExtraData = 0;
 
@@ -751,26 +1106,9 @@ int CCollision::GetZoneValueAt(int ZoneHandle, float x, float y, ZoneData *pData
 					Angle = AnimationCache.Angle;
 				}
 				
-				vec2 p0 = Position + vec2(fx2f(pQuads[q].m_aPoints[0].x), fx2f(pQuads[q].m_aPoints[0].y));
-				vec2 p1 = Position + vec2(fx2f(pQuads[q].m_aPoints[1].x), fx2f(pQuads[q].m_aPoints[1].y));
-				vec2 p2 = Position + vec2(fx2f(pQuads[q].m_aPoints[2].x), fx2f(pQuads[q].m_aPoints[2].y));
-				vec2 p3 = Position + vec2(fx2f(pQuads[q].m_aPoints[3].x), fx2f(pQuads[q].m_aPoints[3].y));
-				
-				if(Angle != 0)
-				{
-					vec2 center(fx2f(pQuads[q].m_aPoints[4].x), fx2f(pQuads[q].m_aPoints[4].y));
-					Rotate(&center, &p0, Angle);
-					Rotate(&center, &p1, Angle);
-					Rotate(&center, &p2, Angle);
-					Rotate(&center, &p3, Angle);
-				}
-
-				if(OutOfRange(x, p0.x, p1.x, p2.x, p3.x))
-					continue;
-				if(OutOfRange(y, p0.y, p1.y, p2.y, p3.y))
-					continue;
-				
-				if(InsideQuad(p0, p1, p2, p3, vec2(x, y)))
+				vec2 aPoints[4];
+				GetQuadPoints(pQuads[q], Position, Angle, aPoints);
+				if(QuadContains(aPoints, x, y))
 				{
 					Index = pQuads[q].m_ColorEnvOffset;
 					ExtraData = pQuads[q].m_aColors[0].g;
@@ -6,6 +6,7 @@
 #include <base/vmath.h>
 #include <base/tl/array.h>
 
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -38,9 +39,61 @@ class CCollision
 	
 	array< array<int> > m_Zones;
 
+	// Zone layers of a handle indexed per tile. Every cell lists the tile
+	// values and static quads touching it in layer order; quads moved by an
+	// envelope are transformed once per game time and tested separately.
+	struct CZoneQuad
+	{
+		vec2 m_aPoints[4];
+		vec2 m_Min;
+		vec2 m_Max;
+		int m_Index;
+		int m_ExtraData;
+		int64_t m_Order;
+	};
+
+	struct CZoneCellItem
+	{
+		int m_Quad; // -1 for a tile value
+		int m_TileIndex;
+		int64_t m_Order;
+	};
+
+	struct CAnimatedZoneQuad
+	{
+		const struct CQuad *m_pQuad;
+		CZoneQuad m_Transformed;
+	};
+
+	struct CZoneLookup
+	{
+		int m_Width = 0;
+		int m_Height = 0;
+		std::vector<int> m_vCellStart;
+		std::vector<CZoneCellItem> m_vItems;
+		std::vector<CZoneQuad> m_vStaticQuads;
+		std::vector<CAnimatedZoneQuad> m_vAnimatedQuads;
+		double m_AnimatedTime = 0.0;
+		bool m_AnimatedValid = false;
+	};
+	std::vector<CZoneLookup> m_vZoneLookups;
+
+	static void InitZoneQuad(const struct CQuad &Quad, vec2 Position, float Angle, int64_t Order, CZoneQuad *pOut);
+	void InitZoneLookup(int ZoneHandle);
+	void UpdateAnimatedZoneQuads(CZoneLookup *pLookup);
+	int GetZoneValueAtSlow(int ZoneHandle, float x, float y, ZoneData *pData);
+
 	bool IsSolid(int x, int y) const;
 	int GetTile(int x, int y) const;
 
+	// Summed area table of the solid tiles, (m_Width + 1) * (m_Height + 1)
+	std::vector<int> m_vSolidSums;
+
+	void InitSolidSums();
+	bool IsTileAreaFree(float TileX0, float TileY0, float TileX1, float TileY1) const;
+	bool IsAreaFree(vec2 Min, vec2 Max) const;
+	int FreeSamplesEnd(vec2 Pos0, vec2 Pos1Pos0, float Distance, vec2 Pos, int End) const;
+
 public:
 	enum
 	{
@@ -492,18 +492,64 @@ void CCharacterCore::Move(CParams* pParams)
 		if(Distance > 0)
 		{
 			int End = Distance + 1;
+
+			// Broadphase: collect the cores the swept circle can reach, each
+			// with a conservative range of steps in which it can be hit. The
+			// cores keep the client id order so the first hit is unchanged.
+			const float Reach = 28.0f + 1.0f;
+			const vec2 Delta = NewPos - m_Pos;
+			int aCandidates[MAX_CLIENTS];
+			int aFirstStep[MAX_CLIENTS];
+			int aLastStep[MAX_CLIENTS];
+			int NumCandidates = 0;
+			int FirstStep = End;
+			int LastStep = -1;
+			for(int p = 0; p < MAX_CLIENTS; p++)
+			{
+				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
+				if(!pCharCore || pCharCore == this)
+					continue;
+				if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
+					continue;
+
+				// Solve |m_Pos + Delta * a - Core| < Reach for a
+				const vec2 ToCore = pCharCore->m_Pos - m_Pos;
+				const double A = (double)Delta.x * Delta.x + (double)Delta.y * Delta.y;
+				const double B = (double)Delta.x * ToCore.x + (double)Delta.y * ToCore.y;
+				const double C = (double)ToCore.x * ToCore.x + (double)ToCore.y * ToCore.y - Reach * Reach;
+				const double Disc = B * B - A * C;
+				// Also drops NaN positions which never pass the distance check
+				if(!(Disc >= 0.0))
+					continue;
+				const double Root = std::sqrt(Disc);
+				const double From = (B - Root) / A * Distance;
+				const double To = (B + Root) / A * Distance;
+				if(To < -1.0 || From > End)
+					continue;
+
+				aCandidates[NumCandidates] = p;
+				aFirstStep[NumCandidates] = maximum(0, (int)std::floor(maximum(From, 0.0)) - 1);
+				aLastStep[NumCandidates] = minimum(End - 1, (int)std::ceil(minimum(To, (double)End)) + 1);
+				FirstStep = minimum(FirstStep, aFirstStep[NumCandidates]);
+				LastStep = maximum(LastStep, aLastStep[NumCandidates]);
+				NumCandidates++;
+			}
+
 			vec2 LastPos = m_Pos;
-			for(int i = 0; i < End; i++)
+			if(FirstStep > 0 && FirstStep <= LastStep)
+			{
+				float a = (FirstStep - 1) / Distance;
+				LastPos = mix(m_Pos, NewPos, a);
+			}
+			for(int i = FirstStep; i <= LastStep; i++)
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int c = 0; c < NumCandidates; c++)
 				{
-					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-					if(!pCharCore || pCharCore == this)
-						continue;
-					if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
+					if(i < aFirstStep[c] || i > aLastStep[c])
 						continue;
+					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[aCandidates[c]];
 					float D = distance(Pos, pCharCore->m_Pos);
 					if(D < 28.0f && D >= 0.0f)
 					{
@@ -0,0 +1,75 @@
+#include "growing_map.h"
+
+#include <game/collision.h>
+
+#include <algorithm>
+
+void CGrowingMap::Init(const CCollision *pCollision, vec2 SeedPos, int Radius, int SeedTick)
+{
+	m_Radius = Radius;
+	m_Length = 2 * Radius + 1;
+	m_SeedX = static_cast<int>(round(SeedPos.x)) / 32;
+	m_SeedY = static_cast<int>(round(SeedPos.y)) / 32;
+
+	m_vCells.resize(m_Length * m_Length);
+	for(int j = 0; j < m_Length; j++)
+	{
+		for(int i = 0; i < m_Length; i++)
+		{
+			vec2 Tile = SeedPos + vec2(32.0f * (i - Radius), 32.0f * (j - Radius));
+			if(pCollision->CheckPoint(Tile) || distance(Tile, SeedPos) > Radius * 32.0f)
+				m_vCells[j * m_Length + i] = CELL_BLOCKED;
+			else
+				m_vCells[j * m_Length + i] = CELL_FREE;
+		}
+	}
+
+	const int SeedCell = Radius * m_Length + Radius;
+	m_vCells[SeedCell] = SeedTick;
+
+	// Breadth first search from the seed, the queue holds the layers one
+	// after another
+	std::vector<bool> vQueued(m_vCells.size(), false);
+	m_vLayerCells.clear();
+	m_vLayerStart.clear();
+	m_vLayerCells.push_back(SeedCell);
+	vQueued[SeedCell] = true;
+	m_vLayerStart.push_back(0);
+
+	std::size_t LayerBegin = 0;
+	while(LayerBegin < m_vLayerCells.size())
+	{
+		const std::size_t LayerEnd = m_vLayerCells.size();
+		m_vLayerStart.push_back(LayerEnd);
+		for(std::size_t c = LayerBegin; c < LayerEnd; c++)
+		{
+			const int Cell = m_vLayerCells[c];
+			const int i = Cell % m_Length;
+			const int j = Cell / m_Length;
+			const int aNeighbors[4] = {
+				i > 0 ? Cell - 1 : -1,
+				i < m_Length - 1 ? Cell + 1 : -1,
+				j > 0 ? Cell - m_Length : -1,
+				j < m_Length - 1 ? Cell + m_Length : -1,
+			};
+			for(int Neighbor : aNeighbors)
+			{
+				if(Neighbor < 0 || vQueued[Neighbor] || m_vCells[Neighbor] != CELL_FREE)
+					continue;
+				vQueued[Neighbor] = true;
+				m_vLayerCells.push_back(Neighbor);
+			}
+		}
+		std::sort(m_vLayerCells.begin() + LayerEnd, m_vLayerCells.end());
+		LayerBegin = LayerEnd;
+	}
+}
+
+int CGrowingMap::CellAt(vec2 Pos) const
+{
+	int TileX = m_Radius + static_cast<int>(round(Pos.x)) / 32 - m_SeedX;
+	int TileY = m_Radius + static_cast<int>(round(Pos.y)) / 32 - m_SeedY;
+	if(TileX < 0 || TileX >= m_Length || TileY < 0 || TileY >= m_Length)
+		return -1;
+	return TileY * m_Length + TileX;
+}
@@ -0,0 +1,51 @@
+#ifndef INFCLASS_GROWING_MAP_H
+#define INFCLASS_GROWING_MAP_H
+
+#include <base/vmath.h>
+
+#include <vector>
+
+class CCollision;
+
+// Tiles around the seed of a growing explosion. The explosion grows by one
+// tile per tick, so the free tiles reachable in N steps are grouped into
+// the layer N once, and a growth step only walks that layer.
+class CGrowingMap
+{
+public:
+	enum
+	{
+		CELL_BLOCKED = -2,
+		CELL_FREE = -1,
+	};
+
+	void Init(const CCollision *pCollision, vec2 SeedPos, int Radius, int SeedTick);
+
+	int Length() const { return m_Length; }
+	int NumCells() const { return m_vCells.size(); }
+
+	// The cell of the tile containing Pos, -1 if it is outside of the map
+	int CellAt(vec2 Pos) const;
+	vec2 CellOffset(int Cell) const { return vec2(32.0f * (Cell % m_Length - m_Radius), 32.0f * (Cell / m_Length - m_Radius)); }
+
+	// The tick a cell was reached at, or CELL_BLOCKED/CELL_FREE
+	int CellTick(int Cell) const { return m_vCells[Cell]; }
+	void SetCellTick(int Cell, int Tick) { m_vCells[Cell] = Tick; }
+
+	// The layer 0 is the seed. The cells of a layer are sorted by index,
+	// the order of a full row by row scan.
+	int NumLayers() const { return (int)m_vLayerStart.size() - 1; }
+	const int *LayerBegin(int Layer) const { return m_vLayerCells.data() + m_vLayerStart[Layer]; }
+	const int *LayerEnd(int Layer) const { return m_vLayerCells.data() + m_vLayerStart[Layer + 1]; }
+
+private:
+	int m_Radius = 0;
+	int m_Length = 0;
+	int m_SeedX = 0;
+	int m_SeedY = 0;
+	std::vector<int> m_vCells;
+	std::vector<int> m_vLayerCells;
+	std::vector<int> m_vLayerStart;
+};
+
+#endif // INFCLASS_GROWING_MAP_H
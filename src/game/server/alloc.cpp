@@ -0,0 +1,55 @@
+#include "alloc.h"
+
+#include <base/tl/ic_slab_allocator.h>
+
+// Never released: the entities left in the game world may be destroyed
+// after the static objects
+static icSlabAllocator *s_apSizeClasses[CSlabAllocators::NUM_SIZE_CLASSES] = {nullptr};
+static int64_t s_NumHeapAllocations = 0;
+
+static int SizeClassIndex(size_t Size)
+{
+	return Size == 0 ? 0 : (Size - 1) / CSlabAllocators::SLOT_GRANULARITY;
+}
+
+void *CSlabAllocators::Allocate(size_t Size)
+{
+	const int Index = SizeClassIndex(Size);
+	if(Index >= NUM_SIZE_CLASSES)
+	{
+		s_NumHeapAllocations++;
+		return malloc(Size);
+	}
+
+	if(!s_apSizeClasses[Index])
+	{
+		// slabs of about 16 KiB
+		const size_t SlotSize = (Index + 1) * SLOT_GRANULARITY;
+		s_apSizeClasses[Index] = new icSlabAllocator(SlotSize, 16 * 1024 / SlotSize);
+	}
+	return s_apSizeClasses[Index]->Allocate();
+}
+
+void CSlabAllocators::Free(void *pPtr, size_t Size)
+{
+	const int Index = SizeClassIndex(Size);
+	if(Index >= NUM_SIZE_CLASSES)
+	{
+		free(pPtr);
+		return;
+	}
+
+	dbg_assert(s_apSizeClasses[Index] != nullptr || !pPtr, "freed an object of a size never allocated");
+	if(pPtr)
+		s_apSizeClasses[Index]->Free(pPtr);
+}
+
+const icSlabAllocator *CSlabAllocators::SizeClass(int Index)
+{
+	return s_apSizeClasses[Index];
+}
+
+int64_t CSlabAllocators::NumHeapAllocations()
+{
+	return s_NumHeapAllocations;
+}
@@ -7,17 +7,38 @@
 
 #include <base/system.h>
 
-#define MACRO_ALLOC_HEAP() \
+class icSlabAllocator;
+
+// The slabs the objects using MACRO_ALLOC_SLAB are allocated from, one per
+// size class of SLOT_GRANULARITY bytes. Larger objects go to the heap.
+class CSlabAllocators
+{
+public:
+	enum
+	{
+		SLOT_GRANULARITY = 64,
+		NUM_SIZE_CLASSES = 32,
+	};
+
+	static void *Allocate(size_t Size);
+	static void Free(void *pPtr, size_t Size);
+
+	// nullptr until an object of this size class is allocated
+	static const icSlabAllocator *SizeClass(int Index);
+	static int64_t NumHeapAllocations();
+};
+
+#define MACRO_ALLOC_SLAB() \
 public: \
 	void *operator new(size_t Size) \
 	{ \
-		void *p = malloc(Size); \
+		void *p = CSlabAllocators::Allocate(Size); \
 		mem_zero(p, Size); \
 		return p; \
 	} \
-	void operator delete(void *pPtr) \
+	void operator delete(void *pPtr, size_t Size) \
 	{ \
-		free(pPtr); \
+		CSlabAllocators::Free(pPtr, Size); \
 	} \
 \
 private:
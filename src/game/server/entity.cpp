@@ -21,10 +21,16 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, const vec2 &Pos, int Proxi
 	m_ProximityRadius = ProximityRadius;
 
 	m_MarkedForDestroy = false;
+	m_DestroyPending = false;
 	m_Id = Server()->SnapNewId();
 
 	m_pPrevTypeEntity = 0;
 	m_pNextTypeEntity = 0;
+	m_InsertionIndex = 0;
+
+	m_pPrevOwnedEntity = 0;
+	m_pNextOwnedEntity = 0;
+	m_IndexedOwner = -1;
 }
 
 CEntity::~CEntity()
@@ -33,6 +39,12 @@ CEntity::~CEntity()
 	Server()->SnapFreeId(m_Id);
 }
 
+void CEntity::SetPos(const vec2 &Position)
+{
+	m_Pos = Position;
+	m_pGameWorld->OnEntityMoved(this);
+}
+
 bool CEntity::NetworkClipped(int SnappingClient) const
 {
 	return ::NetworkClipped(m_pGameWorld->GameServer(), SnappingClient, m_Pos);
@@ -128,5 +140,5 @@ void CAnimatedEntity::Tick()
 	float x = (m_RelPosition.x * cosf(Angle) - m_RelPosition.y * sinf(Angle));
 	float y = (m_RelPosition.x * sinf(Angle) + m_RelPosition.y * cosf(Angle));
 	
-	m_Pos = Position + m_Pivot + vec2(x, y);
+	SetPos(Position + m_Pivot + vec2(x, y));
 }
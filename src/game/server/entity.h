@@ -4,6 +4,7 @@
 #define GAME_SERVER_ENTITY_H
 
 #include <new>
+#include <base/tl/ic_spatial_grid.h>
 #include <base/vmath.h>
 #include <game/server/gameworld.h>
 
@@ -17,12 +18,24 @@ class CCollision;
 */
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+	MACRO_ALLOC_SLAB()
 
 	friend class CGameWorld;	// entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
 
+	/* Spatial index */
+	icSpatialGrid<CEntity>::CNode m_GridNode;
+	int64_t m_InsertionIndex;
+
+	/* Owner index */
+	CEntity *m_pPrevOwnedEntity;
+	CEntity *m_pNextOwnedEntity;
+	int m_IndexedOwner;
+
+	/* In the destroy queue of the world */
+	bool m_DestroyPending;
+
 	/* Identity */
 	CGameWorld *m_pGameWorld;
 	CCollision *m_pCCollision;
@@ -51,12 +64,14 @@ public:
 	/* Getters */
 	CEntity *TypeNext() { return m_pNextTypeEntity; }
 	CEntity *TypePrev() { return m_pPrevTypeEntity; }
+	CEntity *OwnedNext() { return m_pNextOwnedEntity; }
 	vec2 GetPos() const { return m_Pos; }
 	float GetProximityRadius() const { return m_ProximityRadius; }
 	bool IsMarkedForDestroy() const { return m_MarkedForDestroy; }
 
 	/* Setters */
-	void MarkForDestroy() { m_MarkedForDestroy = true; }
+	void MarkForDestroy() { m_pGameWorld->DestroyEntity(this); }
+	void SetPos(const vec2 &Position);
 
 	/* Other functions */
 
@@ -134,6 +149,7 @@ public:
 	/*
 		Variable: pos
 			Contains the current posititon of the entity.
+			Use SetPos() to change it to keep the world spatial index valid.
 	*/
 	vec2 m_Pos;
 };
@@ -4,6 +4,7 @@
 
 #include <base/logger.h>
 #include <base/math.h>
+#include <base/tl/ic_slab_allocator.h>
 #include <engine/shared/config.h>
 #include <engine/map.h>
 #include <engine/console.h>
@@ -474,44 +475,105 @@ void CGameContext::SendChatTarget(int To, const char *pText)
 }
 
 /* INFECTION MODIFICATION START ***************************************/
-void CGameContext::SendChatTarget_Localization(int To, int Category, const char* pText, ...)
+void CGameContext::GetRecipientLanguages(int To, CRecipientLanguages *pLanguages, bool ReadyOnly) const
 {
 	int Start = (To < 0 ? 0 : To);
 	int End = (To < 0 ? MAX_CLIENTS : To+1);
-	
-	CNetMsg_Sv_Chat Msg;
-	Msg.m_Team = 0;
-	Msg.m_ClientId = -1;
-	
+
+	pLanguages->m_NumLanguages = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		pLanguages->m_aClientLanguage[i] = -1;
+		if(i < Start || i >= End)
+			continue;
+
+		const CPlayer *pPlayer = m_apPlayers[i];
+		if(!pPlayer || pPlayer->IsBot() || (ReadyOnly && !pPlayer->m_IsReady))
+			continue;
+
+		const char *pLanguage = pPlayer->GetLanguage();
+		int Language = 0;
+		while(Language < pLanguages->m_NumLanguages && str_comp(pLanguages->m_apLanguages[Language], pLanguage) != 0)
+			Language++;
+		if(Language == pLanguages->m_NumLanguages)
+			pLanguages->m_apLanguages[pLanguages->m_NumLanguages++] = pLanguage;
+		pLanguages->m_aClientLanguage[i] = Language;
+	}
+}
+
+void CGameContext::SendChatToLanguage(const char *pText, const CRecipientLanguages &Languages, int Language)
+{
+	// Pack the message once for each protocol and send the same data to
+	// every recipient of this language
+	CMsgPacker Packer(CNetMsg_Sv_Chat::ms_MsgId, false, false);
+	CMsgPacker Packer7(protocol7::CNetMsg_Sv_Chat::ms_MsgId, false, true);
+	bool Packed = false;
+	bool Packed7 = false;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(Languages.m_aClientLanguage[i] != Language)
+			continue;
+
+		if(Server()->IsSixup(i))
+		{
+			if(!Packed7)
+			{
+				protocol7::CNetMsg_Sv_Chat Msg7;
+				Msg7.m_Mode = protocol7::CHAT_ALL;
+				Msg7.m_ClientId = -1;
+				Msg7.m_TargetId = -1;
+				Msg7.m_pMessage = pText;
+				Msg7.Pack(&Packer7);
+				Packed7 = true;
+			}
+			Server()->SendMsg(&Packer7, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+		}
+		else
+		{
+			if(!Packed)
+			{
+				CNetMsg_Sv_Chat Msg;
+				Msg.m_Team = 0;
+				Msg.m_ClientId = -1;
+				Msg.m_pMessage = pText;
+				Msg.Pack(&Packer);
+				Packed = true;
+			}
+			Server()->SendMsg(&Packer, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
+		}
+	}
+}
+
+void CGameContext::SendChatTarget_Localization(int To, int Category, const char* pText, ...)
+{
+	CRecipientLanguages Languages;
+	GetRecipientLanguages(To, &Languages);
+
 	dynamic_string Buffer;
 	
 	va_list VarArgs;
 	va_start(VarArgs, pText);
 
-	bool Sent = false;
-	for(int i = Start; i < End; i++)
+	for(int l = 0; l < Languages.m_NumLanguages; l++)
 	{
-		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
-		{
-			Buffer.clear();
-			Buffer.append(GetChatCategoryPrefix(Category));
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), pText, VarArgs);
-			
-			Msg.m_pMessage = Buffer.buffer();
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
-			Sent = true;
-		}
+		Buffer.clear();
+		Buffer.append(GetChatCategoryPrefix(Category));
+		Server()->Localization()->Format_VL(Buffer, Languages.m_apLanguages[l], pText, VarArgs);
+		SendChatToLanguage(Buffer.buffer(), Languages, l);
 	}
 
-	if(To < 0 && Sent)
+	if(To < 0 && Languages.m_NumLanguages > 0)
 	{
+		// one message for record
 		Buffer.clear();
 		Buffer.append(GetChatCategoryPrefix(Category));
-		// one message for record
-		dynamic_string tmpBuf;
-		tmpBuf.copy(Buffer);
-		Server()->Localization()->Format_VL(tmpBuf, "en", pText, VarArgs);
-		Msg.m_pMessage = tmpBuf.buffer();
+		Server()->Localization()->Format_VL(Buffer, "en", pText, VarArgs);
+
+		CNetMsg_Sv_Chat Msg;
+		Msg.m_Team = 0;
+		Msg.m_ClientId = -1;
+		Msg.m_pMessage = Buffer.buffer();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NOSEND, -1);
 
 		char aBuf[256];
@@ -524,42 +586,33 @@ void CGameContext::SendChatTarget_Localization(int To, int Category, const char*
 
 void CGameContext::SendChatTarget_Localization_P(int To, int Category, int Number, const char* pText, ...)
 {
-	int Start = (To < 0 ? 0 : To);
-	int End = (To < 0 ? MAX_CLIENTS : To+1);
-	
-	CNetMsg_Sv_Chat Msg;
-	Msg.m_Team = 0;
-	Msg.m_ClientId = -1;
-	
+	CRecipientLanguages Languages;
+	GetRecipientLanguages(To, &Languages);
+
 	dynamic_string Buffer;
 	
 	va_list VarArgs;
 	va_start(VarArgs, pText);
 
-	bool Sent = false;
-	for(int i = Start; i < End; i++)
+	for(int l = 0; l < Languages.m_NumLanguages; l++)
 	{
-		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
-		{
-			Buffer.clear();
-			Buffer.append(GetChatCategoryPrefix(Category));
-			Server()->Localization()->Format_VLP(Buffer, m_apPlayers[i]->GetLanguage(), Number, pText, VarArgs);
-			
-			Msg.m_pMessage = Buffer.buffer();
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
-			Sent = true;
-		}
+		Buffer.clear();
+		Buffer.append(GetChatCategoryPrefix(Category));
+		Server()->Localization()->Format_VLP(Buffer, Languages.m_apLanguages[l], Number, pText, VarArgs);
+		SendChatToLanguage(Buffer.buffer(), Languages, l);
 	}
 
-	if(To < 0 && Sent)
+	if(To < 0 && Languages.m_NumLanguages > 0)
 	{
+		// one message for record
 		Buffer.clear();
 		Buffer.append(GetChatCategoryPrefix(Category));
-		// one message for record
-		dynamic_string tmpBuf;
-		tmpBuf.copy(Buffer);
-		Server()->Localization()->Format_VLP(tmpBuf, "en", Number, pText, VarArgs);
-		Msg.m_pMessage = tmpBuf.buffer();
+		Server()->Localization()->Format_VLP(Buffer, "en", Number, pText, VarArgs);
+
+		CNetMsg_Sv_Chat Msg;
+		Msg.m_Team = 0;
+		Msg.m_ClientId = -1;
+		Msg.m_pMessage = Buffer.buffer();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NOSEND, -1);
 	}
 
@@ -765,9 +818,9 @@ const char *CGameContext::GetChatCategoryPrefix(int Category)
 
 void CGameContext::SendBroadcast_Localization(int To, int Priority, int LifeSpan, const char* pText, ...)
 {
-	int Start = (To < 0 ? 0 : To);
-	int End = (To < 0 ? MAX_CLIENTS : To+1);
-	
+	CRecipientLanguages Languages;
+	GetRecipientLanguages(To, &Languages);
+
 	dynamic_string Buffer;
 	
 	va_list VarArgs;
@@ -782,13 +835,14 @@ void CGameContext::SendBroadcast_Localization(int To, int Priority, int LifeSpan
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
 	}
 
-	for(int i = Start; i < End; i++)
+	for(int l = 0; l < Languages.m_NumLanguages; l++)
 	{
-		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
+		Buffer.clear();
+		Server()->Localization()->Format_VL(Buffer, Languages.m_apLanguages[l], pText, VarArgs);
+		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			Buffer.clear();
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), pText, VarArgs);
-			AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
+			if(Languages.m_aClientLanguage[i] == l)
+				AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
 		}
 	}
 	
@@ -797,20 +851,22 @@ void CGameContext::SendBroadcast_Localization(int To, int Priority, int LifeSpan
 
 void CGameContext::SendBroadcast_Localization_P(int To, int Priority, int LifeSpan, int Number, const char* pText, ...)
 {
-	int Start = (To < 0 ? 0 : To);
-	int End = (To < 0 ? MAX_CLIENTS : To+1);
-	
+	CRecipientLanguages Languages;
+	GetRecipientLanguages(To, &Languages);
+
 	dynamic_string Buffer;
 	
 	va_list VarArgs;
 	va_start(VarArgs, pText);
 	
-	for(int i = Start; i < End; i++)
+	for(int l = 0; l < Languages.m_NumLanguages; l++)
 	{
-		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
+		Buffer.clear();
+		Server()->Localization()->Format_VLP(Buffer, Languages.m_apLanguages[l], Number, pText, VarArgs);
+		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			Server()->Localization()->Format_VLP(Buffer, m_apPlayers[i]->GetLanguage(), Number, pText, VarArgs);
-			AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
+			if(Languages.m_aClientLanguage[i] == l)
+				AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
 		}
 	}
 
@@ -2571,11 +2627,10 @@ void CGameContext::OnStartInfoNetMessage(const CNetMsg_Cl_StartInfo *pMsg, int C
 	if(!Server()->GetClientMemory(ClientId, CLIENTMEMORY_LANGUAGESELECTION))
 	{
 #ifdef CONF_GEOLOCATION
-		char aAddrStr[NETADDR_MAXSTRSIZE]{};
-		Server()->GetClientAddr(ClientId, aAddrStr, sizeof(aAddrStr));
-		std::string ip(aAddrStr);
+		NETADDR Addr;
+		Server()->GetClientAddr(ClientId, &Addr);
 
-		int LocatedCountry = Geolocation::get_country_iso_numeric_code(ip);
+		int LocatedCountry = Geolocation::get_country_iso_numeric_code(Addr);
 #ifdef CONF_FORCE_COUNTRY_BY_IP
 		Server()->SetClientCountry(ClientId, LocatedCountry);
 #endif // CONF_FORCE_COUNTRY_BY_IP
@@ -2858,6 +2913,37 @@ void CGameContext::ConTuneDump(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CGameContext::ConEntityAllocStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	char aBuf[256];
+	for(int i = 0; i < CSlabAllocators::NUM_SIZE_CLASSES; i++)
+	{
+		const icSlabAllocator *pSlabs = CSlabAllocators::SizeClass(i);
+		if(!pSlabs)
+			continue;
+
+		str_format(aBuf, sizeof(aBuf), "%d bytes slots: %d used, %d at most, %d in %d slabs, %lld allocations",
+			(int)pSlabs->SlotSize(), pSlabs->NumUsed(), pSlabs->PeakUsed(), pSlabs->Capacity(), pSlabs->NumSlabs(),
+			(long long)pSlabs->NumAllocations());
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "entities", aBuf);
+	}
+	str_format(aBuf, sizeof(aBuf), "%lld allocations too large for the slabs", (long long)CSlabAllocators::NumHeapAllocations());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "entities", aBuf);
+
+	for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+	{
+		int NumEntities = 0;
+		for(CEntity *pEnt = pSelf->m_World.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+			NumEntities++;
+		if(!NumEntities)
+			continue;
+
+		str_format(aBuf, sizeof(aBuf), "%s: %d entities", CGameWorld::EntityTypeName(Type), NumEntities);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "entities", aBuf);
+	}
+}
+
 void CGameContext::ConPause(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -4564,6 +4650,7 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("toggle_tune", "s[tuning] i[value 1] i[value 2]", CFGFLAG_SERVER | CFGFLAG_GAME, ConToggleTuneParam, this, "Toggle tune variable");
 	Console()->Register("tune_reset", "", CFGFLAG_SERVER, ConTuneReset, this, "Reset tuning");
 	Console()->Register("tune_dump", "", CFGFLAG_SERVER, ConTuneDump, this, "Dump tuning");
+	Console()->Register("entity_alloc_stats", "", CFGFLAG_SERVER, ConEntityAllocStats, this, "Show the slabs the entities are allocated from and the entities of each type");
 	Console()->Register("pause_game", "", CFGFLAG_SERVER, ConPause, this, "Pause/unpause game");
 	Console()->Register("change_map", "?r[map]", CFGFLAG_SERVER | CFGFLAG_STORE, ConChangeMap, this, "Change map");
 	Console()->Register("restart", "?i[seconds]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRestart, this, "Restart in x seconds (0 = abort)");
@@ -4680,6 +4767,7 @@ void CGameContext::OnInit()
 
 	m_Layers.Init(Kernel());
 	m_Collision.Init(&m_Layers);
+	m_World.InitSpatialIndex(m_Collision.GetWidth() * 32.0f, m_Collision.GetHeight() * 32.0f);
 
 	// select gametype
 	m_pController = new CInfClassGameController(this);
@@ -97,6 +97,7 @@ class CGameContext : public IGameServer
 	static void ConToggleTuneParam(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneReset(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneDump(IConsole::IResult *pResult, void *pUserData);
+	static void ConEntityAllocStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConPause(IConsole::IResult *pResult, void *pUserData);
 	static void ConChangeMap(IConsole::IResult *pResult, void *pUserData);
 	static void ConSkipMap(IConsole::IResult *pResult, void *pUserData);
@@ -366,6 +367,17 @@ public:
 	virtual void SendBroadcast_Localization_P(int To, int Priority, int LifeSpan, int Number, const char* pText, ...);
 	virtual void ClearBroadcast(int To, int Priority);
 	
+	// The languages spoken by the human recipients of a message, so that
+	// a localized message is rendered once per language instead of per player
+	struct CRecipientLanguages
+	{
+		const char *m_apLanguages[MAX_CLIENTS];
+		int m_aClientLanguage[MAX_CLIENTS]; // index in m_apLanguages, -1 if not a recipient
+		int m_NumLanguages;
+	};
+	void GetRecipientLanguages(int To, CRecipientLanguages *pLanguages, bool ReadyOnly = false) const;
+	void SendChatToLanguage(const char *pText, const CRecipientLanguages &Languages, int Language);
+
 	static const char *GetChatCategoryPrefix(int Category);
 	virtual void SendChatTarget_Localization(int To, int Category, const char* pText, ...);
 	virtual void SendChatTarget_Localization_P(int To, int Category, int Number, const char* pText, ...);
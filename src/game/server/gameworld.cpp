@@ -6,10 +6,21 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include <algorithm>
+#include <iterator>
 #include <utility>
 #include <engine/shared/config.h>
 #include <game/server/player.h>
 
+static vec2 SegmentMin(vec2 Pos0, vec2 Pos1)
+{
+	return vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y));
+}
+
+static vec2 SegmentMax(vec2 Pos0, vec2 Pos1)
+{
+	return vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y));
+}
+
 //////////////////////////////////////////////////
 // game world
 //////////////////////////////////////////////////
@@ -22,7 +33,23 @@ CGameWorld::CGameWorld()
 	m_Paused = false;
 	m_ResetRequested = false;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
 		m_apFirstEntityTypes[i] = 0;
+		m_aMaxProximityRadius[i] = 0.0f;
+	}
+	mem_zero(m_aapFirstOwnedEntities, sizeof(m_aapFirstOwnedEntities));
+	m_NextInsertionIndex = 0;
+
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		char aName[64];
+		str_format(aName, sizeof(aName), "world/tick/%s", EntityTypeName(i));
+		m_apTickZones[i] = CProfiler::Zone(aName);
+		str_format(aName, sizeof(aName), "world/tick_deferred/%s", EntityTypeName(i));
+		m_apTickDeferredZones[i] = CProfiler::Zone(aName);
+		str_format(aName, sizeof(aName), "world/snap/%s", EntityTypeName(i));
+		m_apSnapZones[i] = CProfiler::Zone(aName);
+	}
 }
 
 CGameWorld::~CGameWorld()
@@ -40,19 +67,156 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pServer = m_pGameServer->Server();
 }
 
+const char *CGameWorld::EntityTypeName(int Type)
+{
+	static const char *s_apNames[] = {
+		"projectile",
+		"laser",
+		"pickup",
+		"growing_explosion",
+		"flying_point",
+		"character",
+		"engineer_wall",
+		"soldier_bomb",
+		"scientist_mine",
+		"scientist_laser",
+		"mercenary_bomb",
+		"scatter_grenade",
+		"medic_grenade",
+		"hero_flag",
+		"biologist_mine",
+		"slug_slime",
+		"bouncing_bullet",
+		"looper_wall",
+		"white_hole",
+		"superweapon_indicator",
+		"laser_teleport",
+		"turret",
+		"plasma",
+	};
+	static_assert(std::size(s_apNames) == NUM_ENTTYPES, "a name is missing");
+
+	return Type >= 0 && Type < NUM_ENTTYPES ? s_apNames[Type] : "unknown";
+}
+
+void CGameWorld::InitSpatialIndex(float Width, float Height)
+{
+	for(auto &Grid : m_aEntityGrids)
+		Grid.Init(Width, Height, SPATIAL_INDEX_CELL_SIZE);
+}
+
+void CGameWorld::OnEntityMoved(CEntity *pEntity)
+{
+	m_aEntityGrids[pEntity->m_ObjType].Update(&pEntity->m_GridNode, pEntity->m_Pos);
+}
+
+int CGameWorld::QueryEntities(int Type, vec2 Min, vec2 Max)
+{
+	const int Start = m_vpQueryEntities.size();
+
+	// The extra unit covers the float rounding of the callers distance checks
+	const float Margin = m_aMaxProximityRadius[Type] + 1.0f;
+	m_aEntityGrids[Type].Query(Min - vec2(Margin, Margin), Max + vec2(Margin, Margin), [this](CEntity *pEnt) {
+		m_vpQueryEntities.push_back(pEnt);
+	});
+
+	// Restore the type list order (the last inserted entity first) so the
+	// results and the tie breaks are the same as for a full list traversal.
+	std::sort(m_vpQueryEntities.begin() + Start, m_vpQueryEntities.end(), [](const CEntity *pA, const CEntity *pB) {
+		return pA->m_InsertionIndex > pB->m_InsertionIndex;
+	});
+
+	return Start;
+}
+
 CEntity *CGameWorld::FindFirst(int Type)
 {
 	return Type < 0 || Type >= NUM_ENTTYPES ? 0 : m_apFirstEntityTypes[Type];
 }
 
+CEntity *CGameWorld::FindFirstOwned(int Type, int Owner)
+{
+	if(Type < 0 || Type >= NUM_ENTTYPES || Owner < 0 || Owner >= MAX_CLIENTS)
+		return nullptr;
+
+	return m_aapFirstOwnedEntities[Owner][Type];
+}
+
+void CGameWorld::SetEntityOwner(CEntity *pEntity, int Owner)
+{
+	if(pEntity->m_IndexedOwner == Owner)
+		return;
+
+	if(!IsInserted(pEntity))
+	{
+		pEntity->m_IndexedOwner = Owner;
+		return;
+	}
+
+	UnlinkOwnedEntity(pEntity);
+	pEntity->m_IndexedOwner = Owner;
+	LinkOwnedEntity(pEntity);
+}
+
+bool CGameWorld::IsInserted(const CEntity *pEntity) const
+{
+	return pEntity->m_pNextTypeEntity || pEntity->m_pPrevTypeEntity || m_apFirstEntityTypes[pEntity->m_ObjType] == pEntity;
+}
+
+void CGameWorld::LinkOwnedEntity(CEntity *pEntity)
+{
+	const int Owner = pEntity->m_IndexedOwner;
+	if(Owner < 0 || Owner >= MAX_CLIENTS)
+		return;
+
+	// Sorted like the type list, the last inserted entity first. A newly
+	// inserted entity always goes to the front.
+	CEntity *pPrev = nullptr;
+	CEntity *pNext = m_aapFirstOwnedEntities[Owner][pEntity->m_ObjType];
+	while(pNext && pNext->m_InsertionIndex > pEntity->m_InsertionIndex)
+	{
+		pPrev = pNext;
+		pNext = pNext->m_pNextOwnedEntity;
+	}
+
+	pEntity->m_pPrevOwnedEntity = pPrev;
+	pEntity->m_pNextOwnedEntity = pNext;
+	if(pPrev)
+		pPrev->m_pNextOwnedEntity = pEntity;
+	else
+		m_aapFirstOwnedEntities[Owner][pEntity->m_ObjType] = pEntity;
+	if(pNext)
+		pNext->m_pPrevOwnedEntity = pEntity;
+}
+
+void CGameWorld::UnlinkOwnedEntity(CEntity *pEntity)
+{
+	const int Owner = pEntity->m_IndexedOwner;
+	if(Owner < 0 || Owner >= MAX_CLIENTS)
+		return;
+
+	if(pEntity->m_pPrevOwnedEntity)
+		pEntity->m_pPrevOwnedEntity->m_pNextOwnedEntity = pEntity->m_pNextOwnedEntity;
+	else
+		m_aapFirstOwnedEntities[Owner][pEntity->m_ObjType] = pEntity->m_pNextOwnedEntity;
+	if(pEntity->m_pNextOwnedEntity)
+		pEntity->m_pNextOwnedEntity->m_pPrevOwnedEntity = pEntity->m_pPrevOwnedEntity;
+
+	pEntity->m_pNextOwnedEntity = 0;
+	pEntity->m_pPrevOwnedEntity = 0;
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
+	const int Start = QueryEntities(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius));
+
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
 	{
+		CEntity *pEnt = m_vpQueryEntities[i];
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
 			if(ppEnts)
@@ -63,18 +227,23 @@ int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max,
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return Num;
 }
 
 CEntity *CGameWorld::ClosestEntity(vec2 Pos, float Radius, int Type, const CEntity *pNotThis)
 {
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
 	// Find other players
 	float ClosestRange = Radius * 2;
 	CEntity *pClosest = 0;
 
-	CEntity *p = FindFirst(Type);
-	for(; p; p = p->TypeNext())
- 	{
+	const int Start = QueryEntities(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius));
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
+	{
+		CEntity *p = m_vpQueryEntities[i];
 		if(p == pNotThis)
 			continue;
 
@@ -89,6 +258,7 @@ CEntity *CGameWorld::ClosestEntity(vec2 Pos, float Radius, int Type, const CEnti
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return pClosest;
 }
 
@@ -105,17 +275,41 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = 0x0;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	pEnt->m_InsertionIndex = m_NextInsertionIndex++;
+	LinkOwnedEntity(pEnt);
+	m_aEntityGrids[pEnt->m_ObjType].Insert(&pEnt->m_GridNode, pEnt, pEnt->m_Pos);
+	m_aMaxProximityRadius[pEnt->m_ObjType] = maximum(m_aMaxProximityRadius[pEnt->m_ObjType], pEnt->m_ProximityRadius);
+
+	if(pEnt->m_MarkedForDestroy)
+	{
+		pEnt->m_DestroyPending = true;
+		m_vpDestroyQueue.push_back(pEnt);
+	}
 }
 
 void CGameWorld::DestroyEntity(CEntity *pEnt)
 {
 	pEnt->m_MarkedForDestroy = true;
+
+	// the entities out of the world are queued when they are inserted
+	if(!pEnt->m_DestroyPending && IsInserted(pEnt))
+	{
+		pEnt->m_DestroyPending = true;
+		m_vpDestroyQueue.push_back(pEnt);
+	}
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
 {
+	if(pEnt->m_DestroyPending)
+	{
+		*std::find(m_vpDestroyQueue.begin(), m_vpDestroyQueue.end(), pEnt) = nullptr;
+		pEnt->m_DestroyPending = false;
+	}
+
 	// not in the list
-	if(!pEnt->m_pNextTypeEntity && !pEnt->m_pPrevTypeEntity && m_apFirstEntityTypes[pEnt->m_ObjType] != pEnt)
+	if(!IsInserted(pEnt))
 		return;
 
 	// remove
@@ -132,18 +326,24 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = 0;
 	pEnt->m_pPrevTypeEntity = 0;
+
+	UnlinkOwnedEntity(pEnt);
+	m_aEntityGrids[pEnt->m_ObjType].Remove(&pEnt->m_GridNode);
 }
 
 //
 void CGameWorld::Snap(int SnappingClient)
 {
 	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		CProfileScope Scope(m_apSnapZones[i]);
 		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 			pEnt->Snap(SnappingClient);
 			pEnt = m_pNextTraverseEntity;
 		}
+	}
 }
 
 void CGameWorld::Reset()
@@ -166,18 +366,19 @@ void CGameWorld::Reset()
 
 void CGameWorld::RemoveEntities()
 {
-	// destroy objects marked for destruction
-	for(auto *pEnt : m_apFirstEntityTypes)
-		for(; pEnt;)
-		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			if(pEnt->m_MarkedForDestroy)
-			{
-				RemoveEntity(pEnt);
-				pEnt->Destroy();
-			}
-			pEnt = m_pNextTraverseEntity;
-		}
+	// destroy objects marked for destruction, including the ones marked
+	// by the Destroy() of the others
+	for(std::size_t i = 0; i < m_vpDestroyQueue.size(); i++)
+	{
+		CEntity *pEnt = m_vpDestroyQueue[i];
+		if(!pEnt)
+			continue;
+
+		pEnt->m_DestroyPending = false;
+		RemoveEntity(pEnt);
+		pEnt->Destroy();
+	}
+	m_vpDestroyQueue.clear();
 }
 
 bool distCompare(std::pair<float,int> a, std::pair<float,int> b)
@@ -261,20 +462,26 @@ void CGameWorld::Tick()
 			GameServer()->SendChat(-1, CGameContext::CHAT_ALL, "Teams have been balanced");
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CProfileScope Scope(m_apTickZones[i]);
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 				pEnt->Tick();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 
 		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CProfileScope Scope(m_apTickDeferredZones[i]);
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
 				pEnt->TickDeferred();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 	}
 	else
 	{
@@ -295,12 +502,17 @@ void CGameWorld::Tick()
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2 *NewPos, int EntityType, EntityFilter FilterFunction)
 {
+	if(EntityType < 0 || EntityType >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 
 	CEntity *pClosest = nullptr;
-	CEntity *p = FindFirst(EntityType);
-	for(; p; p = p->TypeNext())
+	const vec2 Extent(Radius, Radius);
+	const int Start = QueryEntities(EntityType, SegmentMin(Pos0, Pos1) - Extent, SegmentMax(Pos0, Pos1) + Extent);
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
 	{
+		CEntity *p = m_vpQueryEntities[i];
 		if(FilterFunction && !FilterFunction(p))
 			continue;
 
@@ -324,6 +536,7 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2 *N
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return pClosest;
 }
 
@@ -334,9 +547,11 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CCharacter *pClosest = 0;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	const vec2 Extent(Radius, Radius);
+	const int Start = QueryEntities(ENTTYPE_CHARACTER, SegmentMin(Pos0, Pos1) - Extent, SegmentMax(Pos0, Pos1) + Extent);
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
  	{
+		CCharacter *p = static_cast<CCharacter *>(m_vpQueryEntities[i]);
 		if(FilterFunction && !FilterFunction(p))
 			continue;
 
@@ -363,17 +578,23 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return pClosest;
 }
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2 *NewPos, int EntityType)
 {
+	if(EntityType < 0 || EntityType >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 
 	CEntity *pClosest = nullptr;
-	CEntity *p = FindFirst(EntityType);
-	for(; p; p = (CEntity *)p->TypeNext())
+	const vec2 Extent(Radius, Radius);
+	const int Start = QueryEntities(EntityType, SegmentMin(Pos0, Pos1) - Extent, SegmentMax(Pos0, Pos1) + Extent);
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
 	{
+		CEntity *p = m_vpQueryEntities[i];
 		vec2 IntersectPos;
 		if(!closest_point_on_line(Pos0, Pos1, p->m_Pos, IntersectPos))
 			continue;
@@ -391,6 +612,7 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, vec2 *N
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return pClosest;
 }
 
@@ -419,9 +641,10 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, CEntity *pNotTh
 	float ClosestRange = Radius*2;
 	CCharacter *pClosest = 0;
 
-	CCharacter *p = (CCharacter *)GameServer()->m_World.FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	const int Start = QueryEntities(ENTTYPE_CHARACTER, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius));
+	for(std::size_t i = Start; i < m_vpQueryEntities.size(); i++)
  	{
+		CCharacter *p = static_cast<CCharacter *>(m_vpQueryEntities[i]);
 		if(p == pNotThis)
 			continue;
 			
@@ -439,6 +662,7 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, CEntity *pNotTh
 		}
 	}
 
+	m_vpQueryEntities.resize(Start);
 	return pClosest;
 }
 
@@ -3,8 +3,12 @@
 #ifndef GAME_SERVER_GAMEWORLD_H
 #define GAME_SERVER_GAMEWORLD_H
 
+#include <base/tl/ic_spatial_grid.h>
+#include <engine/shared/profiler.h>
 #include <game/gamecore.h>
 
+#include <vector>
+
 class CEntity;
 class CCharacter;
 
@@ -46,6 +50,8 @@ public:
 		NUM_ENTTYPES
 	};
 
+	static constexpr float SPATIAL_INDEX_CELL_SIZE = 256.0f;
+
 private:
 	void Reset();
 	void RemoveEntities();
@@ -53,6 +59,32 @@ private:
 	CEntity *m_pNextTraverseEntity;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// Spatial index of the entities, one grid per type
+	icSpatialGrid<CEntity> m_aEntityGrids[NUM_ENTTYPES];
+	// High-water mark of the proximity radius of the entities inserted per
+	// type, widening the queries. It is never lowered, a stale larger
+	// radius only costs a wider query.
+	float m_aMaxProximityRadius[NUM_ENTTYPES];
+	int64_t m_NextInsertionIndex;
+	std::vector<CEntity *> m_vpQueryEntities;
+
+	// The entities in the world marked for destruction, the ones removed
+	// from the world before RemoveEntities() are replaced by nullptr
+	std::vector<CEntity *> m_vpDestroyQueue;
+
+	int QueryEntities(int Type, vec2 Min, vec2 Max);
+
+	CProfiler::CZone *m_apTickZones[NUM_ENTTYPES];
+	CProfiler::CZone *m_apTickDeferredZones[NUM_ENTTYPES];
+	CProfiler::CZone *m_apSnapZones[NUM_ENTTYPES];
+
+	// Entities of each type owned by a player, in the order of the type lists
+	CEntity *m_aapFirstOwnedEntities[MAX_CLIENTS][NUM_ENTTYPES];
+
+	bool IsInserted(const CEntity *pEntity) const;
+	void LinkOwnedEntity(CEntity *pEntity);
+	void UnlinkOwnedEntity(CEntity *pEntity);
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -73,6 +105,20 @@ public:
 
 	void SetGameServer(CGameContext *pGameServer);
 
+	static const char *EntityTypeName(int Type);
+
+	/*
+		Function: InitSpatialIndex
+			Sizes the entity spatial index to the map. Must be called
+			before any entity is inserted.
+
+		Arguments:
+			Width - Width of the map in world units.
+			Height - Height of the map in world units.
+	*/
+	void InitSpatialIndex(float Width, float Height);
+	void OnEntityMoved(CEntity *pEntity);
+
 	CEntity *FindFirst(int Type);
 
 	template<typename T>
@@ -82,6 +128,36 @@ public:
 		return pF ? static_cast<T *>(pF) : nullptr;
 	}
 
+	/*
+		Function: FindFirstOwned
+			Finds the first entity of a type owned by a player, the
+			next ones are returned by CEntity::OwnedNext(). They come
+			in the same order as in the type list.
+
+		Arguments:
+			Type - Type of the entities to find.
+			Owner - Client ID of the owner.
+	*/
+	CEntity *FindFirstOwned(int Type, int Owner);
+
+	template<typename T>
+	T *FindFirstOwned(int Owner)
+	{
+		return static_cast<T *>(FindFirstOwned(T::EntityId, Owner));
+	}
+
+	/*
+		Function: SetEntityOwner
+			Moves an entity to the owner index of another player.
+			Entities which are not in the world yet are indexed
+			when they are inserted.
+
+		Arguments:
+			pEntity - Entity to move.
+			Owner - Client ID of the new owner, -1 for none.
+	*/
+	void SetEntityOwner(CEntity *pEntity, int Owner);
+
 	/*
 		Function: find_entities
 			Finds entities close to a position and returns them in a list.
@@ -170,7 +246,8 @@ public:
 
 	/*
 		Function: destroy_entity
-			Destroys an entity in the world.
+			Destroys an entity in the world. It is removed at the
+			end of the tick.
 
 		Arguments:
 			entity - Entity to destroy
@@ -296,15 +296,9 @@ void CInfClassHuman::OnPlayerSnap(int SnappingClient, int InfClassVersion)
 			}
 			break;
 		case EPlayerClass::Engineer:
-			for(TEntityPtr<CEngineerWall> pWall = GameWorld()->FindFirst<CEngineerWall>(); pWall; ++pWall)
+			if(CEngineerWall *pWall = GameWorld()->FindFirstOwned<CEngineerWall>(GetCid()))
 			{
-				if(pWall->GetOwner() != GetCid())
-				{
-					continue;
-				}
-
 				pClassInfo->m_Data1 = pWall->GetEndTick();
-				break;
 			}
 			break;
 		case EPlayerClass::Scientist:
@@ -314,15 +308,9 @@ void CInfClassHuman::OnPlayerSnap(int SnappingClient, int InfClassVersion)
 			}
 			break;
 		case EPlayerClass::Looper:
-			for(TEntityPtr<CLooperWall> pWall = GameWorld()->FindFirst<CLooperWall>(); pWall; ++pWall)
+			if(CLooperWall *pWall = GameWorld()->FindFirstOwned<CLooperWall>(GetCid()))
 			{
-				if(pWall->GetOwner() != GetCid())
-				{
-					continue;
-				}
-
 				pClassInfo->m_Data1 = pWall->GetEndTick();
-				break;
 			}
 			break;
 		default:
@@ -1216,15 +1204,7 @@ void CInfClassHuman::BroadcastWeaponState() const
 		if(ClientVersion >= VERSION_INFC_160)
 			return;
 
-		CEngineerWall *pCurrentWall = NULL;
-		for(CEngineerWall *pWall = (CEngineerWall*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_ENGINEER_WALL); pWall; pWall = (CEngineerWall*) pWall->TypeNext())
-		{
-			if(pWall->GetOwner() == m_pPlayer->GetCid())
-			{
-				pCurrentWall = pWall;
-				break;
-			}
-		}
+		CEngineerWall *pCurrentWall = GameWorld()->FindFirstOwned<CEngineerWall>(m_pPlayer->GetCid());
 
 		if(pCurrentWall && pCurrentWall->HasSecondPosition())
 		{
@@ -1271,15 +1251,7 @@ void CInfClassHuman::BroadcastWeaponState() const
 			return;
 
 		//Potential variable name conflict with engineerwall with pCurrentWall
-		CLooperWall* pCurrentWall = NULL;
-		for(CLooperWall *pWall = (CLooperWall*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_LOOPER_WALL); pWall; pWall = (CLooperWall*) pWall->TypeNext())
-		{
-			if(pWall->GetOwner() == m_pPlayer->GetCid())
-			{
-				pCurrentWall = pWall;
-				break;
-			}
-		}
+		CLooperWall* pCurrentWall = GameWorld()->FindFirstOwned<CLooperWall>(m_pPlayer->GetCid());
 
 		if(pCurrentWall && pCurrentWall->HasSecondPosition())
 		{
@@ -1296,10 +1268,9 @@ void CInfClassHuman::BroadcastWeaponState() const
 	else if(GetPlayerClass() == EPlayerClass::Soldier)
 	{
 		int NumBombs = 0;
-		for(CSoldierBomb *pBomb = (CSoldierBomb*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_SOLDIER_BOMB); pBomb; pBomb = (CSoldierBomb*) pBomb->TypeNext())
+		for(CSoldierBomb *pBomb = (CSoldierBomb*) GameWorld()->FindFirstOwned(CGameWorld::ENTTYPE_SOLDIER_BOMB, m_pPlayer->GetCid()); pBomb; pBomb = (CSoldierBomb*) pBomb->OwnedNext())
 		{
-			if(pBomb->GetOwner() == m_pPlayer->GetCid())
-				NumBombs += pBomb->GetNbBombs();
+			NumBombs += pBomb->GetNbBombs();
 		}
 
 		if(NumBombs)
@@ -1316,21 +1287,12 @@ void CInfClassHuman::BroadcastWeaponState() const
 	else if(GetPlayerClass() == EPlayerClass::Scientist)
 	{
 		int NumMines = 0;
-		for(CScientistMine *pMine = (CScientistMine*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_SCIENTIST_MINE); pMine; pMine = (CScientistMine*) pMine->TypeNext())
+		for(CEntity *pMine = GameWorld()->FindFirstOwned(CGameWorld::ENTTYPE_SCIENTIST_MINE, m_pPlayer->GetCid()); pMine; pMine = pMine->OwnedNext())
 		{
-			if(pMine->GetOwner() == m_pPlayer->GetCid())
-				NumMines++;
+			NumMines++;
 		}
 
-		CWhiteHole* pCurrentWhiteHole = NULL;
-		for(CWhiteHole *pWhiteHole = (CWhiteHole*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_WHITE_HOLE); pWhiteHole; pWhiteHole = (CWhiteHole*) pWhiteHole->TypeNext())
-		{
-			if(pWhiteHole->GetOwner() == m_pPlayer->GetCid())
-			{
-				pCurrentWhiteHole = pWhiteHole;
-				break;
-			}
-		}
+		CWhiteHole* pCurrentWhiteHole = (CWhiteHole*) GameWorld()->FindFirstOwned(CGameWorld::ENTTYPE_WHITE_HOLE, m_pPlayer->GetCid());
 
 		if(m_BroadcastWhiteHoleReady + (2 * Server()->TickSpeed()) > Server()->Tick())
 		{
@@ -1381,10 +1343,9 @@ void CInfClassHuman::BroadcastWeaponState() const
 	else if(GetPlayerClass() == EPlayerClass::Biologist)
 	{
 		int NumMines = 0;
-		for(CBiologistMine *pMine = (CBiologistMine*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_BIOLOGIST_MINE); pMine; pMine = (CBiologistMine*) pMine->TypeNext())
+		for(CEntity *pMine = GameWorld()->FindFirstOwned(CGameWorld::ENTTYPE_BIOLOGIST_MINE, m_pPlayer->GetCid()); pMine; pMine = pMine->OwnedNext())
 		{
-			if(pMine->GetOwner() == m_pPlayer->GetCid())
-				NumMines++;
+			NumMines++;
 		}
 
 		if(NumMines > 0)
@@ -1438,15 +1399,7 @@ void CInfClassHuman::BroadcastWeaponState() const
 	}
 	else if(GetPlayerClass() == EPlayerClass::Mercenary)
 	{
-		CMercenaryBomb *pCurrentBomb = nullptr;
-		for(CMercenaryBomb *pBomb = (CMercenaryBomb*) GameWorld()->FindFirst(CGameWorld::ENTTYPE_MERCENARY_BOMB); pBomb; pBomb = (CMercenaryBomb*) pBomb->TypeNext())
-		{
-			if(pBomb->GetOwner() == m_pPlayer->GetCid())
-			{
-				pCurrentBomb = pBomb;
-				break;
-			}
-		}
+		CMercenaryBomb *pCurrentBomb = GameWorld()->FindFirstOwned<CMercenaryBomb>(m_pPlayer->GetCid());
 
 		if(pCurrentBomb)
 		{
@@ -1712,19 +1665,15 @@ void CInfClassHuman::ActivateNinja(WeaponFireContext *pFireContext)
 void CInfClassHuman::PlaceEngineerWall(WeaponFireContext *pFireContext)
 {
 	TEntityPtr<CEngineerWall> pExistingWall;
-	for(TEntityPtr<CEngineerWall> pWall = GameWorld()->FindFirst<CEngineerWall>(); pWall; ++pWall)
+	if(CEngineerWall *pWall = GameWorld()->FindFirstOwned<CEngineerWall>(GetCid()))
 	{
-		if(pWall->GetOwner() == GetCid())
+		if(pWall->HasSecondPosition())
 		{
-			if(pWall->HasSecondPosition())
-			{
-				GameWorld()->DestroyEntity(pWall);
-			}
-			else
-			{
-				pExistingWall = pWall;
-			}
-			break;
+			GameWorld()->DestroyEntity(pWall);
+		}
+		else
+		{
+			pExistingWall = pWall;
 		}
 	}
 
@@ -1760,19 +1709,15 @@ void CInfClassHuman::PlaceEngineerWall(WeaponFireContext *pFireContext)
 void CInfClassHuman::PlaceLooperWall(WeaponFireContext *pFireContext)
 {
 	TEntityPtr<CLooperWall> pExistingWall;
-	for(TEntityPtr<CLooperWall> pWall = GameWorld()->FindFirst<CLooperWall>(); pWall; ++pWall)
+	if(CLooperWall *pWall = GameWorld()->FindFirstOwned<CLooperWall>(GetCid()))
 	{
-		if(pWall->GetOwner() == GetCid())
+		if(pWall->HasSecondPosition())
 		{
-			if(pWall->HasSecondPosition())
-			{
-				GameWorld()->DestroyEntity(pWall);
-			}
-			else
-			{
-				pExistingWall = pWall;
-			}
-			break;
+			GameWorld()->DestroyEntity(pWall);
+		}
+		else
+		{
+			pExistingWall = pWall;
 		}
 	}
 
@@ -1809,13 +1754,10 @@ void CInfClassHuman::FireSoldierBomb(WeaponFireContext *pFireContext)
 {
 	vec2 ProjStartPos = GetPos() + GetDirection() * GetProximityRadius() * 0.75f;
 
-	for(CSoldierBomb *pBomb = (CSoldierBomb *)GameWorld()->FindFirst(CGameWorld::ENTTYPE_SOLDIER_BOMB); pBomb; pBomb = (CSoldierBomb *)pBomb->TypeNext())
+	if(CSoldierBomb *pBomb = (CSoldierBomb *)GameWorld()->FindFirstOwned(CGameWorld::ENTTYPE_SOLDIER_BOMB, GetCid()))
 	{
-		if(pBomb->GetOwner() == GetCid())
-		{
-			pBomb->Explode();
-			return;
-		}
+		pBomb->Explode();
+		return;
 	}
 
 	new CSoldierBomb(GameServer(), ProjStartPos, GetCid());
@@ -1824,15 +1766,7 @@ void CInfClassHuman::FireSoldierBomb(WeaponFireContext *pFireContext)
 
 void CInfClassHuman::FireMercenaryBomb(WeaponFireContext *pFireContext)
 {
-	CMercenaryBomb *pCurrentBomb = nullptr;
-	for(CMercenaryBomb *pBomb = (CMercenaryBomb *)GameWorld()->FindFirst(CGameWorld::ENTTYPE_MERCENARY_BOMB); pBomb; pBomb = (CMercenaryBomb *)pBomb->TypeNext())
-	{
-		if(pBomb->GetOwner() == GetCid())
-		{
-			pCurrentBomb = pBomb;
-			break;
-		}
-	}
+	CMercenaryBomb *pCurrentBomb = GameWorld()->FindFirstOwned<CMercenaryBomb>(GetCid());
 
 	if(pCurrentBomb)
 	{
@@ -1945,11 +1879,9 @@ void CInfClassHuman::OnMercGrenadeFired(WeaponFireContext *pFireContext)
 	// Find bomb
 	bool BombFound = false;
 
-	for(TEntityPtr<CScatterGrenade> pGrenade = GameWorld()->FindFirst<CScatterGrenade>(); pGrenade; ++pGrenade)
+	for(CEntity *pEntity = GameWorld()->FindFirstOwned(CScatterGrenade::EntityId, GetCid()); pEntity; pEntity = pEntity->OwnedNext())
 	{
-		if(pGrenade->GetOwner() != GetCid())
-			continue;
-		pGrenade->Explode();
+		static_cast<CScatterGrenade *>(pEntity)->Explode();
 		BombFound = true;
 	}
 
@@ -2034,10 +1966,9 @@ void CInfClassHuman::OnBiologistLaserFired(WeaponFireContext *pFireContext)
 		return;
 	}
 
-	for(TEntityPtr<CBiologistMine> pMine = GameWorld()->FindFirst<CBiologistMine>(); pMine; ++pMine)
+	for(CEntity *pMine = GameWorld()->FindFirstOwned(CBiologistMine::EntityId, GetCid()); pMine; pMine = pMine->OwnedNext())
 	{
-		if(pMine->GetOwner() != GetCid()) continue;
-			GameWorld()->DestroyEntity(pMine);
+		GameWorld()->DestroyEntity(pMine);
 	}
 
 	int Lasers = Config()->m_InfBioMineLasers;
@@ -2048,15 +1979,7 @@ void CInfClassHuman::OnBiologistLaserFired(WeaponFireContext *pFireContext)
 
 void CInfClassHuman::OnMercLaserFired(WeaponFireContext *pFireContext)
 {
-	CMercenaryBomb *pCurrentBomb = nullptr;
-	for(TEntityPtr<CMercenaryBomb> pBomb = GameWorld()->FindFirst<CMercenaryBomb>(); pBomb; ++pBomb)
-	{
-		if(pBomb->GetOwner() == GetCid())
-		{
-			pCurrentBomb = pBomb;
-			break;
-		}
-	}
+	CMercenaryBomb *pCurrentBomb = GameWorld()->FindFirstOwned<CMercenaryBomb>(GetCid());
 
 	if(!pCurrentBomb)
 	{
@@ -50,26 +50,28 @@ void CBiologistMine::Snap(int SnappingClient)
 	if(!DoSnapForClient(SnappingClient))
 		return;
 
-	if(Server()->GetClientInfclassVersion(SnappingClient))
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
-	}
+	SnapCached(SnappingClient, 0, [&]() {
+		if(Server()->GetClientInfclassVersion(SnappingClient))
+		{
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+		}
 
-	float AngleStep = 2.0f * pi / m_Vertices;
-	float Radius = 32.0f;
+		float AngleStep = 2.0f * pi / m_Vertices;
+		float Radius = 32.0f;
 
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
 
-	for(int i = 0; i < m_Vertices; i++)
-	{
-		vec2 VertexPos = m_Pos + direction(AngleStep * i) * Radius;
-		GameServer()->SnapLaserObject(Context, m_Ids[i], VertexPos, m_Pos, Server()->Tick() - 4, GetOwner());
-	}
+		for(int i = 0; i < m_Vertices; i++)
+		{
+			vec2 VertexPos = m_Pos + direction(AngleStep * i) * Radius;
+			GameServer()->SnapLaserObject(Context, m_Ids[i], VertexPos, m_Pos, Server()->Tick() - 4, GetOwner());
+		}
 
-	GameServer()->SnapLaserObject(Context, m_Ids[m_Vertices], m_EndPos, m_Pos, Server()->Tick() - 4, GetOwner());
+		GameServer()->SnapLaserObject(Context, m_Ids[m_Vertices], m_EndPos, m_Pos, Server()->Tick() - 4, GetOwner());
+	});
 }
 
 void CBiologistMine::Tick()
@@ -112,35 +112,37 @@ void CEngineerWall::Snap(int SnappingClient)
 		}
 	}
 
-	if(Server()->GetClientInfclassVersion(SnappingClient))
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
-
-		if(HasSecondPosition())
+	SnapCached(SnappingClient, 0, [&]() {
+		if(Server()->GetClientInfclassVersion(SnappingClient))
 		{
-			pInfClassObject->m_EndTick = m_EndTick;
-		}
-		else
-		{
-			// Snap fake second position to fix OwnerIcon position
-			pInfClassObject->m_EndTick = -1;
-			pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_HAS_SECOND_POSITION;
-			pInfClassObject->m_X2 = pInfClassObject->m_X;
-			pInfClassObject->m_Y2 = pInfClassObject->m_Y - 1;
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+
+			if(HasSecondPosition())
+			{
+				pInfClassObject->m_EndTick = m_EndTick;
+			}
+			else
+			{
+				// Snap fake second position to fix OwnerIcon position
+				pInfClassObject->m_EndTick = -1;
+				pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_HAS_SECOND_POSITION;
+				pInfClassObject->m_X2 = pInfClassObject->m_X;
+				pInfClassObject->m_Y2 = pInfClassObject->m_Y - 1;
+			}
 		}
-	}
 
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
 
-	GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_Pos2, m_SnapStartTick, m_Owner);
+		GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_Pos2, m_SnapStartTick, m_Owner);
 
-	if(HasSecondPosition())
-	{
-		GameServer()->SnapLaserObject(Context, m_EndPointId, m_Pos2, m_Pos2, Server()->Tick(), m_Owner);
-	}
+		if(HasSecondPosition())
+		{
+			GameServer()->SnapLaserObject(Context, m_EndPointId, m_Pos2, m_Pos2, Server()->Tick(), m_Owner);
+		}
+	});
 }
 
 void CEngineerWall::OnHitInfected(CInfClassCharacter *pCharacter)
@@ -49,13 +49,9 @@ CGrowingExplosion::CGrowingExplosion(CGameContext *pGameContext, vec2 Pos, vec2
 	}
 
 	m_MaxGrowing = Radius;
-	m_GrowingMap_Length = (2*m_MaxGrowing+1);
-	m_GrowingMap_Size = (m_GrowingMap_Length * m_GrowingMap_Length);
-
-	m_pGrowingMap.resize(m_GrowingMap_Size);
-	m_pGrowingMapVec.resize(m_GrowingMap_Size);
 
 	m_StartTick = Server()->Tick();
+	m_LastGrowTick = m_StartTick;
 	
 	mem_zero(m_Hit, sizeof(m_Hit));
 
@@ -77,28 +73,8 @@ CGrowingExplosion::CGrowingExplosion(CGameContext *pGameContext, vec2 Pos, vec2
 		m_SeedPos = explosionTile;
 	}
 	
-	m_SeedX = static_cast<int>(round(m_SeedPos.x))/32;
-	m_SeedY = static_cast<int>(round(m_SeedPos.y))/32;
-	
-	for(int j=0; j<m_GrowingMap_Length; j++)
-	{
-		for(int i=0; i<m_GrowingMap_Length; i++)
-		{
-			vec2 Tile = m_SeedPos + vec2(32.0f*(i-m_MaxGrowing), 32.0f*(j-m_MaxGrowing));
-			if(GameServer()->Collision()->CheckPoint(Tile) || distance(Tile, m_SeedPos) > m_MaxGrowing*32.0f)
-			{
-				m_pGrowingMap[j*m_GrowingMap_Length+i] = -2;
-			}
-			else
-			{
-				m_pGrowingMap[j*m_GrowingMap_Length+i] = -1;
-			}
-			
-			m_pGrowingMapVec[j*m_GrowingMap_Length+i] = vec2(0.0f, 0.0f);
-		}
-	}
-	
-	m_pGrowingMap[m_MaxGrowing*m_GrowingMap_Length+m_MaxGrowing] = Server()->Tick();
+	m_GrowingMap.Init(GameServer()->Collision(), m_SeedPos, m_MaxGrowing, Server()->Tick());
+	m_pGrowingMapVec.assign(m_GrowingMap.NumCells(), vec2(0.0f, 0.0f));
 	
 	switch(m_ExplosionEffect)
 	{
@@ -119,7 +95,7 @@ CGrowingExplosion::CGrowingExplosion(CGameContext *pGameContext, vec2 Pos, vec2
 		//~ GameServer()->CreateHammerHit(m_SeedPos);
 
 		vec2 EndPoint = m_SeedPos + vec2(-16.0f + random_float()*32.0f, -16.0f + random_float()*32.0f);
-		m_pGrowingMapVec[m_MaxGrowing*m_GrowingMap_Length+m_MaxGrowing] = EndPoint;
+		m_pGrowingMapVec[m_MaxGrowing*m_GrowingMap.Length()+m_MaxGrowing] = EndPoint;
 	}
 		break;
 	default:
@@ -139,107 +115,7 @@ void CGrowingExplosion::Tick()
 		return;
 	}
 	
-	bool NewTile = false;
-	
-	for(int j=0; j<m_GrowingMap_Length; j++)
-	{
-		for(int i=0; i<m_GrowingMap_Length; i++)
-		{
-			if(m_pGrowingMap[j*m_GrowingMap_Length+i] == -1)
-			{
-				bool FromLeft = (i > 0 && m_pGrowingMap[j*m_GrowingMap_Length+i-1] < tick && m_pGrowingMap[j*m_GrowingMap_Length+i-1] >= 0);
-				bool FromRight = (i < m_GrowingMap_Length-1 && m_pGrowingMap[j*m_GrowingMap_Length+i+1] < tick && m_pGrowingMap[j*m_GrowingMap_Length+i+1] >= 0);
-				bool FromTop = (j > 0 && m_pGrowingMap[(j-1)*m_GrowingMap_Length+i] < tick && m_pGrowingMap[(j-1)*m_GrowingMap_Length+i] >= 0);
-				bool FromBottom = (j < m_GrowingMap_Length-1 && m_pGrowingMap[(j+1)*m_GrowingMap_Length+i] < tick && m_pGrowingMap[(j+1)*m_GrowingMap_Length+i] >= 0);
-				
-				if(FromLeft || FromRight || FromTop || FromBottom)
-				{
-					m_pGrowingMap[j*m_GrowingMap_Length+i] = tick;
-					NewTile = true;
-					m_VisualizedTiles++;
-					vec2 TileCenter = m_SeedPos + vec2(32.0f*(i-m_MaxGrowing) - 16.0f + random_float()*32.0f, 32.0f*(j-m_MaxGrowing) - 16.0f + random_float()*32.0f);
-					switch(m_ExplosionEffect)
-					{
-					case GROWING_EXPLOSION_EFFECT::FREEZE_INFECTED:
-						if(random_prob(0.1f))
-						{
-							GameServer()->CreateHammerHit(TileCenter);
-						}
-						break;
-					case GROWING_EXPLOSION_EFFECT::POISON_INFECTED:
-						if(random_prob(0.1f))
-						{
-							GameServer()->CreateDeath(TileCenter, m_Owner);
-						}
-						break;
-					case GROWING_EXPLOSION_EFFECT::HEAL_HUMANS:
-						if(m_VisualizedTiles % 8 == 0)
-						{
-							GameServer()->CreateDeath(TileCenter, m_Owner);
-						}
-						break;
-					case GROWING_EXPLOSION_EFFECT::LOVE_INFECTED:
-						if(random_prob(0.2f))
-						{
-							GameServer()->CreateLoveEvent(TileCenter);
-						}
-						break;
-					case GROWING_EXPLOSION_EFFECT::BOOM_INFECTED:
-						if(random_prob(0.2f))
-						{
-							float DamageFactor = m_DamageType == EDamageType::MERCENARY_BOMB ? 0 : 1;
-							GameController()->CreateExplosion(TileCenter, m_Owner, m_DamageType, DamageFactor);
-						}
-						break;
-					case GROWING_EXPLOSION_EFFECT::ELECTRIC_INFECTED:
-					{
-						vec2 EndPoint = m_SeedPos + vec2(32.0f*(i-m_MaxGrowing) - 16.0f + random_float()*32.0f, 32.0f*(j-m_MaxGrowing) - 16.0f + random_float()*32.0f);
-						m_pGrowingMapVec[j*m_GrowingMap_Length+i] = EndPoint;
-
-						int NumPossibleStartPoint = 0;
-						vec2 PossibleStartPoint[4];
-
-						if(FromLeft)
-						{
-							PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[j*m_GrowingMap_Length+i-1];
-							NumPossibleStartPoint++;
-						}
-						if(FromRight)
-						{
-							PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[j*m_GrowingMap_Length+i+1];
-							NumPossibleStartPoint++;
-						}
-						if(FromTop)
-						{
-							PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[(j-1)*m_GrowingMap_Length+i];
-							NumPossibleStartPoint++;
-						}
-						if(FromBottom)
-						{
-							PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[(j+1)*m_GrowingMap_Length+i];
-							NumPossibleStartPoint++;
-						}
-
-						if(NumPossibleStartPoint > 0)
-						{
-							int randNb = random_int(0, NumPossibleStartPoint-1);
-							vec2 StartPoint = PossibleStartPoint[randNb];
-							GameServer()->CreateLaserDotEvent(StartPoint, EndPoint, Server()->TickSpeed()/6);
-						}
-
-						if(random_prob(0.1f))
-						{
-							GameServer()->CreateSound(EndPoint, SOUND_LASER_BOUNCE);
-						}
-					}
-						break;
-					default:
-						break;
-					}
-				}
-			}
-		}
-	}
+	bool NewTile = Grow(tick);
 	
 	if(NewTile)
 	{
@@ -256,23 +132,24 @@ void CGrowingExplosion::Tick()
 		}
 	}
 	
-	// Find other players
-	for(TEntityPtr<CInfClassCharacter> p = GameWorld()->FindFirst<CInfClassCharacter>(); p; ++p)
+	// Find other players, only the ones on the tiles of the explosion can be hit
+	const float SearchRadius = (m_MaxGrowing + 1) * 32.0f * 1.5f;
+	CInfClassCharacter *apCharacters[MAX_CLIENTS];
+	int NumCharacters = GameWorld()->FindEntities(m_SeedPos, SearchRadius, (CEntity**)apCharacters, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
+	for(int c = 0; c < NumCharacters; c++)
 	{
-		int tileX = m_MaxGrowing + static_cast<int>(round(p->m_Pos.x))/32 - m_SeedX;
-		int tileY = m_MaxGrowing + static_cast<int>(round(p->m_Pos.y))/32 - m_SeedY;
-		
-		if(tileX < 0 || tileX >= m_GrowingMap_Length || tileY < 0 || tileY >= m_GrowingMap_Length)
+		CInfClassCharacter *p = apCharacters[c];
+		int k = m_GrowingMap.CellAt(p->m_Pos);
+		if(k < 0)
 			continue;
 		
 		if(m_Hit[p->GetCid()])
 			continue;
-		
-		int k = tileY*m_GrowingMap_Length+tileX;
 
-		if(m_pGrowingMap[k] >= 0)
+		const int CellTick = m_GrowingMap.CellTick(k);
+		if(CellTick >= 0)
 		{
-			if(tick - m_pGrowingMap[k] < Server()->TickSpeed()/4)
+			if(tick - CellTick < Server()->TickSpeed()/4)
 			{
 				switch(m_ExplosionEffect)
 				{
@@ -298,9 +175,9 @@ void CGrowingExplosion::Tick()
 		if(p->IsHuman())
 			continue;
 
-		if(m_pGrowingMap[k] >= 0)
+		if(CellTick >= 0)
 		{
-			if(tick - m_pGrowingMap[k] < Server()->TickSpeed()/4)
+			if(tick - CellTick < Server()->TickSpeed()/4)
 			{
 				switch(m_ExplosionEffect)
 				{
@@ -358,16 +235,14 @@ void CGrowingExplosion::Tick()
 	{
 		for(TEntityPtr<CEntity> e = GameWorld()->FindFirst(CGameWorld::ENTTYPE_SLUG_SLIME); e; ++e)
 		{
-			int tileX = m_MaxGrowing + static_cast<int>(round(e->m_Pos.x)) / 32 - m_SeedX;
-			int tileY = m_MaxGrowing + static_cast<int>(round(e->m_Pos.y)) / 32 - m_SeedY;
-
-			if(tileX < 0 || tileX >= m_GrowingMap_Length || tileY < 0 || tileY >= m_GrowingMap_Length)
+			int k = m_GrowingMap.CellAt(e->m_Pos);
+			if(k < 0)
 				continue;
 
-			int k = tileY * m_GrowingMap_Length + tileX;
-			if(m_pGrowingMap[k] >= 0)
+			const int CellTick = m_GrowingMap.CellTick(k);
+			if(CellTick >= 0)
 			{
-				if(tick - m_pGrowingMap[k] < Server()->TickSpeed() / 4)
+				if(tick - CellTick < Server()->TickSpeed() / 4)
 				{
 					e->Reset();
 				}
@@ -376,6 +251,117 @@ void CGrowingExplosion::Tick()
 	}
 }
 
+bool CGrowingExplosion::Grow(int CurrentTick)
+{
+	// The tiles reached on the previous ticks spread to their free
+	// neighbors, these are the next layer of the growing map
+	if(m_LastGrowTick >= CurrentTick || m_NextLayer >= m_GrowingMap.NumLayers())
+		return false;
+
+	m_LastGrowTick = CurrentTick;
+	const int Length = m_GrowingMap.Length();
+	auto Reached = [&](int Cell) {
+		const int CellTick = m_GrowingMap.CellTick(Cell);
+		return CellTick >= 0 && CellTick < CurrentTick;
+	};
+
+	for(const int *pCell = m_GrowingMap.LayerBegin(m_NextLayer); pCell != m_GrowingMap.LayerEnd(m_NextLayer); pCell++)
+	{
+		const int k = *pCell;
+		const int i = k % Length;
+		const int j = k / Length;
+		bool FromLeft = i > 0 && Reached(k-1);
+		bool FromRight = i < Length-1 && Reached(k+1);
+		bool FromTop = j > 0 && Reached(k-Length);
+		bool FromBottom = j < Length-1 && Reached(k+Length);
+
+		m_GrowingMap.SetCellTick(k, CurrentTick);
+		m_VisualizedTiles++;
+		vec2 TileCenter = m_SeedPos + vec2(32.0f*(i-m_MaxGrowing) - 16.0f + random_float()*32.0f, 32.0f*(j-m_MaxGrowing) - 16.0f + random_float()*32.0f);
+		switch(m_ExplosionEffect)
+		{
+		case GROWING_EXPLOSION_EFFECT::FREEZE_INFECTED:
+			if(random_prob(0.1f))
+			{
+				GameServer()->CreateHammerHit(TileCenter);
+			}
+			break;
+		case GROWING_EXPLOSION_EFFECT::POISON_INFECTED:
+			if(random_prob(0.1f))
+			{
+				GameServer()->CreateDeath(TileCenter, m_Owner);
+			}
+			break;
+		case GROWING_EXPLOSION_EFFECT::HEAL_HUMANS:
+			if(m_VisualizedTiles % 8 == 0)
+			{
+				GameServer()->CreateDeath(TileCenter, m_Owner);
+			}
+			break;
+		case GROWING_EXPLOSION_EFFECT::LOVE_INFECTED:
+			if(random_prob(0.2f))
+			{
+				GameServer()->CreateLoveEvent(TileCenter);
+			}
+			break;
+		case GROWING_EXPLOSION_EFFECT::BOOM_INFECTED:
+			if(random_prob(0.2f))
+			{
+				float DamageFactor = m_DamageType == EDamageType::MERCENARY_BOMB ? 0 : 1;
+				GameController()->CreateExplosion(TileCenter, m_Owner, m_DamageType, DamageFactor);
+			}
+			break;
+		case GROWING_EXPLOSION_EFFECT::ELECTRIC_INFECTED:
+		{
+			vec2 EndPoint = m_SeedPos + vec2(32.0f*(i-m_MaxGrowing) - 16.0f + random_float()*32.0f, 32.0f*(j-m_MaxGrowing) - 16.0f + random_float()*32.0f);
+			m_pGrowingMapVec[k] = EndPoint;
+
+			int NumPossibleStartPoint = 0;
+			vec2 PossibleStartPoint[4];
+
+			if(FromLeft)
+			{
+				PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[k-1];
+				NumPossibleStartPoint++;
+			}
+			if(FromRight)
+			{
+				PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[k+1];
+				NumPossibleStartPoint++;
+			}
+			if(FromTop)
+			{
+				PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[k-Length];
+				NumPossibleStartPoint++;
+			}
+			if(FromBottom)
+			{
+				PossibleStartPoint[NumPossibleStartPoint] = m_pGrowingMapVec[k+Length];
+				NumPossibleStartPoint++;
+			}
+
+			if(NumPossibleStartPoint > 0)
+			{
+				int randNb = random_int(0, NumPossibleStartPoint-1);
+				vec2 StartPoint = PossibleStartPoint[randNb];
+				GameServer()->CreateLaserDotEvent(StartPoint, EndPoint, Server()->TickSpeed()/6);
+			}
+
+			if(random_prob(0.1f))
+			{
+				GameServer()->CreateSound(EndPoint, SOUND_LASER_BOUNCE);
+			}
+		}
+			break;
+		default:
+			break;
+		}
+	}
+
+	m_NextLayer++;
+	return true;
+}
+
 void CGrowingExplosion::TickPaused()
 {
 	++m_StartTick;
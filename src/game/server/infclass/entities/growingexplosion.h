@@ -6,6 +6,7 @@
 
 #include "infcentity.h"
 
+#include <game/infclass/growing_map.h>
 #include <game/server/entity.h>
 #include <game/server/entities/character.h>
 
@@ -40,21 +41,20 @@ public:
 	void SetTriggeredBy(int CID);
 
 private:
+	bool Grow(int CurrentTick);
 	void ProcessMercenaryBombHit(CInfClassCharacter *pCharacter);
 
 	int m_MaxGrowing;
-	int m_GrowingMap_Length;
-	int m_GrowingMap_Size;
 	int m_VisualizedTiles{};
 	EDamageType m_DamageType;
 	int m_TriggeredByCid;
 	TAKEDAMAGEMODE m_TakeDamageMode;
 	
 	vec2 m_SeedPos;
-	int m_SeedX;
-	int m_SeedY;
 	int m_StartTick;
-	std::vector<int> m_pGrowingMap;
+	int m_LastGrowTick;
+	int m_NextLayer = 1;
+	CGrowingMap m_GrowingMap;
 	std::vector<vec2> m_pGrowingMapVec;
 	GROWING_EXPLOSION_EFFECT m_ExplosionEffect = GROWING_EXPLOSION_EFFECT::INVALID;
 	bool m_Hit[MAX_CLIENTS];
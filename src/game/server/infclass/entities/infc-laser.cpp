@@ -46,7 +46,7 @@ bool CInfClassLaser::HitCharacter(vec2 From, vec2 To)
 		return false;
 
 	m_From = From;
-	m_Pos = At;
+	SetPos(At);
 	m_Energy = -1;
 
 	return OnCharacterHit(pHit);
@@ -84,13 +84,13 @@ void CInfClassLaser::DoBounce()
 		{
 			// intersected
 			m_From = m_Pos;
-			m_Pos = To;
+			SetPos(To);
 
 			vec2 TempPos = m_Pos;
 			vec2 TempDir = m_Dir * 4.0f;
 
 			GameServer()->Collision()->MovePoint(&TempPos, &TempDir, 1.0f, 0);
-			m_Pos = TempPos;
+			SetPos(TempPos);
 			m_Dir = normalize(TempDir);
 
 			m_Energy -= distance(m_From, m_Pos) + m_BounceCost;
@@ -107,7 +107,7 @@ void CInfClassLaser::DoBounce()
 		if(!HitCharacter(m_Pos, To))
 		{
 			m_From = m_Pos;
-			m_Pos = To;
+			SetPos(To);
 			m_Energy = -1;
 		}
 	}
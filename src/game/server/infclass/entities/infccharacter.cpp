@@ -2509,11 +2509,8 @@ void CInfClassCharacter::DestroyChildEntities()
 	};
 
 	for(const auto EntityType : InfCEntities) {
-		for(CInfCEntity *p = (CInfCEntity*) GameWorld()->FindFirst(EntityType); p; p = (CInfCEntity*) p->TypeNext())
+		for(CEntity *p = GameWorld()->FindFirstOwned(EntityType, m_pPlayer->GetCid()); p; p = p->OwnedNext())
 		{
-			if(p->GetOwner() != m_pPlayer->GetCid())
-				continue;
-
 			GameServer()->m_World.DestroyEntity(p);
 		}
 	}
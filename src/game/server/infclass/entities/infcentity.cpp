@@ -7,6 +7,9 @@
 #include <game/server/infclass/entities/infccharacter.h>
 #include <game/server/infclass/infcgamecontroller.h>
 
+int64_t CInfCEntity::ms_SnapCacheHits = 0;
+int64_t CInfCEntity::ms_SnapCacheMisses = 0;
+
 static int FilterOwnerId = -1;
 static icArray<const CEntity *, 10> aFilterEntities;
 
@@ -26,6 +29,7 @@ CInfCEntity::CInfCEntity(CGameContext *pGameContext, int ObjectType, vec2 Pos, i
 	: CEntity(pGameContext->GameWorld(), ObjectType, Pos, ProximityRadius)
 	, m_Owner(Owner)
 {
+	GameWorld()->SetEntityOwner(this, Owner);
 }
 
 CInfClassGameController *CInfCEntity::GameController()
@@ -33,6 +37,12 @@ CInfClassGameController *CInfCEntity::GameController()
 	return static_cast<CInfClassGameController*>(GameServer()->m_pController);
 }
 
+void CInfCEntity::SetOwner(int Owner)
+{
+	m_Owner = Owner;
+	GameWorld()->SetEntityOwner(this, Owner);
+}
+
 CInfClassCharacter *CInfCEntity::GetOwnerCharacter()
 {
 	return GameController()->GetCharacter(GetOwner());
@@ -77,11 +87,6 @@ void CInfCEntity::Tick()
 	}
 }
 
-void CInfCEntity::SetPos(const vec2 &Position)
-{
-	m_Pos = Position;
-}
-
 void CInfCEntity::SetAnimatedPos(const vec2 &Pivot, const vec2 &RelPosition, int PosEnv)
 {
 	m_Pivot = Pivot;
@@ -89,6 +94,61 @@ void CInfCEntity::SetAnimatedPos(const vec2 &Pivot, const vec2 &RelPosition, int
 	m_PosEnv = PosEnv;
 }
 
+void CInfCEntity::ResetSnapCacheStats()
+{
+	ms_SnapCacheHits = 0;
+	ms_SnapCacheMisses = 0;
+}
+
+CInfCEntity::CSnapCacheKey CInfCEntity::GetSnapCacheKey(int SnappingClient, int Variant)
+{
+	CSnapCacheKey Key;
+	Key.m_ClientVersion = GameServer()->GetClientVersion(SnappingClient);
+	Key.m_InfclassVersion = Server()->GetClientInfclassVersion(SnappingClient);
+	Key.m_Sixup = Server()->IsSixup(SnappingClient);
+	Key.m_Variant = Variant;
+	return Key;
+}
+
+bool CInfCEntity::ReplaySnapCache(const CSnapCacheKey &Key)
+{
+	if(m_SnapCacheTick != Server()->Tick())
+	{
+		m_SnapCacheTick = Server()->Tick();
+		m_NumSnapCacheEntries = 0;
+	}
+
+	for(int i = 0; i < m_NumSnapCacheEntries; i++)
+	{
+		if(m_vSnapCache[i].m_Key == Key)
+		{
+			ms_SnapCacheHits++;
+			Server()->SnapReplayItems(m_vSnapCache[i].m_vItems);
+			return true;
+		}
+	}
+
+	ms_SnapCacheMisses++;
+	return false;
+}
+
+void CInfCEntity::BeginSnapCache()
+{
+	Server()->SnapStartRecording();
+}
+
+void CInfCEntity::EndSnapCache(const CSnapCacheKey &Key)
+{
+	if(m_NumSnapCacheEntries == static_cast<int>(m_vSnapCache.size()))
+	{
+		m_vSnapCache.emplace_back();
+	}
+
+	CSnapCacheEntry &Entry = m_vSnapCache[m_NumSnapCacheEntries++];
+	Entry.m_Key = Key;
+	Server()->SnapStopRecording(&Entry.m_vItems);
+}
+
 bool CInfCEntity::DoSnapForClient(int SnappingClient)
 {
 	if(NetworkClipped(SnappingClient))
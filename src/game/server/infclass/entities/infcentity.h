@@ -5,6 +5,8 @@
 
 #include <game/server/entity.h>
 
+#include <vector>
+
 inline constexpr int TileSize = 32;
 inline constexpr float TileSizeF = 32.0f;
 
@@ -26,6 +28,7 @@ public:
 
 	CInfClassGameController *GameController();
 	int GetOwner() const { return m_Owner; }
+	void SetOwner(int Owner);
 	CInfClassCharacter *GetOwnerCharacter();
 	CInfClassPlayerClass *GetOwnerClass();
 
@@ -37,17 +40,73 @@ public:
 	void Reset() override;
 	void Tick() override;
 
-	void SetPos(const vec2 &Position);
 	void SetAnimatedPos(const vec2 &Pivot, const vec2 &RelPosition, int PosEnv);
 
+	static int64_t SnapCacheHits() { return ms_SnapCacheHits; }
+	static int64_t SnapCacheMisses() { return ms_SnapCacheMisses; }
+	static void ResetSnapCacheStats();
+
 protected:
 	virtual bool DoSnapForClient(int SnappingClient);
 	void SyncPosition();
 
+	// Runs SnapFunction once per tick for each distinct (client version,
+	// infclass version, sixup, Variant) combination and replays the recorded
+	// items for the other clients. SnapFunction must only depend on the
+	// entity state, the tick and the properties above; per-client visibility
+	// has to be checked before calling this.
+	template<typename F>
+	void SnapCached(int SnappingClient, int Variant, F &&SnapFunction)
+	{
+		const CSnapCacheKey Key = GetSnapCacheKey(SnappingClient, Variant);
+		if(ReplaySnapCache(Key))
+			return;
+
+		BeginSnapCache();
+		SnapFunction();
+		EndSnapCache(Key);
+	}
+
+	// Use SetOwner() to change it, the world keeps an index of the owners
 	int m_Owner = 0;
 	vec2 m_Pivot;
 	vec2 m_RelPosition;
 	int m_PosEnv = -1;
+
+private:
+	struct CSnapCacheKey
+	{
+		int m_ClientVersion;
+		int m_InfclassVersion;
+		bool m_Sixup;
+		int m_Variant;
+
+		bool operator==(const CSnapCacheKey &Other) const
+		{
+			return m_ClientVersion == Other.m_ClientVersion && m_InfclassVersion == Other.m_InfclassVersion &&
+			       m_Sixup == Other.m_Sixup && m_Variant == Other.m_Variant;
+		}
+	};
+
+	struct CSnapCacheEntry
+	{
+		CSnapCacheKey m_Key;
+		std::vector<int> m_vItems;
+	};
+
+	CSnapCacheKey GetSnapCacheKey(int SnappingClient, int Variant);
+	bool ReplaySnapCache(const CSnapCacheKey &Key);
+	void BeginSnapCache();
+	void EndSnapCache(const CSnapCacheKey &Key);
+
+	// Entries are only valid for m_SnapCacheTick, the vectors are kept
+	// around to reuse their storage
+	std::vector<CSnapCacheEntry> m_vSnapCache;
+	int m_NumSnapCacheEntries = 0;
+	int m_SnapCacheTick = -1;
+
+	static int64_t ms_SnapCacheHits;
+	static int64_t ms_SnapCacheMisses;
 };
 
 #endif // GAME_SERVER_ENTITIES_INFC_ENTITY_H
@@ -135,70 +135,76 @@ void CLooperWall::Snap(int SnappingClient)
 		}
 	}
 
-	if(Server()->GetClientInfclassVersion(SnappingClient))
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
+	const bool AntiPing = pDestPlayer && pDestPlayer->GetAntiPingEnabled();
 
-		if(HasSecondPosition())
-		{
-			pInfClassObject->m_EndTick = m_EndTick;
-		}
-		else
+	SnapCached(SnappingClient, AntiPing, [&]() {
+		if(Server()->GetClientInfclassVersion(SnappingClient))
 		{
-			// Snap fake second position to fix OwnerIcon position
-			pInfClassObject->m_EndTick = -1;
-			pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_HAS_SECOND_POSITION;
-			pInfClassObject->m_X2 = pInfClassObject->m_X;
-			pInfClassObject->m_Y2 = pInfClassObject->m_Y - 1;
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+
+			if(HasSecondPosition())
+			{
+				pInfClassObject->m_EndTick = m_EndTick;
+			}
+			else
+			{
+				// Snap fake second position to fix OwnerIcon position
+				pInfClassObject->m_EndTick = -1;
+				pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_HAS_SECOND_POSITION;
+				pInfClassObject->m_X2 = pInfClassObject->m_X;
+				pInfClassObject->m_Y2 = pInfClassObject->m_Y - 1;
+			}
 		}
-	}
 
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
 
-	if(!HasSecondPosition())
-	{
-		for(int i = 0; i < 2; i++)
+		if(!HasSecondPosition())
 		{
-			// draws the first two dots + the lasers
-			vec2 Pos = m_Pos;
-			Pos.x += g_Thickness * 0.5 - g_Thickness * i;
-			GameServer()->SnapLaserObject(Context, m_Ids[i], Pos, Pos, m_SnapStartTick);
+			for(int i = 0; i < 2; i++)
+			{
+				// draws the first two dots + the lasers
+				vec2 Pos = m_Pos;
+				Pos.x += g_Thickness * 0.5 - g_Thickness * i;
+				GameServer()->SnapLaserObject(Context, m_Ids[i], Pos, Pos, m_SnapStartTick);
+			}
+			return;
 		}
-		return;
-	}
 
-	const bool AntiPing = pDestPlayer && pDestPlayer->GetAntiPingEnabled();
-	vec2 dirVec = vec2(m_Pos.x-m_Pos2.x, m_Pos.y-m_Pos2.y);
-	vec2 dirVecN = normalize(dirVec);
-	vec2 dirVecT = vec2(dirVecN.y * g_Thickness * 0.5f, -dirVecN.x * g_Thickness * 0.5f);
+		vec2 dirVec = vec2(m_Pos.x-m_Pos2.x, m_Pos.y-m_Pos2.y);
+		vec2 dirVecN = normalize(dirVec);
+		vec2 dirVecT = vec2(dirVecN.y * g_Thickness * 0.5f, -dirVecN.x * g_Thickness * 0.5f);
 
-	for(int i = 0; i < 2; i++)
-	{
-		if(i == 1)
+		for(int i = 0; i < 2; i++)
 		{
-			dirVecT.x = -dirVecT.x;
-			dirVecT.y = -dirVecT.y;
-		}
+			if(i == 1)
+			{
+				dirVecT.x = -dirVecT.x;
+				dirVecT.y = -dirVecT.y;
+			}
 
-		// draws the first two dots + the lasers
-		GameServer()->SnapLaserObject(Context, m_Ids[i], m_Pos + dirVecT, m_Pos2 + dirVecT, m_SnapStartTick);
+			// draws the first two dots + the lasers
+			GameServer()->SnapLaserObject(Context, m_Ids[i], m_Pos + dirVecT, m_Pos2 + dirVecT, m_SnapStartTick);
 
-		// draws one dot at the end of each laser
-		if(!AntiPing)
-		{
-			GameServer()->SnapLaserObject(Context, m_EndPointIds[i], m_Pos2 + dirVecT, m_Pos2 + dirVecT, Server()->Tick());
+			// draws one dot at the end of each laser
+			if(!AntiPing)
+			{
+				GameServer()->SnapLaserObject(Context, m_EndPointIds[i], m_Pos2 + dirVecT, m_Pos2 + dirVecT, Server()->Tick());
+			}
 		}
-	}
+	});
 
-	// draw particles inside wall
-	if(!AntiPing)
+	// draw particles inside wall, random for each client so not cached
+	if(!AntiPing && HasSecondPosition())
 	{
-		vec2 startPos = vec2(m_Pos2.x+dirVecT.x, m_Pos2.y+dirVecT.y);
-		dirVecT.x = -dirVecT.x*2.0f;
-		dirVecT.y = -dirVecT.y*2.0f;
+		vec2 dirVec = vec2(m_Pos.x-m_Pos2.x, m_Pos.y-m_Pos2.y);
+		vec2 dirVecN = normalize(dirVec);
+		vec2 dirVecT = vec2(dirVecN.y * g_Thickness * 0.5f, -dirVecN.x * g_Thickness * 0.5f);
+		vec2 startPos = vec2(m_Pos2.x-dirVecT.x, m_Pos2.y-dirVecT.y);
+		dirVecT.x = dirVecT.x*2.0f;
+		dirVecT.y = dirVecT.y*2.0f;
 
 		int particleCount = length(dirVec) / g_BarrierMaxLength * static_cast<float>(NUM_PARTICLES);
 		for(int i=0; i<particleCount; i++)
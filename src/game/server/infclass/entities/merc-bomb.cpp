@@ -102,38 +102,40 @@ void CMercenaryBomb::Snap(int SnappingClient)
 	if(!DoSnapForClient(SnappingClient))
 		return;
 
-	if(Server()->GetClientInfclassVersion(SnappingClient))
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
-	}
+	SnapCached(SnappingClient, SnappingClient == m_Owner, [&]() {
+		if(Server()->GetClientInfclassVersion(SnappingClient))
+		{
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+		}
 
-	float AngleStart = (2.0f * pi * Server()->Tick()/static_cast<float>(Server()->TickSpeed()))/10.0f;
-	float AngleStep = 2.0f * pi / static_cast<float>(CMercenaryBomb::NUM_SIDE);
-	float R = 50.0f * static_cast<float>(m_Load) / Config()->m_InfMercBombs;
-	for(int i = 0; i < CMercenaryBomb::NUM_SIDE; i++)
-	{
-		vec2 PosStart = m_Pos + vec2(R * cos(AngleStart + AngleStep*i), R * sin(AngleStart + AngleStep*i));
+		float AngleStart = (2.0f * pi * Server()->Tick()/static_cast<float>(Server()->TickSpeed()))/10.0f;
+		float AngleStep = 2.0f * pi / static_cast<float>(CMercenaryBomb::NUM_SIDE);
+		float R = 50.0f * static_cast<float>(m_Load) / Config()->m_InfMercBombs;
+		for(int i = 0; i < CMercenaryBomb::NUM_SIDE; i++)
+		{
+			vec2 PosStart = m_Pos + vec2(R * cos(AngleStart + AngleStep*i), R * sin(AngleStart + AngleStep*i));
 
-		CNetObj_Pickup *pP = Server()->SnapNewItem<CNetObj_Pickup>(m_Ids[i]);
-		if(!pP)
-			return;
+			CNetObj_Pickup *pP = Server()->SnapNewItem<CNetObj_Pickup>(m_Ids[i]);
+			if(!pP)
+				return;
 
-		pP->m_X = (int)PosStart.x;
-		pP->m_Y = (int)PosStart.y;
-		pP->m_Type = POWERUP_HEALTH;
-		pP->m_Subtype = 0;
-	}
+			pP->m_X = (int)PosStart.x;
+			pP->m_Y = (int)PosStart.y;
+			pP->m_Type = POWERUP_HEALTH;
+			pP->m_Subtype = 0;
+		}
 
-	if(SnappingClient == m_Owner && m_LoadingTick > 0)
-	{
-		R = GetProximityRadius();
-		AngleStart = AngleStart * 2.0f;
-		for(int i = 0; i < CMercenaryBomb::NUM_SIDE; i++)
+		if(SnappingClient == m_Owner && m_LoadingTick > 0)
 		{
-			vec2 PosStart = m_Pos + vec2(R * cos(AngleStart + AngleStep * i), R * sin(AngleStart + AngleStep * i));
-			GameController()->SendHammerDot(PosStart, m_Ids[CMercenaryBomb::NUM_SIDE+i]);
+			R = GetProximityRadius();
+			AngleStart = AngleStart * 2.0f;
+			for(int i = 0; i < CMercenaryBomb::NUM_SIDE; i++)
+			{
+				vec2 PosStart = m_Pos + vec2(R * cos(AngleStart + AngleStep * i), R * sin(AngleStart + AngleStep * i));
+				GameController()->SendHammerDot(PosStart, m_Ids[CMercenaryBomb::NUM_SIDE+i]);
+			}
 		}
-	}
+	});
 }
@@ -54,7 +54,7 @@ void CPlasma::Tick()
 		{
 			m_Dir = normalize(pTarget->GetPos() - GetPos());
 			m_Speed = clamp(Dist, 0.0f, 16.0f) * (1.0f - m_InitialAmount);
-			m_Pos += m_Dir*m_Speed;
+			SetPos(m_Pos + m_Dir * m_Speed);
 			
 			m_InitialAmount *= 0.98f;
 			
@@ -83,7 +83,7 @@ void CScatterGrenade::Tick()
 		CollisionPos.y = LastPos.y;
 		int CollideX = GameServer()->Collision()->IntersectLineWeapon(PrevPos, CollisionPos, NULL, NULL);
 		
-		m_Pos = LastPos;
+		SetPos(LastPos);
 		m_ActualPos = m_Pos;
 		vec2 vel;
 		vel.x = m_Direction.x;
@@ -43,7 +43,7 @@ void CScientistLaser::DoBounce()
 		if(!HitCharacter(m_Pos, To))
 		{
 			m_From = m_Pos;
-			m_Pos = To;
+			SetPos(To);
 			m_Energy = -1;
 		}
 	}
@@ -52,7 +52,7 @@ void CScientistLaser::DoBounce()
 		if(!HitCharacter(m_Pos, To))
 		{
 			m_From = m_Pos;
-			m_Pos = To;
+			SetPos(To);
 			m_Energy = -1;
 		}
 	}
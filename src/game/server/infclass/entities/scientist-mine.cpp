@@ -63,43 +63,49 @@ void CScientistMine::Snap(int SnappingClient)
 	if(!DoSnapForClient(SnappingClient))
 		return;
 
-	float Radius = GetProximityRadius();
+	const CInfClassPlayer *pPlayer = GameController()->GetPlayer(SnappingClient);
+	const bool AntiPing = pPlayer && pPlayer->GetAntiPingEnabled();
 
-	int InfclassVersion = Server()->GetClientInfclassVersion(SnappingClient);
-	if(InfclassVersion)
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
+	SnapCached(SnappingClient, AntiPing, [&]() {
+		float Radius = GetProximityRadius();
 
-		pInfClassObject->m_StartTick = m_StartTick;
-		if(InfclassVersion >= VERSION_INFC_180)
+		int InfclassVersion = Server()->GetClientInfclassVersion(SnappingClient);
+		if(InfclassVersion)
 		{
-			pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_RELY_ON_CLIENTSIDE_RENDERING;
-			return;
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+
+			pInfClassObject->m_StartTick = m_StartTick;
+			if(InfclassVersion >= VERSION_INFC_180)
+			{
+				pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_RELY_ON_CLIENTSIDE_RENDERING;
+				return;
+			}
 		}
-	}
 
-	const CInfClassPlayer *pPlayer = GameController()->GetPlayer(SnappingClient);
-	const bool AntiPing = pPlayer && pPlayer->GetAntiPingEnabled();
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
 
-	int NumSide = CScientistMine::NUM_SIDE;
-	if(AntiPing)
-		NumSide = std::min(6, NumSide);
-	
-	float AngleStep = 2.0f * pi / NumSide;
-	
-	for(int i=0; i<NumSide; i++)
-	{
-		vec2 PartPosStart = m_Pos + direction(AngleStep * i) * Radius;
-		vec2 PartPosEnd = m_Pos + direction(AngleStep * (i + 1)) * Radius;
-		GameServer()->SnapLaserObject(Context, m_Ids[i], PartPosStart, PartPosEnd, Server()->Tick(), GetOwner());
-	}
+		int NumSide = CScientistMine::NUM_SIDE;
+		if(AntiPing)
+			NumSide = std::min(6, NumSide);
+		
+		float AngleStep = 2.0f * pi / NumSide;
+		
+		for(int i=0; i<NumSide; i++)
+		{
+			vec2 PartPosStart = m_Pos + direction(AngleStep * i) * Radius;
+			vec2 PartPosEnd = m_Pos + direction(AngleStep * (i + 1)) * Radius;
+			GameServer()->SnapLaserObject(Context, m_Ids[i], PartPosStart, PartPosEnd, Server()->Tick(), GetOwner());
+		}
+	});
 
-	if(!AntiPing)
+	// the particles are random for each client so not cached, the clients
+	// rendering the mine draw their own
+	if(!AntiPing && Server()->GetClientInfclassVersion(SnappingClient) < VERSION_INFC_180)
 	{
+		float Radius = GetProximityRadius();
 		for(int i = 0; i < CScientistMine::NUM_PARTICLES; i++)
 		{
 			float RandomRadius = random_float() * (Radius - 4.0f);
@@ -81,7 +81,7 @@ bool CSlugSlime::Replenish(int PlayerId, int EndTick)
 	if(m_EndTick > EndTick)
 		return false;
 
-	m_Owner = PlayerId;
+	SetOwner(PlayerId);
 	m_EndTick = EndTick;
 	return true;
 }
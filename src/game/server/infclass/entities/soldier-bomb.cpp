@@ -104,34 +104,36 @@ void CSoldierBomb::Snap(int SnappingClient)
 	if(!DoSnapForClient(SnappingClient))
 		return;
 
-	int InfclassVersion = Server()->GetClientInfclassVersion(SnappingClient);
-	if(InfclassVersion)
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
-
-		pInfClassObject->m_StartTick = m_StartTick;
-		pInfClassObject->m_Data1 = m_nbBomb;
-		if(InfclassVersion >= VERSION_INFC_180)
+	SnapCached(SnappingClient, 0, [&]() {
+		int InfclassVersion = Server()->GetClientInfclassVersion(SnappingClient);
+		if(InfclassVersion)
 		{
-			pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_RELY_ON_CLIENTSIDE_RENDERING;
-			return;
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
+
+			pInfClassObject->m_StartTick = m_StartTick;
+			pInfClassObject->m_Data1 = m_nbBomb;
+			if(InfclassVersion >= VERSION_INFC_180)
+			{
+				pInfClassObject->m_Flags |= INFCLASS_OBJECT_FLAG_RELY_ON_CLIENTSIDE_RENDERING;
+				return;
+			}
 		}
-	}
 
-	for(int i = 0; i < m_nbBomb; i++)
-	{
-		float shiftedAngle = m_Angle + 2.0 * pi * static_cast<float>(i) / static_cast<float>(m_IdBomb.size());
-
-		CNetObj_Projectile *pProj = Server()->SnapNewItem<CNetObj_Projectile>(m_IdBomb[i]);
-		pProj->m_X = m_Pos.x + SoldierBombRadius * std::cos(shiftedAngle);
-		pProj->m_Y = m_Pos.y + SoldierBombRadius * std::sin(shiftedAngle);
-		pProj->m_VelX = 0;
-		pProj->m_VelY = 0;
-		pProj->m_StartTick = Server()->Tick();
-		pProj->m_Type = WEAPON_GRENADE;
-	}
+		for(int i = 0; i < m_nbBomb; i++)
+		{
+			float shiftedAngle = m_Angle + 2.0 * pi * static_cast<float>(i) / static_cast<float>(m_IdBomb.size());
+
+			CNetObj_Projectile *pProj = Server()->SnapNewItem<CNetObj_Projectile>(m_IdBomb[i]);
+			pProj->m_X = m_Pos.x + SoldierBombRadius * std::cos(shiftedAngle);
+			pProj->m_Y = m_Pos.y + SoldierBombRadius * std::sin(shiftedAngle);
+			pProj->m_VelX = 0;
+			pProj->m_VelY = 0;
+			pProj->m_StartTick = Server()->Tick();
+			pProj->m_Type = WEAPON_GRENADE;
+		}
+	});
 }
 
 void CSoldierBomb::Tick()
@@ -195,32 +195,35 @@ void CTurret::Snap(int SnappingClient)
 	if(!DoSnapForClient(SnappingClient))
 		return;
 
-	if(Server()->GetClientInfclassVersion(SnappingClient))
-	{
-		CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
-		if(!pInfClassObject)
-			return;
-
-		pInfClassObject->m_StartTick = m_StartTick;
-		pInfClassObject->m_EndTick = m_EndTick;
-	}
-
 	const CInfClassPlayer *pPlayer = GameController()->GetPlayer(SnappingClient);
 	const bool AntiPing = pPlayer && pPlayer->GetAntiPingEnabled();
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
 
-	float time = (Server()->Tick() - m_StartTick) / (float)Server()->TickSpeed();
-	float angle = fmodf(time * pi / 2, 2.0f * pi);
-	GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_Pos, Server()->Tick(), GetOwner());
+	SnapCached(SnappingClient, AntiPing, [&]() {
+		if(Server()->GetClientInfclassVersion(SnappingClient))
+		{
+			CNetObj_InfClassObject *pInfClassObject = SnapInfClassObject();
+			if(!pInfClassObject)
+				return;
 
-	int Dots = AntiPing ? 2 : std::size(m_Ids);
-	for(int i = 0; i < Dots; i++)
-	{
-		float shiftedAngle = angle + 2.0 * pi * i / static_cast<float>(Dots);
-		vec2 Direction = vec2(cos(shiftedAngle), sin(shiftedAngle));
-		GameController()->SendHammerDot(m_Pos + Direction * m_Radius, m_Ids[i]);
-	}
+			pInfClassObject->m_StartTick = m_StartTick;
+			pInfClassObject->m_EndTick = m_EndTick;
+		}
+
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
+
+		float time = (Server()->Tick() - m_StartTick) / (float)Server()->TickSpeed();
+		float angle = fmodf(time * pi / 2, 2.0f * pi);
+		GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_Pos, Server()->Tick(), GetOwner());
+
+		int Dots = AntiPing ? 2 : std::size(m_Ids);
+		for(int i = 0; i < Dots; i++)
+		{
+			float shiftedAngle = angle + 2.0 * pi * i / static_cast<float>(Dots);
+			vec2 Direction = vec2(cos(shiftedAngle), sin(shiftedAngle));
+			GameController()->SendHammerDot(m_Pos + Direction * m_Radius, m_Ids[i]);
+		}
+	});
 }
 
 void CTurret::Die(CInfClassCharacter *pKiller)
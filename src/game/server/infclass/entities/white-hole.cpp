@@ -93,32 +93,35 @@ void CWhiteHole::Snap(int SnappingClient)
 
 	const CInfClassPlayer *pPlayer = GameController()->GetPlayer(SnappingClient);
 	const bool AntiPing = pPlayer && pPlayer->GetAntiPingEnabled();
-	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CSnapContext Context(SnappingClientVersion);
 
-	// Draw AntiPing white hole effect
-	if(AntiPing)
-	{
-		int NumSide = 6;
-		float AngleStep = 2.0f * pi / NumSide;
-		float Radius = Config()->m_InfWhiteHoleRadius;
-		for(int i=0; i<NumSide; i++)
+	SnapCached(SnappingClient, AntiPing, [&]() {
+		int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
+		CSnapContext Context(SnappingClientVersion);
+
+		// Draw AntiPing white hole effect
+		if(AntiPing)
 		{
-			vec2 PartPosStart = m_Pos + vec2(Radius * cos(AngleStep*i), Radius * sin(AngleStep*i));
-			vec2 PartPosEnd = m_Pos + vec2(Radius * cos(AngleStep*(i+1)), Radius * sin(AngleStep*(i+1)));
-			GameServer()->SnapLaserObject(Context, m_Ids[i], PartPosStart, PartPosEnd, Server()->Tick());
+			int NumSide = 6;
+			float AngleStep = 2.0f * pi / NumSide;
+			float Radius = Config()->m_InfWhiteHoleRadius;
+			for(int i=0; i<NumSide; i++)
+			{
+				vec2 PartPosStart = m_Pos + vec2(Radius * cos(AngleStep*i), Radius * sin(AngleStep*i));
+				vec2 PartPosEnd = m_Pos + vec2(Radius * cos(AngleStep*(i+1)), Radius * sin(AngleStep*(i+1)));
+				GameServer()->SnapLaserObject(Context, m_Ids[i], PartPosStart, PartPosEnd, Server()->Tick());
+			}
+			return;
 		}
-		return;
-	}
 
-	// Draw full particle effect - if anti ping is not set to true
-	for(int i=0; i<m_NumParticles; i++)
-	{
-		if(!m_IsDieing && distance(m_ParticlePos[i], m_Pos) > m_Radius)
-			continue; // start animation
+		// Draw full particle effect - if anti ping is not set to true
+		for(int i=0; i<m_NumParticles; i++)
+		{
+			if(!m_IsDieing && distance(m_ParticlePos[i], m_Pos) > m_Radius)
+				continue; // start animation
 
-		GameController()->SendHammerDot(m_ParticlePos[i], m_Ids[i]);
-	}
+			GameController()->SendHammerDot(m_ParticlePos[i], m_Ids[i]);
+		}
+	});
 }
 
 void CWhiteHole::MoveParticles()
@@ -18,28 +18,28 @@ enum class EventType
 	Winter,
 };
 
-static EventType PreloadedMapEventType = EventType::None;
+// Thread local, the client maps are also converted on the job threads
+static thread_local EventType PreloadedMapEventType = EventType::None;
 static char aEventId[32] = {0};
 
-const char *EventsDirector::GetMapConverterId(const char *pConverterId)
+const char *EventsDirector::GetMapConverterId(const char *pConverterId, const char *pEvent)
 {
-	static char CustomConverterId[32] = {0};
+	static thread_local char CustomConverterId[32] = {0};
 	switch(PreloadedMapEventType)
 	{
 	case EventType::None:
 	case EventType::Generic:
 		break;
 	case EventType::Winter:
-		str_format(&CustomConverterId[0], sizeof(CustomConverterId), "%s_%s", pConverterId, g_Config.m_InfEvent);
+		str_format(&CustomConverterId[0], sizeof(CustomConverterId), "%s_%s", pConverterId, pEvent);
 		return CustomConverterId;
 	}
 
 	return pConverterId;
 }
 
-void EventsDirector::SetPreloadedMapName(const char *pName)
+void EventsDirector::SetPreloadedMapName(const char *pName, const char *pEvent)
 {
-	const char *pEvent = g_Config.m_InfEvent;
 	PreloadedMapEventType = EventType::None;
 
 	if(pEvent[0])
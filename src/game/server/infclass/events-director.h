@@ -7,9 +7,11 @@ class CSkinContext;
 class EventsDirector
 {
 public:
-	static const char *GetMapConverterId(const char *pConverterId);
+	// pEvent is the inf_event the map is loaded for, passed by the caller
+	// as the client maps are also converted on the job threads
+	static const char *GetMapConverterId(const char *pConverterId, const char *pEvent);
 
-	static void SetPreloadedMapName(const char *pName);
+	static void SetPreloadedMapName(const char *pName, const char *pEvent);
 	static void SetupSkin(const CSkinContext &Context, CWeakSkinInfo *pOutput, int DDNetVersion, int InfClassVersion);
 	static const char *GetEventMapName(const char *pMapName);
 
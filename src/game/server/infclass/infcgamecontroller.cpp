@@ -22,6 +22,7 @@
 #include <engine/server/roundstatistics.h>
 #include <engine/shared/config.h>
 #include <engine/shared/network.h>
+#include <engine/shared/profiler.h>
 #include <game/mapitems.h>
 #include <iterator>
 #include <time.h>
@@ -1489,6 +1490,7 @@ void CInfClassGameController::RegisterChatCommands(IConsole *pConsole)
 	pConsole->Register("queue_fun_round", "", CFGFLAG_SERVER, ConQueueFunRound, this, "Queue a fun gameplay round");
 	pConsole->Register("print_players_picking", "", CFGFLAG_SERVER, ConPrintPlayerPickingTimestamp, this, "");
 	pConsole->Register("map_rotation_status", "", CFGFLAG_SERVER, ConMapRotationStatus, this, "Print the status of map rotation");
+	pConsole->Register("snap_cache_stats", "?i[reset]", CFGFLAG_SERVER, ConSnapCacheStats, this, "Print the hit rate of the entities snap cache");
 
 	pConsole->Register("save_maps_data", "s[filename]", CFGFLAG_SERVER, ConSaveMapsData, this, "Save the map rotation data to a file");
 	pConsole->Register("print_maps_data", "", CFGFLAG_SERVER, ConPrintMapsData, this, "Print the data of map rotation");
@@ -1927,6 +1929,25 @@ void CInfClassGameController::ConMapRotationStatus(IConsole::IResult *pResult, v
 	pSelf->ConSmartMapRotationStatus();
 }
 
+void CInfClassGameController::ConSnapCacheStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CInfClassGameController *pSelf = (CInfClassGameController *)pUserData;
+
+	const int64_t Hits = CInfCEntity::SnapCacheHits();
+	const int64_t Total = Hits + CInfCEntity::SnapCacheMisses();
+	const float HitRate = Total ? 100.0f * Hits / Total : 0.0f;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "snap cache: %lld hits, %lld misses (%.1f%% hit rate)",
+		(long long)Hits, (long long)(Total - Hits), HitRate);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "infclass", aBuf);
+
+	if(pResult->NumArguments() > 0 && pResult->GetInteger(0))
+	{
+		CInfCEntity::ResetSnapCacheStats();
+	}
+}
+
 void CInfClassGameController::ConSaveMapsData(IConsole::IResult *pResult, void *pUserData)
 {
 	const char *pFileName = pResult->GetString(0);
@@ -2059,7 +2080,7 @@ void CInfClassGameController::ConLoadPosition(IConsole::IResult *pResult)
 
 	pPlayer->LoadSavedPosition(&Position);
 
-	pCharacter->m_Pos = Position;
+	pCharacter->SetPos(Position);
 	pCharacter->SetPosition(Position);
 	pCharacter->ResetVelocity();
 	GameWorld()->ReleaseHooked(ClientId);
@@ -2496,26 +2517,15 @@ void CInfClassGameController::SendHintMessage()
 	const int MessageIndex = random_int(0, std::size(gs_aHintMessages) - 1);
 	const CHintMessage &Message = gs_aHintMessages[MessageIndex];
 	dynamic_string Buffer;
-	const char *pPrevLang = nullptr;
-	bool Sent = false;
-
-	const auto PrepareBufferForLanguage = [&](const char *pLang) {
-		if(!pPrevLang || str_comp(pLang, pPrevLang) != 0)
-		{
-			pPrevLang = pLang;
-
-			FormatHintMessage(Message, &Buffer, pLang);
-		}
-	};
 
-	for(int CID = 0; CID < MAX_CLIENTS; ++CID)
+	CGameContext::CRecipientLanguages Languages;
+	GameServer()->GetRecipientLanguages(-1, &Languages, true);
+	for(int l = 0; l < Languages.m_NumLanguages; l++)
 	{
-		const CInfClassPlayer *pPlayer = GetPlayer(CID);
-		if(!pPlayer || pPlayer->IsBot() || !pPlayer->m_IsReady)
-			continue;
-		PrepareBufferForLanguage(GetPlayer(CID)->GetLanguage());
-		GameServer()->SendChatTarget(CID, Buffer.buffer());
+		FormatHintMessage(Message, &Buffer, Languages.m_apLanguages[l]);
+		GameServer()->SendChatToLanguage(Buffer.buffer(), Languages, l);
 	}
+	const bool Sent = Languages.m_NumLanguages > 0;
 
 	if(Sent && g_Config.m_SvDemoChat)
 	{
@@ -2524,7 +2534,7 @@ void CInfClassGameController::SendHintMessage()
 		Msg.m_Team = 0;
 		Msg.m_ClientId = -1;
 
-		PrepareBufferForLanguage("en");
+		FormatHintMessage(Message, &Buffer, "en");
 		Msg.m_pMessage = Buffer.buffer();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NOSEND, SERVER_DEMO_CLIENT);
 
@@ -3250,6 +3260,9 @@ void CInfClassGameController::TickBeforeWorld()
 }
 void CInfClassGameController::Tick()
 {
+	static CProfiler::CZone *s_pProfileZone = CProfiler::Zone("controller/tick");
+	CProfileScope ProfileScope(s_pProfileZone);
+
 	IGameController::Tick();
 
 	//Check session
@@ -235,6 +235,7 @@ public:
 	static void ConPrintPlayerPickingTimestamp(IConsole::IResult *pResult, void *pUserData);
 	void ConPrintPlayerPickingTimestamp(IConsole::IResult *pResult);
 	static void ConMapRotationStatus(IConsole::IResult *pResult, void *pUserData);
+	static void ConSnapCacheStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConSaveMapsData(IConsole::IResult *pResult, void *pUserData);
 	static void ConPrintMapsData(IConsole::IResult *pResult, void *pUserData);
 	static void ConResetMapData(IConsole::IResult *pResult, void *pUserData);
@@ -1,16 +0,0 @@
-/* GeoLite2++ (C) 2016-2018 Stephane Charette <stephanecharette@gmail.com>
- * $Id: GeoLite2PP_version.hpp.in 2549 2018-06-08 18:48:31Z stephane $
- */
-
-#pragma once
-
-
-/** @file
- * This source file is processed by cmake to include the version number.
- */
-
-
-/** This version tag is automatically updated by the build process.
- * Do not edit manually!  See GeoLite2PP_version.hpp.in and CMakeLists.txt.
- */
-#define GEOLITE2PP_VERSION "0.0.1-2561"
@@ -1,16 +1,300 @@
 #include "geolocation.h"
 
+#include <base/math.h>
+#include <base/system.h>
+
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 
 static Geolocation *Instance = nullptr;
 
-Geolocation::Geolocation(const char* path_to_mmdb) {
-	db = new GeoLite2PP::DB(path_to_mmdb);
+namespace {
+
+struct CIsoNumeric
+{
+	char m_aCode[3];
+	int m_Numeric;
+};
+
+// ISO 3166-1 alpha-2 to numeric, sorted by code
+constexpr CIsoNumeric gs_aIsoNumeric[] = {
+	{"AD", 20},
+	{"AE", 784},
+	{"AF", 4},
+	{"AG", 28},
+	{"AI", 660},
+	{"AL", 8},
+	{"AM", 51},
+	{"AO", 24},
+	{"AQ", 10},
+	{"AR", 32},
+	{"AS", 16},
+	{"AT", 40},
+	{"AU", 36},
+	{"AW", 533},
+	{"AX", 248},
+	{"AZ", 31},
+	{"BA", 70},
+	{"BB", 52},
+	{"BD", 50},
+	{"BE", 56},
+	{"BF", 854},
+	{"BG", 100},
+	{"BH", 48},
+	{"BI", 108},
+	{"BJ", 204},
+	{"BL", 652},
+	{"BM", 60},
+	{"BN", 96},
+	{"BO", 68},
+	{"BQ", 535},
+	{"BR", 76},
+	{"BS", 44},
+	{"BT", 64},
+	{"BV", 74},
+	{"BW", 72},
+	{"BY", 112},
+	{"BZ", 84},
+	{"CA", 124},
+	{"CC", 166},
+	{"CD", 180},
+	{"CF", 140},
+	{"CG", 178},
+	{"CH", 756},
+	{"CI", 384},
+	{"CK", 184},
+	{"CL", 152},
+	{"CM", 120},
+	{"CN", 156},
+	{"CO", 170},
+	{"CR", 188},
+	{"CU", 192},
+	{"CV", 132},
+	{"CW", 531},
+	{"CX", 162},
+	{"CY", 196},
+	{"CZ", 203},
+	{"DE", 276},
+	{"DJ", 262},
+	{"DK", 208},
+	{"DM", 212},
+	{"DO", 214},
+	{"DZ", 12},
+	{"EC", 218},
+	{"EE", 233},
+	{"EG", 818},
+	{"EH", 732},
+	{"ER", 232},
+	{"ES", 724},
+	{"ET", 231},
+	{"FI", 246},
+	{"FJ", 242},
+	{"FK", 238},
+	{"FM", 583},
+	{"FO", 234},
+	{"FR", 250},
+	{"GA", 266},
+	{"GB", 826},
+	{"GD", 308},
+	{"GE", 268},
+	{"GF", 254},
+	{"GG", 831},
+	{"GH", 288},
+	{"GI", 292},
+	{"GL", 304},
+	{"GM", 270},
+	{"GN", 324},
+	{"GP", 312},
+	{"GQ", 226},
+	{"GR", 300},
+	{"GS", 239},
+	{"GT", 320},
+	{"GU", 316},
+	{"GW", 624},
+	{"GY", 328},
+	{"HK", 344},
+	{"HM", 334},
+	{"HN", 340},
+	{"HR", 191},
+	{"HT", 332},
+	{"HU", 348},
+	{"ID", 360},
+	{"IE", 372},
+	{"IL", 376},
+	{"IM", 833},
+	{"IN", 356},
+	{"IO", 86},
+	{"IQ", 368},
+	{"IR", 364},
+	{"IS", 352},
+	{"IT", 380},
+	{"JE", 832},
+	{"JM", 388},
+	{"JO", 400},
+	{"JP", 392},
+	{"KE", 404},
+	{"KG", 417},
+	{"KH", 116},
+	{"KI", 296},
+	{"KM", 174},
+	{"KN", 659},
+	{"KP", 408},
+	{"KR", 410},
+	{"KW", 414},
+	{"KY", 136},
+	{"KZ", 398},
+	{"LA", 418},
+	{"LB", 422},
+	{"LC", 662},
+	{"LI", 438},
+	{"LK", 144},
+	{"LR", 430},
+	{"LS", 426},
+	{"LT", 440},
+	{"LU", 442},
+	{"LV", 428},
+	{"LY", 434},
+	{"MA", 504},
+	{"MC", 492},
+	{"MD", 498},
+	{"ME", 499},
+	{"MF", 663},
+	{"MG", 450},
+	{"MH", 584},
+	{"MK", 807},
+	{"ML", 466},
+	{"MM", 104},
+	{"MN", 496},
+	{"MO", 446},
+	{"MP", 580},
+	{"MQ", 474},
+	{"MR", 478},
+	{"MS", 500},
+	{"MT", 470},
+	{"MU", 480},
+	{"MV", 462},
+	{"MW", 454},
+	{"MX", 484},
+	{"MY", 458},
+	{"MZ", 508},
+	{"NA", 516},
+	{"NC", 540},
+	{"NE", 562},
+	{"NF", 574},
+	{"NG", 566},
+	{"NI", 558},
+	{"NL", 528},
+	{"NO", 578},
+	{"NP", 524},
+	{"NR", 520},
+	{"NU", 570},
+	{"NZ", 554},
+	{"OM", 512},
+	{"PA", 591},
+	{"PE", 604},
+	{"PF", 258},
+	{"PG", 598},
+	{"PH", 608},
+	{"PK", 586},
+	{"PL", 616},
+	{"PM", 666},
+	{"PN", 612},
+	{"PR", 630},
+	{"PS", 275},
+	{"PT", 620},
+	{"PW", 585},
+	{"PY", 600},
+	{"QA", 634},
+	{"RE", 638},
+	{"RO", 642},
+	{"RS", 688},
+	{"RU", 643},
+	{"RW", 646},
+	{"SA", 682},
+	{"SB", 90},
+	{"SC", 690},
+	{"SD", 729},
+	{"SE", 752},
+	{"SG", 702},
+	{"SH", 654},
+	{"SI", 705},
+	{"SJ", 744},
+	{"SK", 703},
+	{"SL", 694},
+	{"SM", 674},
+	{"SN", 686},
+	{"SO", 706},
+	{"SR", 740},
+	{"SS", 728},
+	{"ST", 678},
+	{"SV", 222},
+	{"SX", 534},
+	{"SY", 760},
+	{"SZ", 748},
+	{"TC", 796},
+	{"TD", 148},
+	{"TF", 260},
+	{"TG", 768},
+	{"TH", 764},
+	{"TJ", 762},
+	{"TK", 772},
+	{"TL", 626},
+	{"TM", 795},
+	{"TN", 788},
+	{"TO", 776},
+	{"TR", 792},
+	{"TT", 780},
+	{"TV", 798},
+	{"TW", 158},
+	{"TZ", 834},
+	{"UA", 804},
+	{"UG", 800},
+	{"UM", 581},
+	{"US", 840},
+	{"UY", 858},
+	{"UZ", 860},
+	{"VA", 336},
+	{"VC", 670},
+	{"VE", 862},
+	{"VG", 92},
+	{"VI", 850},
+	{"VN", 704},
+	{"VU", 548},
+	{"WF", 876},
+	{"WS", 882},
+	{"YE", 887},
+	{"YT", 175},
+	{"ZA", 710},
+	{"ZM", 894},
+	{"ZW", 716},
+};
+
+constexpr bool IsoNumericSorted()
+{
+	for(size_t i = 1; i < std::size(gs_aIsoNumeric); i++)
+	{
+		const CIsoNumeric &Prev = gs_aIsoNumeric[i - 1];
+		const CIsoNumeric &Cur = gs_aIsoNumeric[i];
+		if(Prev.m_aCode[0] > Cur.m_aCode[0] || (Prev.m_aCode[0] == Cur.m_aCode[0] && Prev.m_aCode[1] >= Cur.m_aCode[1]))
+			return false;
+	}
+	return true;
+}
+static_assert(IsoNumericSorted(), "the ISO codes must be sorted for the binary search");
+
+bool MatchesPrefix(const unsigned char *pA, const unsigned char *pB, int Bits)
+{
+	const int Bytes = Bits / 8;
+	if(mem_comp(pA, pB, Bytes) != 0)
+		return false;
+	const int RemainingBits = Bits % 8;
+	if(!RemainingBits)
+		return true;
+	const unsigned char Mask = 0xff << (8 - RemainingBits);
+	return (pA[Bytes] & Mask) == (pB[Bytes] & Mask);
 }
 
-Geolocation::~Geolocation() {
-	delete db;
-	db = nullptr;
 }
 
 bool Geolocation::Initialize(const char *pPathToDB)
@@ -18,296 +302,162 @@ bool Geolocation::Initialize(const char *pPathToDB)
 	if(Instance)
 		return true;
 
-	try
-	{
-		Instance = new Geolocation(pPathToDB);
-		return true;
-	}
-	catch(const std::system_error &e)
+	Geolocation *pGeolocation = new Geolocation();
+	const int Status = MMDB_open(pPathToDB, MMDB_MODE_MMAP, &pGeolocation->m_Db);
+	if(Status != MMDB_SUCCESS)
 	{
-		std::cout << "Geolocation::Initialize() failed: " << e.what() << std::endl;
+		std::cout << "Geolocation::Initialize() failed: " << MMDB_strerror(Status) << std::endl;
+		delete pGeolocation;
 		return false;
 	}
+
+	Instance = pGeolocation;
+	return true;
 }
 
 void Geolocation::Shutdown()
 {
+	if(!Instance)
+		return;
+
+	MMDB_close(&Instance->m_Db);
 	delete Instance;
 	Instance = nullptr;
 }
 
-int Geolocation::get_country_iso_numeric_code(std::string& ip) {
+int Geolocation::get_country_iso_numeric_code(const NETADDR &Addr)
+{
 	if(!Instance)
 	{
 		return -1;
 	}
 
-	try {
-		GeoLite2PP::MStr map_str = Instance->db->get_all_fields(ip);
-		return Instance->get_iso_numeric_code(map_str);
-	} catch (const std::invalid_argument &) {
-		std::cout << "This ip is not valid! " << ip << std::endl;
-		return -1;
-	} catch (const std::length_error &) {
-		std::cout << "This ip was not found in database: " << ip << std::endl;
+	return Instance->lookup_country(Addr);
+}
+
+int Geolocation::iso_numeric_code(const char *pIsoCode, int Length)
+{
+	if(Length != 2)
+		return 0;
+
+	const CIsoNumeric *pEnd = gs_aIsoNumeric + std::size(gs_aIsoNumeric);
+	const CIsoNumeric *pFound = std::lower_bound(gs_aIsoNumeric, pEnd, pIsoCode, [](const CIsoNumeric &Entry, const char *pCode) {
+		return Entry.m_aCode[0] < pCode[0] || (Entry.m_aCode[0] == pCode[0] && Entry.m_aCode[1] < pCode[1]);
+	});
+	if(pFound == pEnd || pFound->m_aCode[0] != pIsoCode[0] || pFound->m_aCode[1] != pIsoCode[1])
+		return 0;
+	return pFound->m_Numeric;
+}
+
+int Geolocation::lookup_country(const NETADDR &Addr)
+{
+	int Family;
+	int AddrSize;
+	if(Addr.type & (NETTYPE_IPV4 | NETTYPE_WEBSOCKET_IPV4))
+	{
+		Family = AF_INET;
+		AddrSize = 4;
+	}
+	else if(Addr.type & NETTYPE_IPV6)
+	{
+		Family = AF_INET6;
+		AddrSize = 16;
+	}
+	else
+	{
 		return -1;
-	} catch (...) {
-		std::cout << "Geolocation: Something went wrong." << ip << std::endl;
+	}
+
+	int Country;
+	if(m_Cache.Find(Family, Addr.ip, &Country))
+		return Country;
+
+	int MmdbError = MMDB_SUCCESS;
+	MMDB_lookup_result_s Result;
+	if(Family == AF_INET)
+	{
+		sockaddr_in Sockaddr = {};
+		Sockaddr.sin_family = AF_INET;
+		mem_copy(&Sockaddr.sin_addr, Addr.ip, AddrSize);
+		Result = MMDB_lookup_sockaddr(&m_Db, reinterpret_cast<const sockaddr *>(&Sockaddr), &MmdbError);
+	}
+	else
+	{
+		sockaddr_in6 Sockaddr = {};
+		Sockaddr.sin6_family = AF_INET6;
+		mem_copy(&Sockaddr.sin6_addr, Addr.ip, AddrSize);
+		Result = MMDB_lookup_sockaddr(&m_Db, reinterpret_cast<const sockaddr *>(&Sockaddr), &MmdbError);
+	}
+
+	if(MmdbError != MMDB_SUCCESS)
+	{
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&Addr, aAddrStr, sizeof(aAddrStr), false);
+		std::cout << "Geolocation: lookup of " << aAddrStr << " failed: " << MMDB_strerror(MmdbError) << std::endl;
 		return -1;
 	}
+
+	const int PrefixLength = CGeolocationCache::PrefixLength(Result.netmask, Family, m_Db.metadata.ip_version);
+
+	Country = -1;
+	if(Result.found_entry)
+	{
+		MMDB_entry_data_s Data;
+		const int Status = MMDB_get_value(&Result.entry, &Data, "country", "iso_code", nullptr);
+		if(Status == MMDB_SUCCESS && Data.has_data && Data.type == MMDB_DATA_TYPE_UTF8_STRING)
+			Country = iso_numeric_code(Data.utf8_string, Data.data_size);
+		else
+			Country = 0;
+	}
+
+	m_Cache.Add(Family, Addr.ip, PrefixLength, Country);
+	return Country;
+}
+
+bool CGeolocationCache::Find(int Family, const unsigned char *pAddr, int *pCountry)
+{
+	for(int i = 0; i < m_NumCached; i++)
+	{
+		CCachedNetwork &Network = m_aCache[i];
+		if(Network.m_Family == Family && MatchesPrefix(Network.m_aNetwork, pAddr, Network.m_PrefixLength))
+		{
+			Network.m_LastUse = ++m_UseCounter;
+			*pCountry = Network.m_Country;
+			return true;
+		}
+	}
+	return false;
 }
 
-int Geolocation::get_iso_numeric_code(GeoLite2PP::MStr& m) {
-	std::map<std::string, int> iso_numeric = {
-		{"AF", 4},
-		{"AX", 248},
-		{"AL", 8},
-		{"DZ", 12},
-		{"AS", 16},
-		{"AD", 20},
-		{"AO", 24},
-		{"AI", 660},
-		{"AQ", 10},
-		{"AG", 28},
-		{"AR", 32},
-		{"AM", 51},
-		{"AW", 533},
-		{"AU", 36},
-		{"AT", 40},
-		{"AZ", 31},
-		{"BS", 44},
-		{"BH", 48},
-		{"BD", 50},
-		{"BB", 52},
-		{"BY", 112},
-		{"BE", 56},
-		{"BZ", 84},
-		{"BJ", 204},
-		{"BM", 60},
-		{"BT", 64},
-		{"BO", 68},
-		{"BQ", 535},
-		{"BA", 70},
-		{"BW", 72},
-		{"BV", 74},
-		{"BR", 76},
-		{"IO", 86},
-		{"BN", 96},
-		{"BG", 100},
-		{"BF", 854},
-		{"BI", 108},
-		{"KH", 116},
-		{"CM", 120},
-		{"CA", 124},
-		{"CV", 132},
-		{"KY", 136},
-		{"CF", 140},
-		{"TD", 148},
-		{"CL", 152},
-		{"CN", 156},
-		{"CX", 162},
-		{"CC", 166},
-		{"CO", 170},
-		{"KM", 174},
-		{"CG", 178},
-		{"CD", 180},
-		{"CK", 184},
-		{"CR", 188},
-		{"CI", 384},
-		{"HR", 191},
-		{"CU", 192},
-		{"CW", 531},
-		{"CY", 196},
-		{"CZ", 203},
-		{"DK", 208},
-		{"DJ", 262},
-		{"DM", 212},
-		{"DO", 214},
-		{"EC", 218},
-		{"EG", 818},
-		{"SV", 222},
-		{"GQ", 226},
-		{"ER", 232},
-		{"EE", 233},
-		{"ET", 231},
-		{"FK", 238},
-		{"FO", 234},
-		{"FJ", 242},
-		{"FI", 246},
-		{"FR", 250},
-		{"GF", 254},
-		{"PF", 258},
-		{"TF", 260},
-		{"GA", 266},
-		{"GM", 270},
-		{"GE", 268},
-		{"DE", 276},
-		{"GH", 288},
-		{"GI", 292},
-		{"GR", 300},
-		{"GL", 304},
-		{"GD", 308},
-		{"GP", 312},
-		{"GU", 316},
-		{"GT", 320},
-		{"GG", 831},
-		{"GN", 324},
-		{"GW", 624},
-		{"GY", 328},
-		{"HT", 332},
-		{"HM", 334},
-		{"VA", 336},
-		{"HN", 340},
-		{"HK", 344},
-		{"HU", 348},
-		{"IS", 352},
-		{"IN", 356},
-		{"ID", 360},
-		{"IR", 364},
-		{"IQ", 368},
-		{"IE", 372},
-		{"IM", 833},
-		{"IL", 376},
-		{"IT", 380},
-		{"JM", 388},
-		{"JP", 392},
-		{"JE", 832},
-		{"JO", 400},
-		{"KZ", 398},
-		{"KE", 404},
-		{"KI", 296},
-		{"KP", 408},
-		{"KR", 410},
-		{"KW", 414},
-		{"KG", 417},
-		{"LA", 418},
-		{"LV", 428},
-		{"LB", 422},
-		{"LS", 426},
-		{"LR", 430},
-		{"LY", 434},
-		{"LI", 438},
-		{"LT", 440},
-		{"LU", 442},
-		{"MO", 446},
-		{"MK", 807},
-		{"MG", 450},
-		{"MW", 454},
-		{"MY", 458},
-		{"MV", 462},
-		{"ML", 466},
-		{"MT", 470},
-		{"MH", 584},
-		{"MQ", 474},
-		{"MR", 478},
-		{"MU", 480},
-		{"YT", 175},
-		{"MX", 484},
-		{"FM", 583},
-		{"MD", 498},
-		{"MC", 492},
-		{"MN", 496},
-		{"ME", 499},
-		{"MS", 500},
-		{"MA", 504},
-		{"MZ", 508},
-		{"MM", 104},
-		{"NA", 516},
-		{"NR", 520},
-		{"NP", 524},
-		{"NL", 528},
-		{"NC", 540},
-		{"NZ", 554},
-		{"NI", 558},
-		{"NE", 562},
-		{"NG", 566},
-		{"NU", 570},
-		{"NF", 574},
-		{"MP", 580},
-		{"NO", 578},
-		{"OM", 512},
-		{"PK", 586},
-		{"PW", 585},
-		{"PS", 275},
-		{"PA", 591},
-		{"PG", 598},
-		{"PY", 600},
-		{"PE", 604},
-		{"PH", 608},
-		{"PN", 612},
-		{"PL", 616},
-		{"PT", 620},
-		{"PR", 630},
-		{"QA", 634},
-		{"RE", 638},
-		{"RO", 642},
-		{"RU", 643},
-		{"RW", 646},
-		{"BL", 652},
-		{"SH", 654},
-		{"KN", 659},
-		{"LC", 662},
-		{"MF", 663},
-		{"PM", 666},
-		{"VC", 670},
-		{"WS", 882},
-		{"SM", 674},
-		{"ST", 678},
-		{"SA", 682},
-		{"SN", 686},
-		{"RS", 688},
-		{"SC", 690},
-		{"SL", 694},
-		{"SG", 702},
-		{"SX", 534},
-		{"SK", 703},
-		{"SI", 705},
-		{"SB", 90},
-		{"SO", 706},
-		{"ZA", 710},
-		{"GS", 239},
-		{"SS", 728},
-		{"ES", 724},
-		{"LK", 144},
-		{"SD", 729},
-		{"SR", 740},
-		{"SJ", 744},
-		{"SZ", 748},
-		{"SE", 752},
-		{"CH", 756},
-		{"SY", 760},
-		{"TW", 158},
-		{"TJ", 762},
-		{"TZ", 834},
-		{"TH", 764},
-		{"TL", 626},
-		{"TG", 768},
-		{"TK", 772},
-		{"TO", 776},
-		{"TT", 780},
-		{"TN", 788},
-		{"TR", 792},
-		{"TM", 795},
-		{"TC", 796},
-		{"TV", 798},
-		{"UG", 800},
-		{"UA", 804},
-		{"AE", 784},
-		{"GB", 826},
-		{"US", 840},
-		{"UM", 581},
-		{"UY", 858},
-		{"UZ", 860},
-		{"VU", 548},
-		{"VE", 862},
-		{"VN", 704},
-		{"VG", 92},
-		{"VI", 850},
-		{"WF", 876},
-		{"EH", 732},
-		{"YE", 887},
-		{"ZM", 894},
-		{"ZW", 716}
-	};
-	return iso_numeric[m["country_iso_code"]];
+void CGeolocationCache::Add(int Family, const unsigned char *pAddr, int PrefixLength, int Country)
+{
+	CCachedNetwork *pNetwork;
+	if(m_NumCached < CACHE_SIZE)
+	{
+		pNetwork = &m_aCache[m_NumCached++];
+	}
+	else
+	{
+		// replace the least recently used network
+		pNetwork = std::min_element(m_aCache, m_aCache + CACHE_SIZE, [](const CCachedNetwork &a, const CCachedNetwork &b) {
+			return a.m_LastUse < b.m_LastUse;
+		});
+	}
+
+	pNetwork->m_Family = Family;
+	mem_zero(pNetwork->m_aNetwork, sizeof(pNetwork->m_aNetwork));
+	mem_copy(pNetwork->m_aNetwork, pAddr, (PrefixLength + 7) / 8);
+	pNetwork->m_PrefixLength = PrefixLength;
+	pNetwork->m_Country = Country;
+	pNetwork->m_LastUse = ++m_UseCounter;
+}
+
+int CGeolocationCache::PrefixLength(int Netmask, int Family, int DbIpVersion)
+{
+	// the netmask of an IPv4 address found in an IPv6 tree includes the
+	// 96 bits of the IPv4 subtree
+	const int AddrBits = Family == AF_INET ? 32 : 128;
+	if(Family == AF_INET && DbIpVersion == 6)
+		Netmask = maximum(Netmask - 96, 0);
+	return minimum(Netmask, AddrBits);
 }
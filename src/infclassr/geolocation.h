@@ -1,20 +1,65 @@
 #ifndef INFCLASSR_GEOLOCATION_H
 #define INFCLASSR_GEOLOCATION_H
 
-#include <infclassr/GeoLite2PP/GeoLite2PP.hpp>
+#include <base/types.h>
+
+#include <maxminddb.h>
+
+#include <cstdint>
+
+// The networks of the database recently looked up, the players of a server
+// tend to come back from the same networks
+class CGeolocationCache
+{
+public:
+	enum
+	{
+		CACHE_SIZE = 256,
+	};
+
+private:
+	struct CCachedNetwork
+	{
+		int m_Family;
+		unsigned char m_aNetwork[16];
+		int m_PrefixLength;
+		int m_Country;
+		uint64_t m_LastUse;
+	};
+
+	CCachedNetwork m_aCache[CACHE_SIZE];
+	int m_NumCached = 0;
+	uint64_t m_UseCounter = 0;
+
+public:
+	// Finds the country of the cached network the address is in
+	bool Find(int Family, const unsigned char *pAddr, int *pCountry);
+	// Adds the network of the address, replacing the least recently used one
+	// when the cache is full
+	void Add(int Family, const unsigned char *pAddr, int PrefixLength, int Country);
+
+	// The prefix length in the address of the family for the netmask of a
+	// lookup in a database of the IP version
+	static int PrefixLength(int Netmask, int Family, int DbIpVersion);
+};
 
 class Geolocation {
 private:
-	GeoLite2PP::DB *db;
-	int get_iso_numeric_code(GeoLite2PP::MStr& m);
-	Geolocation(const char* path_to_mmdb);
-	~Geolocation();
+	MMDB_s m_Db;
+	CGeolocationCache m_Cache;
+
+	Geolocation() = default;
+
+	int lookup_country(const NETADDR &Addr);
 
 public:
 	static bool Initialize(const char *pPathToDB);
 	static void Shutdown();
 
-	static int get_country_iso_numeric_code(std::string& ip);
+	// Returns the ISO 3166-1 numeric code of the country of the address,
+	// 0 if the country is unknown, -1 if the address is not in the database
+	static int get_country_iso_numeric_code(const NETADDR &Addr);
+	static int iso_numeric_code(const char *pIsoCode, int Length);
 };
 
 #endif
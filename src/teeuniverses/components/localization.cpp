@@ -84,14 +84,8 @@ CLocalization::CLanguage::CLanguage(const char* pName, const char* pFilename, co
 
 CLocalization::CLanguage::~CLanguage()
 {
-	hashtable< CEntry, 128 >::iterator Iter = m_Translations.begin();
-	while(Iter != m_Translations.end())
-	{
-		if(Iter.data())
-			Iter.data()->Free();
-		
-		++Iter;
-	}
+	for(CEntry &Entry : m_vTranslations)
+		Entry.Free();
 	
 	if(m_pNumberFormater)
 		unum_close(m_pNumberFormater);
@@ -150,7 +144,12 @@ bool CLocalization::CLanguage::Load(CLocalization* pLocalization, CStorage* pSto
 			const char* pKey = rStart[i]["key"];
 			if(pKey && pKey[0])
 			{
-				CEntry* pEntry = m_Translations.set(pKey);
+				const int Key = pLocalization->InternKey(pKey);
+				if(Key >= (int)m_vTranslations.size())
+					m_vTranslations.resize(Key+1);
+				CEntry* pEntry = &m_vTranslations[Key];
+				pEntry->Free();
+				*pEntry = CEntry();
 				
 				const char* pSingular = rStart[i]["value"];
 				if(pSingular && pSingular[0])
@@ -225,20 +224,19 @@ bool CLocalization::CLanguage::Load(CLocalization* pLocalization, CStorage* pSto
 	return true;
 }
 
-const char* CLocalization::CLanguage::Localize(const char* pText) const
+const char* CLocalization::CLanguage::Localize(int Key) const
 {	
-	const CEntry* pEntry = m_Translations.get(pText);
-	if(!pEntry)
+	if(Key < 0 || Key >= (int)m_vTranslations.size())
 		return NULL;
 	
-	return pEntry->m_apVersions[PLURALTYPE_NONE];
+	return m_vTranslations[Key].m_apVersions[PLURALTYPE_NONE];
 }
 
-const char* CLocalization::CLanguage::Localize_P(int Number, const char* pText) const
+const char* CLocalization::CLanguage::Localize_P(int Number, int Key) const
 {
-	const CEntry* pEntry = m_Translations.get(pText);
-	if(!pEntry)
+	if(Key < 0 || Key >= (int)m_vTranslations.size())
 		return NULL;
+	const CEntry* pEntry = &m_vTranslations[Key];
 	
 	UChar aPluralKeyWord[6];
 	UErrorCode Status = U_ZERO_ERROR;
@@ -274,7 +272,8 @@ const char* CLocalization::CLanguage::Localize_P(int Number, const char* pText)
 CLocalization::CLocalization(class CStorage* pStorage) :
 	m_pStorage(pStorage),
 	m_pMainLanguage(NULL),
-	m_pUtf8Converter(NULL)
+	m_pUtf8Converter(NULL),
+	m_pLoaderThread(NULL)
 {
 	
 }
@@ -282,6 +281,8 @@ CLocalization::CLocalization(class CStorage* pStorage) :
 
 CLocalization::~CLocalization()
 {
+	WaitForLanguages();
+	
 	for(int i=0; i<m_pLanguages.size(); i++)
 		delete m_pLanguages[i];
 	
@@ -349,12 +350,10 @@ bool CLocalization::Init()
 			if((const char *)rStart[i]["direction"] && str_comp((const char *)rStart[i]["direction"], "rtl") == 0)
 				pLanguage->SetWritingDirection(DIRECTION_RTL);
 				
+			m_LanguagesByCode.emplace(pLanguage->GetFilename(), pLanguage);
+			
 			if(m_Cfg_MainLanguage == pLanguage->GetFilename())
-			{
-				pLanguage->Load(this, Storage());
-				
 				m_pMainLanguage = pLanguage;
-			}
 		}
 	}
 
@@ -362,8 +361,69 @@ bool CLocalization::Init()
 	json_value_free(pJsonData);
 	delete[] pFileData;
 	
+	// load the translations while the server starts instead of on first
+	// use during the game
+	if(m_pLanguages.size())
+		m_pLoaderThread = thread_init(LoaderThread, this, "localization");
+	
 	return true;
 }
+
+void CLocalization::LoaderThread(void *pUser)
+{
+	CLocalization *pSelf = static_cast<CLocalization *>(pUser);
+	
+	const int64_t StartTime = time_get();
+	for(int i=0; i<pSelf->m_pLanguages.size(); i++)
+		pSelf->m_pLanguages[i]->Load(pSelf, pSelf->Storage());
+	
+	dbg_msg("Localization", "loaded %d languages, %d keys in %.2fms", pSelf->m_pLanguages.size(), (int)pSelf->m_Keys.size(), (time_get() - StartTime) * 1000.0 / time_freq());
+}
+
+void CLocalization::WaitForLanguages()
+{
+	if(m_pLoaderThread)
+	{
+		thread_wait(m_pLoaderThread);
+		m_pLoaderThread = NULL;
+	}
+}
+
+int CLocalization::InternKey(const char* pText)
+{
+	auto Iter = m_KeyIds.find(pText);
+	if(Iter != m_KeyIds.end())
+		return Iter->second;
+	
+	const int Key = m_Keys.size();
+	m_Keys.emplace_back(pText);
+	m_KeyIds.emplace(m_Keys.back(), Key);
+	return Key;
+}
+
+int CLocalization::KeyId(const char* pText) const
+{
+	auto Iter = m_KeyIds.find(pText);
+	return Iter != m_KeyIds.end() ? Iter->second : -1;
+}
+
+int CLocalization::NumKeys()
+{
+	WaitForLanguages();
+	
+	return m_Keys.size();
+}
+
+CLocalization::CLanguage* CLocalization::FindLanguage(const char* pLanguageCode)
+{
+	WaitForLanguages();
+	
+	if(!pLanguageCode)
+		return m_pMainLanguage;
+	
+	auto Iter = m_LanguagesByCode.find(pLanguageCode);
+	return Iter != m_LanguagesByCode.end() ? Iter->second : m_pMainLanguage;
+}
 	
 void CLocalization::AddListener(IListener* pListener)
 {
@@ -581,74 +641,58 @@ const char *CLocalization::FallbackLanguageForIpCountryCode(int Country)
 	}
 }
 
-const char* CLocalization::LocalizeWithDepth(const char* pLanguageCode, const char* pText, int Depth)
+const char* CLocalization::LocalizeWithDepth(CLanguage* pLanguage, int Key, const char* pText, int Depth)
 {
-	CLanguage* pLanguage = m_pMainLanguage;
-	if(pLanguageCode)
-	{
-		for(int i=0; i<m_pLanguages.size(); i++)
-		{
-			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = m_pLanguages[i];
-				break;
-			}
-		}
-	}
-	
 	if(!pLanguage)
 		return pText;
 	
 	if(!pLanguage->IsLoaded())
 		pLanguage->Load(this, Storage());
 	
-	const char* pResult = pLanguage->Localize(pText);
+	const char* pResult = pLanguage->Localize(Key);
 	if(pResult)
 		return pResult;
 	else if(pLanguage->GetParentFilename()[0] && Depth < 4)
-		return LocalizeWithDepth(pLanguage->GetParentFilename(), pText, Depth+1);
+		return LocalizeWithDepth(FindLanguage(pLanguage->GetParentFilename()), Key, pText, Depth+1);
 	else
 		return pText;
 }
 
 const char* CLocalization::Localize(const char* pLanguageCode, const char* pText)
 {
-	return LocalizeWithDepth(pLanguageCode, pText, 0);
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
+	const int Key = KeyId(pText);
+	if(Key < 0)
+		return pText;
+	
+	return LocalizeWithDepth(pLanguage, Key, pText, 0);
 }
 
-const char* CLocalization::LocalizeWithDepth_P(const char* pLanguageCode, int Number, const char* pText, int Depth)
+const char* CLocalization::LocalizeWithDepth_P(CLanguage* pLanguage, int Number, int Key, const char* pText, int Depth)
 {
-	CLanguage* pLanguage = m_pMainLanguage;
-	if(pLanguageCode)
-	{
-		for(int i=0; i<m_pLanguages.size(); i++)
-		{
-			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = m_pLanguages[i];
-				break;
-			}
-		}
-	}
-	
 	if(!pLanguage)
 		return pText;
 	
 	if(!pLanguage->IsLoaded())
 		pLanguage->Load(this, Storage());
 	
-	const char* pResult = pLanguage->Localize_P(Number, pText);
+	const char* pResult = pLanguage->Localize_P(Number, Key);
 	if(pResult)
 		return pResult;
 	else if(pLanguage->GetParentFilename()[0] && Depth < 4)
-		return LocalizeWithDepth_P(pLanguage->GetParentFilename(), Number, pText, Depth+1);
+		return LocalizeWithDepth_P(FindLanguage(pLanguage->GetParentFilename()), Number, Key, pText, Depth+1);
 	else
 		return pText;
 }
 
 const char* CLocalization::Localize_P(const char* pLanguageCode, int Number, const char* pText)
 {
-	return LocalizeWithDepth_P(pLanguageCode, Number, pText, 0);
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
+	const int Key = KeyId(pText);
+	if(Key < 0)
+		return pText;
+	
+	return LocalizeWithDepth_P(pLanguage, Number, Key, pText, 0);
 }
 
 void CLocalization::AppendNumber(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, int Number)
@@ -734,18 +778,7 @@ void CLocalization::AppendDuration(dynamic_string& Buffer, int& BufferIter, CLan
 
 void CLocalization::Format_V(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs)
 {
-	CLanguage* pLanguage = m_pMainLanguage;	
-	if(pLanguageCode)
-	{
-		for(int i=0; i<m_pLanguages.size(); i++)
-		{
-			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = m_pLanguages[i];
-				break;
-			}
-		}
-	}
+	CLanguage* pLanguage = FindLanguage(pLanguageCode);
 	if(!pLanguage)
 	{
 		Buffer.append(pText);
@@ -2,7 +2,8 @@
 #define __SHARED_LOCALIZATION__
 
 /* BEGIN EDIT *********************************************************/
-#include <teeuniverses/tl/hashtable.h>
+#include <base/tl/array.h>
+#include <teeuniverses/system/string.h>
 #define CStorage IStorage
 /* END EDIT ***********************************************************/
 
@@ -13,6 +14,12 @@
 
 #include <stdarg.h>
 
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 struct CLocalizableString
 {
 	const char* m_pText;
@@ -87,7 +94,8 @@ public:
 		bool m_Loaded;
 		int m_Direction;
 		
-		hashtable< CEntry, 128 > m_Translations;
+		// Indexed by the key ids of CLocalization
+		std::vector<CEntry> m_vTranslations;
 	
 	public:
 		UPluralRules* m_pPluralRules;
@@ -107,8 +115,8 @@ public:
 		inline void SetWritingDirection(int Direction) { m_Direction = Direction; }
 		inline bool IsLoaded() const { return m_Loaded; }
 		bool Load(CLocalization* pLocalization, class CStorage* pStorage);
-		const char* Localize(const char* pKey) const;
-		const char* Localize_P(int Number, const char* pText) const;
+		const char* Localize(int Key) const;
+		const char* Localize_P(int Number, int Key) const;
 	};
 	
 	enum
@@ -130,8 +138,25 @@ public:
 	fixed_string128 m_Cfg_MainLanguage;
 
 protected:
-	const char* LocalizeWithDepth(const char* pLanguageCode, const char* pText, int Depth);
-	const char* LocalizeWithDepth_P(const char* pLanguageCode, int Number, const char* pText, int Depth);
+	// Every key of every language resolves once to an id, the translations
+	// of a language are a flat vector indexed by it
+	std::deque<std::string> m_Keys;
+	std::unordered_map<std::string_view, int> m_KeyIds;
+	std::unordered_map<std::string_view, CLanguage*> m_LanguagesByCode;
+
+	// The languages are all loaded by a background job started by Init(),
+	// the first lookup waits for it to finish
+	void *m_pLoaderThread;
+
+	static void LoaderThread(void *pUser);
+	void WaitForLanguages();
+
+	int InternKey(const char* pText);
+	int KeyId(const char* pText) const;
+	CLanguage* FindLanguage(const char* pLanguageCode);
+
+	const char* LocalizeWithDepth(CLanguage* pLanguage, int Key, const char* pText, int Depth);
+	const char* LocalizeWithDepth_P(CLanguage* pLanguage, int Number, int Key, const char* pText, int Depth);
 	
 	void AppendNumber(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, int Number);
 	void AppendPercent(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, double Number);
@@ -148,6 +173,8 @@ public:
 /* END EDIT ***********************************************************/
 	virtual bool Init();
 	virtual bool PreUpdate();
+
+	int NumKeys();
 	
 	void AddListener(IListener* pListener);
 	void RemoveListener(IListener* pListener);
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/teamscore.h>
+#include <tests/test_map.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A crowd of cores around a random free spot of the map, with all the
+// combinations of teams, solo and super that affect player collisions.
+class CCrowd
+{
+public:
+	CWorldCore m_World;
+	CTeamsCore m_Teams;
+	std::vector<std::unique_ptr<CCharacterCore>> m_vpCores;
+
+	void Init(CCollision *pCollision, std::mt19937 &Rng, int NumCores, float Spread, float MaxVel)
+	{
+		m_Teams.m_IsInfclass = true;
+
+		std::uniform_int_distribution<int> TileX(0, pCollision->GetWidth() - 1);
+		std::uniform_int_distribution<int> TileY(0, pCollision->GetHeight() - 1);
+		vec2 Center;
+		do
+		{
+			Center = vec2(TileX(Rng) * 32.0f + 16.0f, TileY(Rng) * 32.0f + 16.0f);
+		} while(pCollision->CheckPoint(Center));
+
+		std::uniform_real_distribution<float> Offset(-Spread, Spread);
+		std::uniform_real_distribution<float> Vel(-MaxVel, MaxVel);
+		for(int i = 0; i < NumCores; i++)
+		{
+			std::unique_ptr<CCharacterCore> pCore = std::make_unique<CCharacterCore>();
+			pCore->Init(&m_World, pCollision, &m_Teams);
+			pCore->m_Id = i;
+			do
+			{
+				pCore->m_Pos = Center + vec2(Offset(Rng), Offset(Rng));
+			} while(pCollision->TestBox(pCore->m_Pos, CCharacterCore::PhysicalSizeVec2()));
+			pCore->m_Vel = vec2(Vel(Rng), Vel(Rng));
+			pCore->m_Solo = Rng() % 16 == 0;
+			pCore->m_Super = Rng() % 16 == 0;
+			m_Teams.SetInfected(i, Rng() % 2);
+			m_World.m_apCharacters[i] = pCore.get();
+			m_vpCores.push_back(std::move(pCore));
+		}
+	}
+};
+
+// The previous player collision, testing every core at every step
+void ReferenceMove(CCharacterCore *pCore, const CWorldCore &World, const CTeamsCore &Teams, const CTuningParams &Tuning)
+{
+	CTuningParams NoPlayerCollision = Tuning;
+	NoPlayerCollision.m_PlayerCollision = 1;
+	CCharacterCore::CParams Params(&NoPlayerCollision);
+
+	const vec2 Pos0 = pCore->m_Pos;
+	CCharacterCore Moved = *pCore;
+	Moved.Move(&Params);
+	const vec2 NewPos = Moved.m_Pos;
+	*pCore = Moved;
+
+	pCore->m_Pos = Pos0;
+	float Distance = distance(pCore->m_Pos, NewPos);
+	if(Distance > 0)
+	{
+		int End = Distance + 1;
+		vec2 LastPos = pCore->m_Pos;
+		for(int i = 0; i < End; i++)
+		{
+			float a = i / Distance;
+			vec2 Pos = mix(pCore->m_Pos, NewPos, a);
+			for(int p = 0; p < MAX_CLIENTS; p++)
+			{
+				const CCharacterCore *pCharCore = World.m_apCharacters[p];
+				if(!pCharCore || pCharCore->m_Id == pCore->m_Id)
+					continue;
+				if((!(pCharCore->m_Super || pCore->m_Super) && (pCore->m_Solo || pCharCore->m_Solo || (pCore->m_Id != -1 && !Teams.CanCollide(pCore->m_Id, p)))))
+					continue;
+				float D = distance(Pos, pCharCore->m_Pos);
+				if(D < 28.0f && D >= 0.0f)
+				{
+					if(a > 0.0f)
+						pCore->m_Pos = LastPos;
+					else if(distance(NewPos, pCharCore->m_Pos) > D)
+						pCore->m_Pos = NewPos;
+					return;
+				}
+			}
+			LastPos = Pos;
+		}
+	}
+
+	pCore->m_Pos = NewPos;
+}
+
+CTuningParams PlayerCollisionTuning()
+{
+	CTuningParams Tuning;
+	// The player collision check runs when the tuning is zeroed
+	Tuning.m_PlayerCollision = 0;
+	return Tuning;
+}
+
+}
+
+TEST(CharacterCore, MoveMatchesStepping)
+{
+	CTestMap Map;
+	if(!Map.Load("infc_skull.map"))
+		GTEST_SKIP() << "infc_skull.map is missing";
+
+	const CTuningParams Tuning = PlayerCollisionTuning();
+	CCharacterCore::CParams Params(&Tuning);
+
+	std::mt19937 Rng(11);
+	int NumStopped = 0;
+	for(int Round = 0; Round < 100; Round++)
+	{
+		const float MaxVel = Round % 4 == 0 ? 120.0f : 30.0f;
+		CCrowd Crowd;
+		Crowd.Init(&Map.m_Collision, Rng, MAX_CLIENTS, 200.0f, MaxVel);
+
+		for(int Tick = 0; Tick < 20; Tick++)
+		{
+			for(std::unique_ptr<CCharacterCore> &pCore : Crowd.m_vpCores)
+			{
+				CCharacterCore Expected = *pCore;
+				ReferenceMove(&Expected, Crowd.m_World, Crowd.m_Teams, Tuning);
+
+				const vec2 Vel = pCore->m_Vel;
+				const vec2 Target = pCore->m_Pos + Vel;
+				pCore->Move(&Params);
+				ASSERT_EQ(pCore->m_Pos.x, Expected.m_Pos.x) << "round " << Round << " tick " << Tick << " core " << pCore->m_Id;
+				ASSERT_EQ(pCore->m_Pos.y, Expected.m_Pos.y) << "round " << Round << " tick " << Tick << " core " << pCore->m_Id;
+				ASSERT_EQ(pCore->m_Vel.x, Expected.m_Vel.x);
+				ASSERT_EQ(pCore->m_Vel.y, Expected.m_Vel.y);
+				if(distance(pCore->m_Pos, Target) > 1.0f && length(Vel) > 1.0f)
+					NumStopped++;
+
+				// Keep the crowd busy
+				pCore->m_Vel += vec2(Rng() % 9 - 4.0f, Rng() % 9 - 4.0f);
+			}
+		}
+	}
+	// Make sure the collisions were actually exercised
+	EXPECT_GT(NumStopped, 1000);
+}
+
+TEST(CharacterCore, MoveFromOverlap)
+{
+	CTestMap Map;
+	if(!Map.Load("infc_skull.map"))
+		GTEST_SKIP() << "infc_skull.map is missing";
+
+	const CTuningParams Tuning = PlayerCollisionTuning();
+	CCharacterCore::CParams Params(&Tuning);
+
+	// Cores stacked on each other, which is the first step special case
+	std::mt19937 Rng(3);
+	for(int Round = 0; Round < 200; Round++)
+	{
+		CCrowd Crowd;
+		Crowd.Init(&Map.m_Collision, Rng, 8, 10.0f, 10.0f);
+		for(std::unique_ptr<CCharacterCore> &pCore : Crowd.m_vpCores)
+		{
+			CCharacterCore Expected = *pCore;
+			ReferenceMove(&Expected, Crowd.m_World, Crowd.m_Teams, Tuning);
+			pCore->Move(&Params);
+			ASSERT_EQ(pCore->m_Pos.x, Expected.m_Pos.x) << "round " << Round;
+			ASSERT_EQ(pCore->m_Pos.y, Expected.m_Pos.y) << "round " << Round;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
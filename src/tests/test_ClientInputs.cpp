@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/server.h>
+
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef CServer::CClient CClient;
+
+// The inputs are told apart by their first integer
+std::vector<int> TickInputs(CClient *pClient, int GameTick)
+{
+	std::vector<int> vInputs;
+	for(CClient::CInput *pInput = pClient->FirstInput(GameTick); pInput; pInput = pClient->NextInput(pInput))
+		vInputs.push_back(pInput->m_aData[0]);
+	return vInputs;
+}
+
+// The pool of received inputs as the server scanned it before the ring:
+// the last NUM_INPUTS inputs, here kept in arrival order
+class CReferenceInputs
+{
+	struct CInput
+	{
+		int m_GameTick;
+		int m_Id;
+	};
+	std::deque<CInput> m_Inputs;
+
+public:
+	void Add(int GameTick, int Id)
+	{
+		m_Inputs.push_back({GameTick, Id});
+		if(m_Inputs.size() > CClient::NUM_INPUTS)
+			m_Inputs.pop_front();
+	}
+
+	std::vector<int> TickInputs(int GameTick) const
+	{
+		std::vector<int> vInputs;
+		for(const CInput &Input : m_Inputs)
+		{
+			if(Input.m_GameTick == GameTick)
+				vInputs.push_back(Input.m_Id);
+		}
+		return vInputs;
+	}
+};
+
+std::unique_ptr<CClient> NewClient()
+{
+	std::unique_ptr<CClient> pClient = std::make_unique<CClient>();
+	pClient->Reset();
+	return pClient;
+}
+
+void AddInput(CClient *pClient, int GameTick, int Id)
+{
+	CClient::CInput *pInput = pClient->AddInput(GameTick);
+	pInput->m_aData[0] = Id;
+}
+
+}
+
+TEST(ClientInputs, InputTick)
+{
+	EXPECT_EQ(CClient::InputTick(100, 100), 101);
+	EXPECT_EQ(CClient::InputTick(50, 100), 101);
+	EXPECT_EQ(CClient::InputTick(101, 100), 101);
+	EXPECT_EQ(CClient::InputTick(100 + CClient::INPUT_TICKS - 1, 100), 100 + CClient::INPUT_TICKS - 1);
+	EXPECT_EQ(CClient::InputTick(100 + CClient::INPUT_TICKS, 100), 100 + CClient::INPUT_TICKS - 1);
+	EXPECT_EQ(CClient::InputTick(100000, 100), 100 + CClient::INPUT_TICKS - 1);
+}
+
+TEST(ClientInputs, ArrivalOrderAcrossThePool)
+{
+	std::unique_ptr<CClient> pClient = NewClient();
+
+	// the inputs of tick 10 are stored at the end and the start of the pool
+	for(int i = 0; i < CClient::NUM_INPUTS - 2; i++)
+		AddInput(pClient.get(), 5, i);
+	for(int i = 0; i < 4; i++)
+		AddInput(pClient.get(), 10, 1000 + i);
+
+	EXPECT_EQ(TickInputs(pClient.get(), 10), std::vector<int>({1000, 1001, 1002, 1003}));
+	EXPECT_EQ(TickInputs(pClient.get(), 5).size(), CClient::NUM_INPUTS - 4u);
+	EXPECT_EQ(TickInputs(pClient.get(), 6), std::vector<int>());
+}
+
+TEST(ClientInputs, OverwrittenInputs)
+{
+	std::unique_ptr<CClient> pClient = NewClient();
+	AddInput(pClient.get(), 7, 0);
+	AddInput(pClient.get(), 7, 1);
+	for(int i = 0; i < CClient::NUM_INPUTS - 1; i++)
+		AddInput(pClient.get(), 8, 2 + i);
+
+	// the oldest input of tick 7 was overwritten, the other one is left
+	EXPECT_EQ(TickInputs(pClient.get(), 7), std::vector<int>({1}));
+	AddInput(pClient.get(), 8, 1000);
+	EXPECT_EQ(TickInputs(pClient.get(), 7), std::vector<int>());
+	EXPECT_EQ(TickInputs(pClient.get(), 8).back(), 1000);
+}
+
+TEST(ClientInputs, StaleTickOfTheSameSlot)
+{
+	std::unique_ptr<CClient> pClient = NewClient();
+	AddInput(pClient.get(), 3, 0);
+	AddInput(pClient.get(), 3, 1);
+
+	// a tick sharing the slot replaces the stale tick instead of joining it
+	AddInput(pClient.get(), 3 + CClient::INPUT_TICKS, 2);
+	EXPECT_EQ(TickInputs(pClient.get(), 3 + CClient::INPUT_TICKS), std::vector<int>({2}));
+	EXPECT_EQ(TickInputs(pClient.get(), 3), std::vector<int>());
+
+	// the stale inputs being overwritten leave the new tick alone
+	for(int i = 0; i < 2; i++)
+		AddInput(pClient.get(), 100, 10 + i);
+	for(int i = 0; i < CClient::NUM_INPUTS - 5; i++)
+		AddInput(pClient.get(), 101, 20 + i);
+	AddInput(pClient.get(), 102, 1000);
+	AddInput(pClient.get(), 102, 1001);
+	EXPECT_EQ(TickInputs(pClient.get(), 3 + CClient::INPUT_TICKS), std::vector<int>({2}));
+	AddInput(pClient.get(), 102, 1002);
+	EXPECT_EQ(TickInputs(pClient.get(), 3 + CClient::INPUT_TICKS), std::vector<int>());
+	EXPECT_EQ(TickInputs(pClient.get(), 100), std::vector<int>({10, 11}));
+}
+
+// The inputs the server applies each tick match a scan of the pool, with
+// late, early and far ahead inputs, bursts and pauses of the client
+TEST(ClientInputs, MatchesPoolScan)
+{
+	std::unique_ptr<CClient> pClient = NewClient();
+	CReferenceInputs Reference;
+	std::mt19937 Rng(21);
+	std::uniform_int_distribution<int> Kind(0, 99);
+
+	int CurrentTick = 0;
+	int NextId = 0;
+	for(int Tick = 0; Tick < 100000; Tick++)
+	{
+		int NumInputs = Kind(Rng) < 90 ? 1 : Rng() % 12;
+		for(int i = 0; i < NumInputs; i++)
+		{
+			int IntendedTick;
+			const int k = Kind(Rng);
+			if(k < 70)
+				IntendedTick = CurrentTick + 1 + Rng() % 4;
+			else if(k < 85)
+				IntendedTick = CurrentTick - (int)(Rng() % 30);
+			else if(k < 97)
+				IntendedTick = CurrentTick + Rng() % CClient::INPUT_TICKS;
+			else
+				IntendedTick = CurrentTick + Rng() % 2000;
+
+			const int GameTick = CClient::InputTick(IntendedTick, CurrentTick);
+			ASSERT_GT(GameTick, CurrentTick);
+			ASSERT_LT(GameTick, CurrentTick + CClient::INPUT_TICKS);
+			AddInput(pClient.get(), GameTick, NextId);
+			Reference.Add(GameTick, NextId);
+			NextId++;
+		}
+
+		// the early inputs of the next tick, then the input of the tick
+		ASSERT_EQ(TickInputs(pClient.get(), CurrentTick + 1), Reference.TickInputs(CurrentTick + 1)) << "tick " << CurrentTick;
+		CurrentTick++;
+		CClient::CInput *pInput = pClient->FirstInput(CurrentTick);
+		const std::vector<int> vExpected = Reference.TickInputs(CurrentTick);
+		ASSERT_EQ(pInput ? pInput->m_aData[0] : -1, vExpected.empty() ? -1 : vExpected[0]) << "tick " << CurrentTick;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
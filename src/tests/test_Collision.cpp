@@ -0,0 +1,361 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/animation.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <tests/test_map.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Reference copies of the sample-by-sample implementations, the optimized
+// ones must give the exact same results
+int ReferenceIntersectLine(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	vec2 Pos1Pos0 = Pos1 - Pos0;
+	float Distance = length(Pos1Pos0);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+
+	for(int i = 0; i < End; i++)
+	{
+		float a = i / Distance;
+		vec2 Pos = Pos0 + Pos1Pos0 * a;
+		if(Collision.CheckPoint(Pos.x, Pos.y))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+void ReferenceMoveBox(const CCollision &Collision, vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elasticity, bool *pGrounded)
+{
+	vec2 Pos = *pInoutPos;
+	vec2 Vel = *pInoutVel;
+
+	float Distance = length(Vel);
+	int Max = (int)Distance;
+
+	if(Distance > 0.00001f)
+	{
+		float Fraction = 1.0f / (float)(Max + 1);
+		float ElasticityX = clamp(Elasticity.x, -1.0f, 1.0f);
+		float ElasticityY = clamp(Elasticity.y, -1.0f, 1.0f);
+
+		for(int i = 0; i <= Max; i++)
+		{
+			if(Vel == vec2(0, 0))
+				break;
+
+			vec2 NewPos = Pos + Vel * Fraction;
+			if(NewPos == Pos)
+				break;
+
+			if(Collision.TestBox(vec2(NewPos.x, NewPos.y), Size))
+			{
+				int Hits = 0;
+
+				if(Collision.TestBox(vec2(Pos.x, NewPos.y), Size))
+				{
+					if(pGrounded && ElasticityY > 0 && Vel.y > 0)
+						*pGrounded = true;
+					NewPos.y = Pos.y;
+					Vel.y *= -ElasticityY;
+					Hits++;
+				}
+
+				if(Collision.TestBox(vec2(NewPos.x, Pos.y), Size))
+				{
+					NewPos.x = Pos.x;
+					Vel.x *= -ElasticityX;
+					Hits++;
+				}
+
+				if(Hits == 0)
+				{
+					if(pGrounded && ElasticityY > 0 && Vel.y > 0)
+						*pGrounded = true;
+					NewPos.y = Pos.y;
+					Vel.y *= -ElasticityY;
+					NewPos.x = Pos.x;
+					Vel.x *= -ElasticityX;
+				}
+			}
+
+			Pos = NewPos;
+		}
+	}
+
+	*pInoutPos = Pos;
+	*pInoutVel = Vel;
+}
+
+// Reference copy of the zone lookup testing every quad of the zone layers
+bool ReferenceInsideTriangle(vec2 t0, vec2 t1, vec2 t2, vec2 p)
+{
+	vec2 e0 = t1 - t0;
+	vec2 e1 = t2 - t0;
+	vec2 e2 = p - t0;
+
+	float d00 = dot(e0, e0);
+	float d01 = dot(e0, e1);
+	float d11 = dot(e1, e1);
+	float d20 = dot(e2, e0);
+	float d21 = dot(e2, e1);
+	float denom = d00 * d11 - d01 * d01;
+
+	float u = (d11 * d20 - d01 * d21) / denom;
+	float v = (d00 * d21 - d01 * d20) / denom;
+	return u >= 0.0f && v >= 0.0f && u + v < 1.0f;
+}
+
+bool ReferenceOutOfRange(float Value, float q0, float q1, float q2, float q3)
+{
+	return Value < minimum(minimum(q0, q1), minimum(q2, q3)) || Value > maximum(maximum(q0, q1), maximum(q2, q3));
+}
+
+int ReferenceGetZoneValueAt(CLayers &Layers, const char *pName, double Time, float x, float y, ZoneData *pData)
+{
+	int Index = 0;
+	int ExtraData = 0;
+	if(!Layers.ZoneGroup())
+		return 0;
+
+	for(int l = 0; l < Layers.ZoneGroup()->m_NumLayers; l++)
+	{
+		CMapItemLayer *pLayer = Layers.GetLayer(Layers.ZoneGroup()->m_StartLayer + l);
+		char aLayerName[12];
+		if(pLayer->m_Type == LAYERTYPE_TILES)
+		{
+			CMapItemLayerTilemap *pTLayer = (CMapItemLayerTilemap *)pLayer;
+			IntsToStr(pTLayer->m_aName, sizeof(aLayerName) / sizeof(int), aLayerName);
+			if(str_comp(pName, aLayerName) != 0)
+				continue;
+
+			CTile *pTiles = (CTile *)Layers.Map()->GetData(pTLayer->m_Data);
+			int Nx = clamp(round_to_int(x) / 32, 0, pTLayer->m_Width - 1);
+			int Ny = clamp(round_to_int(y) / 32, 0, pTLayer->m_Height - 1);
+			int TileIndex = pTiles[Ny * pTLayer->m_Width + Nx].m_Index;
+			if(TileIndex > 0 && TileIndex <= 128)
+				Index = TileIndex;
+		}
+		else if(pLayer->m_Type == LAYERTYPE_QUADS)
+		{
+			CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
+			IntsToStr(pQLayer->m_aName, sizeof(aLayerName) / sizeof(int), aLayerName);
+			if(str_comp(pName, aLayerName) != 0)
+				continue;
+
+			const CQuad *pQuads = (const CQuad *)Layers.Map()->GetDataSwapped(pQLayer->m_Data);
+			for(int q = 0; q < pQLayer->m_NumQuads; q++)
+			{
+				vec2 Position(0.0f, 0.0f);
+				float Angle = 0.0f;
+				if(pQuads[q].m_PosEnv >= 0)
+					GetAnimationTransform(Time, pQuads[q].m_PosEnv, &Layers, Position, Angle);
+
+				vec2 p[4];
+				for(int i = 0; i < 4; i++)
+					p[i] = Position + vec2(fx2f(pQuads[q].m_aPoints[i].x), fx2f(pQuads[q].m_aPoints[i].y));
+				if(Angle != 0)
+				{
+					vec2 Center(fx2f(pQuads[q].m_aPoints[4].x), fx2f(pQuads[q].m_aPoints[4].y));
+					for(vec2 &Point : p)
+					{
+						float px = Point.x - Center.x;
+						float py = Point.y - Center.y;
+						Point.x = px * cosf(Angle) - py * sinf(Angle) + Center.x;
+						Point.y = px * sinf(Angle) + py * cosf(Angle) + Center.y;
+					}
+				}
+
+				if(ReferenceOutOfRange(x, p[0].x, p[1].x, p[2].x, p[3].x) || ReferenceOutOfRange(y, p[0].y, p[1].y, p[2].y, p[3].y))
+					continue;
+				if(ReferenceInsideTriangle(p[0], p[1], p[2], vec2(x, y)) || ReferenceInsideTriangle(p[1], p[2], p[3], vec2(x, y)))
+				{
+					Index = pQuads[q].m_ColorEnvOffset;
+					ExtraData = pQuads[q].m_aColors[0].g;
+				}
+			}
+		}
+	}
+
+	pData->Index = Index;
+	pData->ExtraData = ExtraData;
+	return Index;
+}
+
+std::vector<vec2> ZoneQuadPoints(CLayers &Layers)
+{
+	std::vector<vec2> vPoints;
+	if(!Layers.ZoneGroup())
+		return vPoints;
+
+	for(int l = 0; l < Layers.ZoneGroup()->m_NumLayers; l++)
+	{
+		CMapItemLayer *pLayer = Layers.GetLayer(Layers.ZoneGroup()->m_StartLayer + l);
+		if(pLayer->m_Type != LAYERTYPE_QUADS)
+			continue;
+
+		CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
+		const CQuad *pQuads = (const CQuad *)Layers.Map()->GetDataSwapped(pQLayer->m_Data);
+		for(int q = 0; q < pQLayer->m_NumQuads; q++)
+		{
+			for(int i = 0; i < 5; i++)
+				vPoints.emplace_back(fx2f(pQuads[q].m_aPoints[i].x), fx2f(pQuads[q].m_aPoints[i].y));
+		}
+	}
+	return vPoints;
+}
+
+bool SameVec(vec2 a, vec2 b)
+{
+	return mem_comp(&a, &b, sizeof(vec2)) == 0;
+}
+
+std::vector<std::string> ShippedMaps()
+{
+	std::vector<std::string> vMaps;
+	fs_listdir(
+		"data/maps", [](const char *pName, int IsDir, int, void *pUser) {
+			if(!IsDir && str_endswith(pName, ".map"))
+				static_cast<std::vector<std::string> *>(pUser)->push_back(pName);
+			return 0;
+		},
+		0, &vMaps);
+	return vMaps;
+}
+
+vec2 RandomPos(std::mt19937 &Rng, const CCollision &Collision)
+{
+	// also a bit outside of the map
+	std::uniform_real_distribution<float> X(-200.0f, Collision.GetWidth() * 32.0f + 200.0f);
+	std::uniform_real_distribution<float> Y(-200.0f, Collision.GetHeight() * 32.0f + 200.0f);
+	return vec2(X(Rng), Y(Rng));
+}
+
+}
+
+TEST(Collision, MatchesReferenceOnShippedMaps)
+{
+	const std::vector<std::string> vMaps = ShippedMaps();
+	if(vMaps.empty())
+		GTEST_SKIP() << "no maps in data/maps";
+
+	std::mt19937 Rng(2024);
+	std::uniform_real_distribution<float> Length(0.0f, 1200.0f);
+	std::uniform_real_distribution<float> Angle(0.0f, 2 * pi);
+	std::uniform_real_distribution<float> Speed(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+
+	for(const std::string &MapName : vMaps)
+	{
+		CTestMap Map;
+		ASSERT_TRUE(Map.Load(MapName.c_str())) << MapName;
+		const CCollision &Collision = Map.m_Collision;
+
+		for(int i = 0; i < 20000; i++)
+		{
+			const vec2 From = RandomPos(Rng, Collision);
+			vec2 To = From + direction(Angle(Rng)) * Length(Rng);
+			if(i % 8 == 0)
+				To = vec2(From.x, To.y); // axis aligned rays
+			else if(i % 8 == 1)
+				To = vec2(To.x, From.y);
+
+			vec2 Collision0, Before0, Collision1, Before1;
+			const int Expected = ReferenceIntersectLine(Collision, From, To, &Collision0, &Before0);
+			const int Result = Collision.IntersectLine(From, To, &Collision1, &Before1);
+			ASSERT_EQ(Result, Expected) << MapName << " ray " << i;
+			ASSERT_TRUE(SameVec(Collision0, Collision1)) << MapName << " ray " << i;
+			ASSERT_TRUE(SameVec(Before0, Before1)) << MapName << " ray " << i;
+		}
+
+		for(int i = 0; i < 20000; i++)
+		{
+			vec2 Pos0 = RandomPos(Rng, Collision);
+			vec2 Vel0(Speed(Rng), Speed(Rng));
+			if(i % 16 == 0)
+				Vel0 *= 10.0f;
+			const vec2 Size = i % 2 ? vec2(28.0f, 28.0f) : vec2(Unit(Rng) * 60.0f, Unit(Rng) * 60.0f);
+			const vec2 Elasticity(Unit(Rng), Unit(Rng));
+
+			vec2 Pos1 = Pos0;
+			vec2 Vel1 = Vel0;
+			bool Grounded0 = false;
+			bool Grounded1 = false;
+			ReferenceMoveBox(Collision, &Pos0, &Vel0, Size, Elasticity, &Grounded0);
+			Collision.MoveBox(&Pos1, &Vel1, Size, Elasticity, &Grounded1);
+			ASSERT_TRUE(SameVec(Pos0, Pos1)) << MapName << " move " << i;
+			ASSERT_TRUE(SameVec(Vel0, Vel1)) << MapName << " move " << i;
+			ASSERT_EQ(Grounded0, Grounded1) << MapName << " move " << i;
+		}
+	}
+}
+
+TEST(Collision, ZoneValuesMatchReferenceOnShippedMaps)
+{
+	const std::vector<std::string> vMaps = ShippedMaps();
+	if(vMaps.empty())
+		GTEST_SKIP() << "no maps in data/maps";
+
+	std::mt19937 Rng(99);
+	std::uniform_real_distribution<float> Time(0.0f, 600.0f);
+	std::uniform_real_distribution<float> Offset(-100.0f, 100.0f);
+	const char *apZones[] = {"icDamage", "icTele", "icBonus"};
+
+	for(const std::string &MapName : vMaps)
+	{
+		CTestMap Map;
+		ASSERT_TRUE(Map.Load(MapName.c_str())) << MapName;
+		CCollision &Collision = Map.m_Collision;
+		// Half of the positions are near the quads, they are rare otherwise
+		const std::vector<vec2> vQuadPoints = ZoneQuadPoints(Map.m_Layers);
+
+		for(const char *pZone : apZones)
+		{
+			const int Handle = Collision.GetZoneHandle(pZone);
+			double CurrentTime = 0.0;
+			for(int i = 0; i < 5000; i++)
+			{
+				if(i % 500 == 0)
+				{
+					CurrentTime = Time(Rng);
+					Collision.SetTime(CurrentTime);
+				}
+				vec2 Pos = RandomPos(Rng, Collision);
+				if(!vQuadPoints.empty() && i % 2)
+					Pos = vQuadPoints[Rng() % vQuadPoints.size()] + vec2(Offset(Rng), Offset(Rng));
+
+				ZoneData Expected;
+				ZoneData Result;
+				const int ExpectedIndex = ReferenceGetZoneValueAt(Map.m_Layers, pZone, CurrentTime, Pos.x, Pos.y, &Expected);
+				ASSERT_EQ(Collision.GetZoneValueAt(Handle, Pos, &Result), ExpectedIndex) << MapName << " " << pZone << " " << i;
+				ASSERT_EQ(Result.Index, Expected.Index) << MapName << " " << pZone << " " << i;
+				ASSERT_EQ(Result.ExtraData, Expected.ExtraData) << MapName << " " << pZone << " " << i;
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <cctype>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+void NoopCommand(IConsole::IResult *pResult, void *pUserData)
+{
+	++*static_cast<int *>(pUserData);
+}
+
+class CTestConsole
+{
+public:
+	IKernel *m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	std::unique_ptr<IConsole> m_pConsole;
+
+	CTestConsole()
+	{
+		m_pKernel = IKernel::Create();
+		m_pStorage.reset(CreateTempStorage("."));
+		m_pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_ECON | CFGFLAG_CHAT);
+		IConfigManager *pConfigManager = CreateConfigManager();
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+		m_pKernel->RegisterInterface(pConfigManager);
+		m_pKernel->RegisterInterface(m_pConsole.get(), false);
+		pConfigManager->Init();
+		m_pConsole->Init();
+	}
+
+	~CTestConsole()
+	{
+		delete m_pKernel;
+	}
+
+	// The first command of the sorted list with this name, as the console
+	// found it before the index
+	const IConsole::CCommandInfo *ReferenceFind(const char *pName, int FlagMask) const
+	{
+		for(const IConsole::CCommandInfo *pInfo = m_pConsole->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask); pInfo; pInfo = pInfo->NextCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask))
+		{
+			if(str_comp_nocase(pInfo->m_pName, pName) == 0)
+				return pInfo;
+		}
+		return nullptr;
+	}
+};
+
+std::string Uppercase(const char *pName)
+{
+	std::string Name = pName;
+	for(char &c : Name)
+		c = std::toupper((unsigned char)c);
+	return Name;
+}
+
+std::vector<std::string> ReadConfigLines(const char *pFilename)
+{
+	std::vector<std::string> vLines;
+	std::ifstream File(std::string(CONFIG_DIRECTORY) + "/" + pFilename);
+	std::string Line;
+	while(std::getline(File, Line))
+	{
+		if(!Line.empty() && Line[0] != '#')
+			vLines.push_back(Line);
+	}
+	return vLines;
+}
+
+}
+
+TEST(Console, FindsTheFirstCommandOfTheList)
+{
+	CTestConsole Test;
+	int Calls = 0;
+	Test.m_pConsole->Register("Foo", "", CFGFLAG_SERVER, NoopCommand, &Calls, "");
+	Test.m_pConsole->Register("foo", "", CFGFLAG_CHAT, NoopCommand, &Calls, "");
+	Test.m_pConsole->Register("foo_bar", "", CFGFLAG_SERVER | CFGFLAG_CHAT, NoopCommand, &Calls, "");
+
+	std::vector<const char *> vNames;
+	for(const IConsole::CCommandInfo *pInfo = Test.m_pConsole->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER | CFGFLAG_CHAT); pInfo; pInfo = pInfo->NextCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER | CFGFLAG_CHAT))
+		vNames.push_back(pInfo->m_pName);
+	ASSERT_GT(vNames.size(), 100u);
+
+	for(int FlagMask : {(int)CFGFLAG_SERVER, (int)CFGFLAG_CHAT, CFGFLAG_SERVER | CFGFLAG_CHAT})
+	{
+		for(const char *pName : vNames)
+		{
+			const std::string Upper = Uppercase(pName);
+			EXPECT_EQ(Test.m_pConsole->GetCommandInfo(Upper.c_str(), FlagMask, false), Test.ReferenceFind(pName, FlagMask)) << pName;
+		}
+	}
+	EXPECT_STREQ(Test.m_pConsole->GetCommandInfo("FOO", CFGFLAG_SERVER, false)->m_pName, "Foo");
+	EXPECT_STREQ(Test.m_pConsole->GetCommandInfo("FOO", CFGFLAG_CHAT, false)->m_pName, "foo");
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("foo_", CFGFLAG_SERVER, false), nullptr);
+
+	Test.m_pConsole->ExecuteLine("FOO_BAR");
+	Test.m_pConsole->ExecuteLineFlag("foo", CFGFLAG_CHAT);
+	EXPECT_EQ(Calls, 2);
+}
+
+TEST(Console, TempCommands)
+{
+	CTestConsole Test;
+	Test.m_pConsole->RegisterTemp("temp_a", "", CFGFLAG_SERVER, "");
+	Test.m_pConsole->RegisterTemp("temp_b", "", CFGFLAG_SERVER, "");
+	EXPECT_NE(Test.m_pConsole->GetCommandInfo("TEMP_A", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, false), nullptr);
+
+	Test.m_pConsole->DeregisterTemp("temp_a");
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(Test.m_pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+
+	// the removed command is recycled under another name
+	Test.m_pConsole->RegisterTemp("temp_c", "", CFGFLAG_SERVER, "");
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(Test.m_pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true), nullptr);
+
+	Test.m_pConsole->DeregisterTempAll();
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(Test.m_pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(Test.m_pConsole->GetCommandInfo("echo", CFGFLAG_SERVER, false), nullptr);
+
+	Test.m_pConsole->RegisterTemp("temp_a", "", CFGFLAG_SERVER, "");
+	EXPECT_NE(Test.m_pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+}
+
+// Run with --gtest_also_run_disabled_tests to measure the time it takes to
+// execute the shipped configs
+TEST(Console, DISABLED_ExecuteConfigsCost)
+{
+	CTestConsole Test;
+	std::vector<std::string> vLines = ReadConfigLines("autoexec.cfg");
+	const std::vector<std::string> vReset = ReadConfigLines("reset.cfg");
+	vLines.insert(vLines.end(), vReset.begin(), vReset.end());
+	if(vLines.empty())
+		GTEST_SKIP() << "no configs in " << CONFIG_DIRECTORY;
+
+	// the game commands are not part of the engine, register stand-ins
+	std::deque<std::string> Names;
+	int Calls = 0;
+	for(const std::string &Line : vLines)
+	{
+		const std::string Name = Line.substr(0, Line.find(' '));
+		if(!Test.m_pConsole->GetCommandInfo(Name.c_str(), CFGFLAG_SERVER, false))
+		{
+			Names.push_back(Name);
+			Test.m_pConsole->Register(Names.back().c_str(), "?r", CFGFLAG_SERVER, NoopCommand, &Calls, "");
+		}
+	}
+	int NumCommands = 0;
+	for(const IConsole::CCommandInfo *pInfo = Test.m_pConsole->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER | CFGFLAG_CHAT); pInfo; pInfo = pInfo->NextCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, CFGFLAG_SERVER | CFGFLAG_CHAT))
+		NumCommands++;
+
+	const int NumPasses = 200;
+	const int64_t Start = time_get();
+	for(int Pass = 0; Pass < NumPasses; Pass++)
+		for(const std::string &Line : vLines)
+			Test.m_pConsole->ExecuteLine(Line.c_str());
+	const int64_t Time = time_get() - Start;
+
+	std::printf("%d commands, %zu lines: %.2f us/line\n", NumCommands, vLines.size(),
+		Time * 1e6 / time_freq() / (vLines.size() * NumPasses));
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+#include <tests/test_storage.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *const TEST_DIRECTORY = "datafile_reader_test";
+
+std::vector<std::string> ShippedMaps()
+{
+	std::vector<std::string> vMaps;
+	fs_listdir(
+		"data/maps", [](const char *pName, int IsDir, int, void *pUser) {
+			if(!IsDir && str_endswith(pName, ".map"))
+				static_cast<std::vector<std::string> *>(pUser)->push_back(pName);
+			return 0;
+		},
+		0, &vMaps);
+	return vMaps;
+}
+
+// Rewrites a version 4 datafile as version 3, with uncompressed data
+bool WriteVersion3(IStorage *pSourceStorage, const char *pSource, IStorage *pStorage, const char *pDestination)
+{
+	void *pFile;
+	unsigned FileSize;
+	if(!pSourceStorage->ReadFile(pSource, IStorage::TYPE_ALL, &pFile, &FileSize))
+		return false;
+	const int *pHeader = (const int *)pFile;
+	const int NumItemTypes = pHeader[4];
+	const int NumItems = pHeader[5];
+	const int NumRawData = pHeader[6];
+	const int ItemSize = pHeader[7];
+	const unsigned char *pTables = (const unsigned char *)pFile + 9 * sizeof(int);
+	const int TypesAndItemOffsetsSize = NumItemTypes * 3 * sizeof(int) + NumItems * sizeof(int);
+	const unsigned char *pItems = pTables + TypesAndItemOffsetsSize + 2 * NumRawData * sizeof(int);
+
+	CDataFileReader Reader;
+	if(!Reader.Open(pSourceStorage, pSource, IStorage::TYPE_ALL))
+	{
+		free(pFile);
+		return false;
+	}
+
+	std::vector<int> vDataOffsets;
+	int DataSize = 0;
+	for(int i = 0; i < NumRawData; i++)
+	{
+		vDataOffsets.push_back(DataSize);
+		DataSize += Reader.GetDataSize(i);
+	}
+
+	int aHeader[9];
+	mem_copy(aHeader, pHeader, sizeof(aHeader));
+	aHeader[1] = 3;
+	aHeader[8] = DataSize;
+
+	IOHANDLE File = pStorage->OpenFile(pDestination, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(File)
+	{
+		io_write(File, aHeader, sizeof(aHeader));
+		io_write(File, pTables, TypesAndItemOffsetsSize);
+		io_write(File, vDataOffsets.data(), vDataOffsets.size() * sizeof(int));
+		io_write(File, pItems, ItemSize);
+		for(int i = 0; i < NumRawData; i++)
+			io_write(File, Reader.GetData(i), Reader.GetDataSize(i));
+		io_close(File);
+	}
+	free(pFile);
+	return File != nullptr;
+}
+
+void ExpectSameContents(CDataFileReader &Expected, CDataFileReader &Actual, const std::string &Name)
+{
+	EXPECT_EQ(Expected.Crc(), Actual.Crc()) << Name;
+	EXPECT_EQ(Expected.Sha256(), Actual.Sha256()) << Name;
+
+	ASSERT_EQ(Expected.NumItems(), Actual.NumItems()) << Name;
+	for(int i = 0; i < Expected.NumItems(); i++)
+	{
+		int ExpectedType, ExpectedId, Type, Id;
+		const void *pExpected = Expected.GetItem(i, &ExpectedType, &ExpectedId);
+		const void *pActual = Actual.GetItem(i, &Type, &Id);
+		ASSERT_EQ(Expected.GetItemSize(i), Actual.GetItemSize(i)) << Name << " item " << i;
+		EXPECT_EQ(ExpectedType, Type) << Name << " item " << i;
+		EXPECT_EQ(ExpectedId, Id) << Name << " item " << i;
+		EXPECT_EQ(mem_comp(pExpected, pActual, Expected.GetItemSize(i)), 0) << Name << " item " << i;
+	}
+
+	ASSERT_EQ(Expected.NumData(), Actual.NumData()) << Name;
+	for(int i = 0; i < Expected.NumData(); i++)
+	{
+		ASSERT_EQ(Expected.GetDataSize(i), Actual.GetDataSize(i)) << Name << " data " << i;
+		const void *pExpected = Expected.GetData(i);
+		const void *pActual = Actual.GetData(i);
+		ASSERT_EQ(pExpected == nullptr, pActual == nullptr) << Name << " data " << i;
+		if(pExpected)
+		{
+			EXPECT_EQ(mem_comp(pExpected, pActual, Expected.GetDataSize(i)), 0) << Name << " data " << i;
+		}
+	}
+}
+
+class CTestFiles : public CTestStorage
+{
+public:
+	std::unique_ptr<IStorage> m_pMaps;
+
+	CTestFiles() :
+		CTestStorage(TEST_DIRECTORY)
+	{
+		m_pMaps.reset(CreateTempStorage("data"));
+	}
+};
+
+}
+
+TEST(DataFileReader, MappedMatchesReadOnShippedMaps)
+{
+	const std::vector<std::string> vMaps = ShippedMaps();
+	if(vMaps.empty())
+		GTEST_SKIP() << "no maps in data/maps";
+
+	CTestFiles Files;
+	for(const std::string &MapName : vMaps)
+	{
+		const std::string Path = "maps/" + MapName;
+		CDataFileReader Read;
+		ASSERT_TRUE(Read.Open(Files.m_pMaps.get(), Path.c_str(), IStorage::TYPE_ALL)) << MapName;
+		EXPECT_FALSE(Read.IsMapped());
+
+		CDataFileReader Mapped;
+		ASSERT_TRUE(Mapped.Open(Files.m_pMaps.get(), Path.c_str(), IStorage::TYPE_ALL, true)) << MapName;
+		EXPECT_TRUE(Mapped.IsMapped());
+		ExpectSameContents(Read, Mapped, MapName);
+		if(HasFatalFailure())
+			return;
+	}
+}
+
+TEST(DataFileReader, MappedMatchesReadUncompressed)
+{
+	const std::vector<std::string> vMaps = ShippedMaps();
+	if(vMaps.empty())
+		GTEST_SKIP() << "no maps in data/maps";
+
+	CTestFiles Files;
+	for(const std::string &MapName : vMaps)
+	{
+		const std::string Source = "maps/" + MapName;
+		const std::string Path = "v3_" + MapName;
+		ASSERT_TRUE(WriteVersion3(Files.m_pMaps.get(), Source.c_str(), Files.m_pStorage.get(), Path.c_str())) << MapName;
+
+		CDataFileReader Original;
+		ASSERT_TRUE(Original.Open(Files.m_pMaps.get(), Source.c_str(), IStorage::TYPE_ALL)) << MapName;
+		CDataFileReader Read;
+		ASSERT_TRUE(Read.Open(Files.m_pStorage.get(), Path.c_str(), IStorage::TYPE_SAVE)) << MapName;
+		CDataFileReader Mapped;
+		ASSERT_TRUE(Mapped.Open(Files.m_pStorage.get(), Path.c_str(), IStorage::TYPE_SAVE, true)) << MapName;
+
+		ASSERT_EQ(Original.NumData(), Read.NumData());
+		for(int i = 0; i < Original.NumData(); i++)
+		{
+			ASSERT_EQ(Original.GetDataSize(i), Read.GetDataSize(i)) << MapName << " data " << i;
+			EXPECT_EQ(mem_comp(Original.GetData(i), Read.GetData(i), Original.GetDataSize(i)), 0) << MapName << " data " << i;
+		}
+		ExpectSameContents(Read, Mapped, MapName);
+		if(HasFatalFailure())
+			return;
+
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+		// the uncompressed data is used in place
+		EXPECT_EQ(Mapped.LoadedDataSize(), 0u) << MapName;
+#endif
+	}
+}
+
+TEST(DataFileReader, MappedCacheIsBounded)
+{
+	const std::vector<std::string> vMaps = ShippedMaps();
+	if(vMaps.empty())
+		GTEST_SKIP() << "no maps in data/maps";
+
+	CTestFiles Files;
+	const size_t CacheSize = 64 * 1024;
+	for(const std::string &MapName : vMaps)
+	{
+		const std::string Path = "maps/" + MapName;
+		CDataFileReader Read;
+		ASSERT_TRUE(Read.Open(Files.m_pMaps.get(), Path.c_str(), IStorage::TYPE_ALL));
+		CDataFileReader Mapped;
+		Mapped.SetDataCacheSize(CacheSize);
+		ASSERT_TRUE(Mapped.Open(Files.m_pMaps.get(), Path.c_str(), IStorage::TYPE_ALL, true));
+		if(Mapped.NumData() < 2)
+			continue;
+
+		// the data in use is never evicted
+		const void *pPinned = Mapped.GetData(0);
+		const size_t PinnedSize = Mapped.GetDataSize(0);
+
+		for(int Pass = 0; Pass < 2; Pass++)
+		{
+			for(int i = 1; i < Mapped.NumData(); i++)
+			{
+				const void *pData = Mapped.GetData(i);
+				if(pData)
+				{
+					ASSERT_EQ(mem_comp(pData, Read.GetData(i), Mapped.GetDataSize(i)), 0) << MapName << " data " << i;
+				}
+				Mapped.UnloadData(i);
+				ASSERT_LE(Mapped.LoadedDataSize(), PinnedSize + CacheSize) << MapName;
+			}
+		}
+		EXPECT_EQ(Mapped.GetData(0), pPinned);
+		EXPECT_EQ(mem_comp(pPinned, Read.GetData(0), PinnedSize), 0) << MapName;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/demo.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+#include <tests/test_storage.h>
+
+#include <cstddef>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char *const TEST_DIRECTORY = "demo_recorder_test";
+
+// A game world of moving items, some of them appearing and disappearing
+class CTestWorld
+{
+public:
+	struct CItem
+	{
+		int m_Type;
+		int m_Id;
+		std::vector<int> m_vData;
+	};
+
+	std::vector<CItem> m_vItems;
+	std::vector<char> m_vSnapshot;
+
+	void Init(std::mt19937 &Rng, int NumItems)
+	{
+		for(int i = 0; i < NumItems; i++)
+			m_vItems.push_back({1 + (int)(Rng() % 8), i, std::vector<int>(2 + Rng() % 20, 0)});
+	}
+
+	void Tick(std::mt19937 &Rng)
+	{
+		for(CItem &Item : m_vItems)
+		{
+			if(Rng() % 4 == 0)
+				Item.m_vData[Rng() % Item.m_vData.size()] += Rng() % 64;
+		}
+		if(Rng() % 8 == 0)
+			m_vItems[Rng() % m_vItems.size()].m_Type = 1 + Rng() % 8;
+	}
+
+	const CSnapshot *Snapshot(int *pSize)
+	{
+		CSnapshotBuilder Builder;
+		Builder.Init();
+		for(const CItem &Item : m_vItems)
+		{
+			void *pData = Builder.NewItem(Item.m_Type, Item.m_Id, Item.m_vData.size() * sizeof(int));
+			mem_copy(pData, Item.m_vData.data(), Item.m_vData.size() * sizeof(int));
+		}
+		m_vSnapshot.resize(CSnapshot::MAX_SIZE);
+		*pSize = Builder.Finish(m_vSnapshot.data());
+		return (const CSnapshot *)m_vSnapshot.data();
+	}
+};
+
+class CTestRecording : public CTestStorage
+{
+public:
+	CSnapshotDelta m_SnapshotDelta;
+	SHA256_DIGEST m_MapSha256 = {};
+	unsigned char m_aMapData[1] = {0};
+
+	CTestRecording() :
+		CTestStorage(TEST_DIRECTORY)
+	{
+	}
+
+	bool Start(CDemoRecorder *pRecorder, const char *pFilename)
+	{
+		return pRecorder->Start(m_pStorage.get(), nullptr, pFilename, "0.6 test", "test", &m_MapSha256, 0, "server", 0, m_aMapData) == 0;
+	}
+
+	std::vector<unsigned char> ReadDemo(const char *pFilename)
+	{
+		std::vector<unsigned char> vData;
+		IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(!File)
+			return vData;
+		vData.resize(io_length(File));
+		io_read(File, vData.data(), vData.size());
+		io_close(File);
+		return vData;
+	}
+};
+
+// Records a game of NumTicks ticks with chat messages in between
+template<class FWait>
+void RecordGame(CDemoRecorder *pRecorder, int NumTicks, FWait &&Wait)
+{
+	std::mt19937 Rng(5);
+	CTestWorld World;
+	World.Init(Rng, 64);
+	for(int Tick = 1; Tick <= NumTicks; Tick++)
+	{
+		World.Tick(Rng);
+		int Size;
+		const CSnapshot *pSnapshot = World.Snapshot(&Size);
+		pRecorder->RecordSnapshot(Tick, pSnapshot, Size);
+		if(Rng() % 3 == 0)
+		{
+			char aMessage[64];
+			str_format(aMessage, sizeof(aMessage), "message at tick %d", Tick);
+			pRecorder->RecordMessage(aMessage, str_length(aMessage) + 1);
+		}
+		if(Tick % 300 == 0)
+			pRecorder->AddDemoMarker();
+		Wait();
+	}
+}
+
+}
+
+TEST(DemoRecorder, AsyncMatchesSync)
+{
+	CTestRecording Recording;
+	const int NumTicks = 2000;
+
+	CDemoRecorder Sync(&Recording.m_SnapshotDelta, true, false);
+	ASSERT_TRUE(Recording.Start(&Sync, "sync.demo"));
+	RecordGame(&Sync, NumTicks, [] {});
+	EXPECT_EQ(Sync.QueueDepth(), 0);
+	ASSERT_EQ(Sync.Stop(), 0);
+
+	CDemoRecorder Async(&Recording.m_SnapshotDelta, true, true);
+	ASSERT_TRUE(Recording.Start(&Async, "async.demo"));
+	// leave the writer enough room so that no frame is dropped
+	RecordGame(&Async, NumTicks, [&Async] {
+		while(Async.QueueDepth() > 16)
+			std::this_thread::yield();
+	});
+	EXPECT_GT(Async.MaxQueueDepth(), 0);
+	EXPECT_EQ(Async.NumDroppedFrames(), 0);
+	ASSERT_EQ(Async.Stop(), 0);
+	EXPECT_FALSE(Async.IsRecording());
+
+	const std::vector<unsigned char> vSync = Recording.ReadDemo("sync.demo");
+	const std::vector<unsigned char> vAsync = Recording.ReadDemo("async.demo");
+	ASSERT_GT(vSync.size(), sizeof(CDemoHeader));
+	ASSERT_EQ(vSync.size(), vAsync.size());
+
+	// the files only differ by the recording time
+	const size_t TimestampStart = offsetof(CDemoHeader, m_aTimestamp);
+	const size_t TimestampEnd = TimestampStart + sizeof(CDemoHeader::m_aTimestamp);
+	for(size_t i = 0; i < vSync.size(); i++)
+	{
+		if(i >= TimestampStart && i < TimestampEnd)
+			continue;
+		ASSERT_EQ(vSync[i], vAsync[i]) << "at offset " << i;
+	}
+}
+
+TEST(DemoRecorder, StopDrainsQueue)
+{
+	CTestRecording Recording;
+
+	CDemoRecorder Sync(&Recording.m_SnapshotDelta, true, false);
+	ASSERT_TRUE(Recording.Start(&Sync, "sync.demo"));
+	RecordGame(&Sync, 20, [] {});
+	ASSERT_EQ(Sync.Stop(), 0);
+
+	// stop right after queueing, the writer has to catch up first
+	CDemoRecorder Async(&Recording.m_SnapshotDelta, true, true);
+	ASSERT_TRUE(Recording.Start(&Async, "async.demo"));
+	RecordGame(&Async, 20, [] {});
+	ASSERT_EQ(Async.NumDroppedFrames(), 0);
+	ASSERT_EQ(Async.Stop(), 0);
+
+	EXPECT_EQ(Recording.ReadDemo("sync.demo").size(), Recording.ReadDemo("async.demo").size());
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+	CNetBase::Init();
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
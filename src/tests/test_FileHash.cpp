@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <base/hash.h>
+#include <base/system.h>
+#include <engine/shared/filehash.h>
+#include <engine/storage.h>
+#include <tests/test_storage.h>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include <zlib.h>
+
+namespace {
+
+const char *const TEST_DIRECTORY = "file_hash_test";
+
+class CTestFiles : public CTestStorage
+{
+public:
+	CTestFiles() :
+		CTestStorage(TEST_DIRECTORY)
+	{
+	}
+
+	void Write(const char *pFilename, const std::vector<unsigned char> &vData, bool Backdate)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		m_pStorage->GetCompletePath(IStorage::TYPE_SAVE, pFilename, aPath, sizeof(aPath));
+		fs_makedir_rec_for(aPath);
+		IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		io_write(File, vData.data(), vData.size());
+		io_close(File);
+
+		if(Backdate)
+		{
+			// files modified in the last seconds are not remembered
+			static int s_HoursAgo = 0;
+			s_HoursAgo++;
+			std::filesystem::last_write_time(aPath, std::filesystem::file_time_type::clock::now() - std::chrono::hours(s_HoursAgo));
+		}
+	}
+};
+
+std::vector<unsigned char> RandomData(std::mt19937 &Rng, int Size)
+{
+	std::vector<unsigned char> vData(Size);
+	for(unsigned char &c : vData)
+		c = Rng();
+	return vData;
+}
+
+void ExpectHashOf(const CFileHash &Hash, const std::vector<unsigned char> &vData)
+{
+	EXPECT_EQ(Hash.m_Crc, crc32(0, vData.data(), vData.size()));
+	EXPECT_EQ(Hash.m_Sha256, sha256(vData.data(), vData.size()));
+}
+
+}
+
+TEST(FileHash, MatchesContents)
+{
+	CTestFiles Files;
+	std::mt19937 Rng(1);
+	for(int Size : {0, 1, 1000, 64 * 1024, 300 * 1024 + 7})
+	{
+		const std::vector<unsigned char> vData = RandomData(Rng, Size);
+		Files.Write("file.map", vData, false);
+
+		CFileHash Hash;
+		ASSERT_TRUE(Hash.Compute(Files.m_pStorage.get(), "file.map", IStorage::TYPE_SAVE));
+		ExpectHashOf(Hash, vData);
+	}
+
+	CFileHash Hash;
+	EXPECT_FALSE(Hash.Compute(Files.m_pStorage.get(), "missing.map", IStorage::TYPE_SAVE));
+}
+
+TEST(FileHash, SidecarIsReused)
+{
+	CTestFiles Files;
+	std::mt19937 Rng(2);
+	const std::vector<unsigned char> vData = RandomData(Rng, 100 * 1024);
+	Files.Write("maps/file.map", vData, true);
+
+	const int64_t NumHashed = CFileHash::NumHashedFiles();
+	CFileHash Hash;
+	ASSERT_TRUE(Hash.Compute(Files.m_pStorage.get(), "maps/file.map", IStorage::TYPE_ALL, true));
+	ExpectHashOf(Hash, vData);
+	EXPECT_EQ(CFileHash::NumHashedFiles(), NumHashed + 1);
+	EXPECT_TRUE(Files.m_pStorage->FileExists("maps/file.map.hash", IStorage::TYPE_SAVE));
+
+	CFileHash Cached;
+	ASSERT_TRUE(Cached.Compute(Files.m_pStorage.get(), "maps/file.map", IStorage::TYPE_ALL, true));
+	ExpectHashOf(Cached, vData);
+	EXPECT_EQ(CFileHash::NumHashedFiles(), NumHashed + 1);
+
+	// same size, other contents and modification time
+	const std::vector<unsigned char> vOther = RandomData(Rng, vData.size());
+	Files.Write("maps/file.map", vOther, true);
+	CFileHash Changed;
+	ASSERT_TRUE(Changed.Compute(Files.m_pStorage.get(), "maps/file.map", IStorage::TYPE_ALL, true));
+	ExpectHashOf(Changed, vOther);
+	EXPECT_EQ(CFileHash::NumHashedFiles(), NumHashed + 2);
+}
+
+TEST(FileHash, RecentFileIsNotRemembered)
+{
+	CTestFiles Files;
+	std::mt19937 Rng(3);
+	const std::vector<unsigned char> vData = RandomData(Rng, 1000);
+	Files.Write("file.map", vData, false);
+
+	const int64_t NumHashed = CFileHash::NumHashedFiles();
+	for(int i = 0; i < 2; i++)
+	{
+		CFileHash Hash;
+		ASSERT_TRUE(Hash.Compute(Files.m_pStorage.get(), "file.map", IStorage::TYPE_SAVE, true));
+		ExpectHashOf(Hash, vData);
+	}
+	EXPECT_EQ(CFileHash::NumHashedFiles(), NumHashed + 2);
+	EXPECT_FALSE(Files.m_pStorage->FileExists("file.map.hash", IStorage::TYPE_SAVE));
+}
+
+TEST(FileHash, NotRememberedByDefault)
+{
+	CTestFiles Files;
+	std::mt19937 Rng(4);
+	const std::vector<unsigned char> vData = RandomData(Rng, 1000);
+	Files.Write("maps/file.map", vData, true);
+
+	const int64_t NumHashed = CFileHash::NumHashedFiles();
+	for(int i = 0; i < 2; i++)
+	{
+		CFileHash Hash;
+		ASSERT_TRUE(Hash.Compute(Files.m_pStorage.get(), "maps/file.map", IStorage::TYPE_ALL));
+		ExpectHashOf(Hash, vData);
+	}
+	EXPECT_EQ(CFileHash::NumHashedFiles(), NumHashed + 2);
+	EXPECT_FALSE(Files.m_pStorage->FileExists("maps/file.map.hash", IStorage::TYPE_SAVE));
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
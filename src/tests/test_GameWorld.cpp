@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/entity.h>
+#include <game/server/gamecontext.h>
+#include <game/server/gameworld.h>
+#include <game/server/infclass/entities/infcentity.h>
+#include <tests/test_server.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+class CTestEntity : public CEntity
+{
+public:
+	CTestEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRadius, bool Insert = true) :
+		CEntity(pGameWorld, ObjType, Pos, ProximityRadius)
+	{
+		if(Insert)
+			GameWorld()->InsertEntity(this);
+	}
+
+	// Counts the calls of Destroy() and destroys another entity from it
+	int *m_pNumDestroyed = nullptr;
+	CEntity *m_pDestroyWith = nullptr;
+
+	void Destroy() override
+	{
+		if(m_pNumDestroyed)
+			(*m_pNumDestroyed)++;
+		if(m_pDestroyWith)
+			GameWorld()->DestroyEntity(m_pDestroyWith);
+		CEntity::Destroy();
+	}
+};
+
+class CTestInfCEntity : public CInfCEntity
+{
+public:
+	CTestInfCEntity(CGameContext *pGameContext, int ObjType, int Owner) :
+		CInfCEntity(pGameContext, ObjType, vec2(100, 100), Owner)
+	{
+		GameWorld()->InsertEntity(this);
+	}
+};
+
+// A world next to the one of the game context
+class CTestWorld : public CTestServer
+{
+public:
+	CGameWorld m_World;
+
+	CTestWorld()
+	{
+		InitWorld(&m_World);
+	}
+
+	~CTestWorld()
+	{
+		DeleteEntities(&m_World);
+	}
+
+	// A tick of the paused world, only removing the destroyed entities
+	void RemoveEntities()
+	{
+		m_World.m_Paused = true;
+		m_World.Tick();
+	}
+
+	// FindEntities without the spatial index
+	int ReferenceFind(vec2 Pos, float Radius, int Type)
+	{
+		int Num = 0;
+		for(CEntity *pEnt = m_World.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+		{
+			if(distance(pEnt->GetPos(), Pos) < Radius + pEnt->GetProximityRadius())
+				Num++;
+		}
+		return Num;
+	}
+};
+
+}
+
+TEST(GameWorld, FindsMovedEntity)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	CEntity *pEnt = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+
+	CEntity *apEnts[4];
+	EXPECT_EQ(World.FindEntities(vec2(100, 100), 10, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+	EXPECT_EQ(apEnts[0], pEnt);
+
+	// three cells away, the entity must only be found at its new position
+	pEnt->SetPos(vec2(900, 700));
+	EXPECT_EQ(World.FindEntities(vec2(100, 100), 10, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 0);
+	EXPECT_EQ(World.FindEntities(vec2(905, 700), 10, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+	EXPECT_EQ(World.ClosestEntity(vec2(900, 720), 30, CGameWorld::ENTTYPE_PROJECTILE, nullptr), pEnt);
+	EXPECT_EQ(World.ClosestEntity(vec2(100, 100), 30, CGameWorld::ENTTYPE_PROJECTILE, nullptr), nullptr);
+
+	// out of the map the entity is kept in the border cells
+	pEnt->SetPos(vec2(-500, Test.HEIGHT + 500));
+	EXPECT_EQ(World.FindEntities(vec2(-500, Test.HEIGHT + 500), 10, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+	EXPECT_EQ(World.FindEntities(vec2(900, 700), 10, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 0);
+}
+
+TEST(GameWorld, ProximityRadiusReachesOtherCells)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(500, 500), 0);
+	CEntity *pLarge = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(1000, 500), 300);
+
+	// the query box is in other cells than the entity, its radius reaches it
+	CEntity *apEnts[4];
+	EXPECT_EQ(World.FindEntities(vec2(1340, 500), 50, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+	EXPECT_EQ(apEnts[0], pLarge);
+
+	pLarge->SetPos(vec2(2000, 1500));
+	EXPECT_EQ(World.FindEntities(vec2(1340, 500), 50, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 0);
+	EXPECT_EQ(World.FindEntities(vec2(2000, 1840), 50, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+
+	// the margin of the type stays after the large entity is gone
+	delete pLarge;
+	EXPECT_EQ(World.FindEntities(vec2(2000, 1840), 50, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 0);
+	EXPECT_EQ(World.FindEntities(vec2(520, 500), 50, apEnts, 4, CGameWorld::ENTTYPE_PROJECTILE), 1);
+}
+
+TEST(GameWorld, FindsOwnedEntities)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	const int Type = CGameWorld::ENTTYPE_PROJECTILE;
+	CEntity *pFirst = new CTestEntity(&World, Type, vec2(100, 100), 0);
+	World.SetEntityOwner(pFirst, 3);
+	CEntity *pOther = new CTestEntity(&World, Type, vec2(200, 100), 0);
+	World.SetEntityOwner(pOther, 5);
+	CEntity *pSecond = new CTestEntity(&World, Type, vec2(300, 100), 0);
+	World.SetEntityOwner(pSecond, 3);
+
+	// the last inserted entity first, like the type list
+	EXPECT_EQ(World.FindFirstOwned(Type, 3), pSecond);
+	EXPECT_EQ(pSecond->OwnedNext(), pFirst);
+	EXPECT_EQ(pFirst->OwnedNext(), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(Type, 5), pOther);
+	EXPECT_EQ(pOther->OwnedNext(), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(Type, 4), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(CGameWorld::ENTTYPE_LASER, 3), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(Type, -1), nullptr);
+
+	// an entity owned before it is inserted
+	CEntity *pThird = new CTestEntity(&World, Type, vec2(400, 100), 0, false);
+	World.SetEntityOwner(pThird, 3);
+	EXPECT_EQ(World.FindFirstOwned(Type, 3), pSecond);
+	World.InsertEntity(pThird);
+	EXPECT_EQ(World.FindFirstOwned(Type, 3), pThird);
+	EXPECT_EQ(pThird->OwnedNext(), pSecond);
+}
+
+TEST(GameWorld, ChangesOwnerOfEntities)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	const int Type = CGameWorld::ENTTYPE_PROJECTILE;
+	CEntity *apEnts[3];
+	for(auto *&pEnt : apEnts)
+	{
+		pEnt = new CTestEntity(&World, Type, vec2(100, 100), 0);
+		World.SetEntityOwner(pEnt, 2);
+	}
+
+	// the head moves to a new owner, the other entities of the owner stay
+	World.SetEntityOwner(apEnts[2], 7);
+	EXPECT_EQ(World.FindFirstOwned(Type, 7), apEnts[2]);
+	EXPECT_EQ(apEnts[2]->OwnedNext(), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(Type, 2), apEnts[1]);
+	EXPECT_EQ(apEnts[1]->OwnedNext(), apEnts[0]);
+
+	// back to the first owner, it goes back to its place in the order
+	World.SetEntityOwner(apEnts[2], 2);
+	EXPECT_EQ(World.FindFirstOwned(Type, 7), nullptr);
+	EXPECT_EQ(World.FindFirstOwned(Type, 2), apEnts[2]);
+	EXPECT_EQ(apEnts[2]->OwnedNext(), apEnts[1]);
+
+	// an entity without owner is not indexed
+	World.SetEntityOwner(apEnts[1], -1);
+	EXPECT_EQ(World.FindFirstOwned(Type, 2), apEnts[2]);
+	EXPECT_EQ(apEnts[2]->OwnedNext(), apEnts[0]);
+	EXPECT_EQ(apEnts[0]->OwnedNext(), nullptr);
+	World.SetEntityOwner(apEnts[2], -1);
+	World.SetEntityOwner(apEnts[0], -1);
+	EXPECT_EQ(World.FindFirstOwned(Type, 2), nullptr);
+}
+
+TEST(GameWorld, RemovesOwnedEntities)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	const int Type = CGameWorld::ENTTYPE_PROJECTILE;
+	CEntity *apEnts[3];
+	for(auto *&pEnt : apEnts)
+	{
+		pEnt = new CTestEntity(&World, Type, vec2(100, 100), 0);
+		World.SetEntityOwner(pEnt, 0);
+	}
+
+	// the head is unlinked, the next entities are still reachable
+	World.RemoveEntity(apEnts[2]);
+	EXPECT_EQ(World.FindFirstOwned(Type, 0), apEnts[1]);
+	EXPECT_EQ(apEnts[1]->OwnedNext(), apEnts[0]);
+	EXPECT_EQ(apEnts[2]->OwnedNext(), nullptr);
+
+	// a removed entity changing its owner is not indexed
+	World.SetEntityOwner(apEnts[2], 1);
+	EXPECT_EQ(World.FindFirstOwned(Type, 1), nullptr);
+	delete apEnts[2];
+
+	delete apEnts[0];
+	EXPECT_EQ(World.FindFirstOwned(Type, 0), apEnts[1]);
+	EXPECT_EQ(apEnts[1]->OwnedNext(), nullptr);
+	delete apEnts[1];
+	EXPECT_EQ(World.FindFirstOwned(Type, 0), nullptr);
+}
+
+TEST(GameWorld, OwnerOfInfClassEntities)
+{
+	// the infclass entities live in the world of the game context
+	CTestWorld Test;
+	CGameWorld *pWorld = Test.m_pGameContext->GameWorld();
+	const int Type = CGameWorld::ENTTYPE_LOOPER_WALL;
+
+	CTestInfCEntity *pFirst = new CTestInfCEntity(Test.m_pGameContext, Type, 1);
+	CTestInfCEntity *pSecond = new CTestInfCEntity(Test.m_pGameContext, Type, 1);
+	EXPECT_EQ(pWorld->FindFirstOwned(Type, 1), pSecond);
+	EXPECT_EQ(pSecond->OwnedNext(), pFirst);
+
+	pSecond->SetOwner(2);
+	EXPECT_EQ(pSecond->GetOwner(), 2);
+	EXPECT_EQ(pWorld->FindFirstOwned(Type, 1), pFirst);
+	EXPECT_EQ(pFirst->OwnedNext(), nullptr);
+	EXPECT_EQ(pWorld->FindFirstOwned(Type, 2), pSecond);
+
+	pFirst->SetOwner(-1);
+	EXPECT_EQ(pWorld->FindFirstOwned(Type, 1), nullptr);
+
+	delete pFirst;
+	delete pSecond;
+	EXPECT_EQ(pWorld->FindFirstOwned(Type, 2), nullptr);
+}
+
+TEST(GameWorld, DestroysMarkedEntityWhenInserted)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	int NumDestroyed = 0;
+	CTestEntity *pEnt = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0, false);
+	pEnt->m_pNumDestroyed = &NumDestroyed;
+
+	// out of the world it is only marked
+	pEnt->MarkForDestroy();
+	EXPECT_TRUE(pEnt->IsMarkedForDestroy());
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 0);
+
+	World.InsertEntity(pEnt);
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 1);
+	EXPECT_EQ(World.FindFirst(CGameWorld::ENTTYPE_PROJECTILE), nullptr);
+}
+
+TEST(GameWorld, DestroysEntityOnce)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	int NumDestroyed = 0;
+	CTestEntity *pEnt = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+	pEnt->m_pNumDestroyed = &NumDestroyed;
+	CEntity *pKept = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+
+	World.DestroyEntity(pEnt);
+	World.DestroyEntity(pEnt);
+	pEnt->MarkForDestroy();
+	EXPECT_EQ(pKept->TypeNext(), pEnt);
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 1);
+	EXPECT_EQ(World.FindFirst(CGameWorld::ENTTYPE_PROJECTILE), pKept);
+	EXPECT_EQ(pKept->TypeNext(), nullptr);
+
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 1);
+}
+
+TEST(GameWorld, RemovedEntityLeavesDestroyQueue)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	int NumDestroyed = 0;
+	CTestEntity *apEnts[3];
+	for(auto *&pEnt : apEnts)
+	{
+		pEnt = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+		pEnt->m_pNumDestroyed = &NumDestroyed;
+		World.DestroyEntity(pEnt);
+	}
+
+	// removed from the world while pending, the entity is not destroyed
+	World.RemoveEntity(apEnts[1]);
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 2);
+	EXPECT_EQ(World.FindFirst(CGameWorld::ENTTYPE_PROJECTILE), nullptr);
+
+	// and it is queued again when it is inserted again
+	World.InsertEntity(apEnts[1]);
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 3);
+
+	// deleted while pending
+	CTestEntity *pDeleted = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+	pDeleted->m_pNumDestroyed = &NumDestroyed;
+	World.DestroyEntity(pDeleted);
+	delete pDeleted;
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 3);
+}
+
+TEST(GameWorld, DestroysEntitiesDestroyedByOthers)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	int NumDestroyed = 0;
+	CTestEntity *apEnts[5];
+	for(auto *&pEnt : apEnts)
+	{
+		pEnt = new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(100, 100), 0);
+		pEnt->m_pNumDestroyed = &NumDestroyed;
+	}
+
+	// a chain of destructions
+	apEnts[0]->m_pDestroyWith = apEnts[1];
+	apEnts[1]->m_pDestroyWith = apEnts[2];
+	World.DestroyEntity(apEnts[0]);
+
+	// an entity destroyed again while it is waiting in the queue
+	apEnts[3]->m_pDestroyWith = apEnts[4];
+	World.DestroyEntity(apEnts[3]);
+	World.DestroyEntity(apEnts[4]);
+
+	Test.RemoveEntities();
+	EXPECT_EQ(NumDestroyed, 5);
+	EXPECT_EQ(World.FindFirst(CGameWorld::ENTTYPE_PROJECTILE), nullptr);
+}
+
+TEST(GameWorld, QueriesMatchFullTraversal)
+{
+	CTestWorld Test;
+	CGameWorld &World = Test.m_World;
+	std::mt19937 Rng(1);
+	std::uniform_real_distribution<float> X(-200, Test.WIDTH + 200);
+	std::uniform_real_distribution<float> Y(-200, Test.HEIGHT + 200);
+	std::uniform_int_distribution<int> Radius(0, 64);
+
+	std::vector<CEntity *> vpEnts;
+	for(int i = 0; i < 300; i++)
+		vpEnts.push_back(new CTestEntity(&World, CGameWorld::ENTTYPE_PROJECTILE, vec2(X(Rng), Y(Rng)), Radius(Rng)));
+
+	for(int Step = 0; Step < 50; Step++)
+	{
+		// a few entities jump, the others move a bit
+		for(CEntity *pEnt : vpEnts)
+		{
+			if(Rng() % 10 == 0)
+				pEnt->SetPos(vec2(X(Rng), Y(Rng)));
+			else
+				pEnt->SetPos(pEnt->GetPos() + vec2(Rng() % 41 - 20.0f, Rng() % 41 - 20.0f));
+		}
+
+		for(int Query = 0; Query < 20; Query++)
+		{
+			const vec2 Pos(X(Rng), Y(Rng));
+			const float QueryRadius = Rng() % 400;
+			EXPECT_EQ(World.FindEntities(Pos, QueryRadius, nullptr, 1000, CGameWorld::ENTTYPE_PROJECTILE), Test.ReferenceFind(Pos, QueryRadius, CGameWorld::ENTTYPE_PROJECTILE))
+				<< "step " << Step << " at " << Pos.x << " " << Pos.y << " radius " << QueryRadius;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <infclassr/geolocation.h>
+
+#include <memory>
+
+TEST(Geolocation, IsoNumericCode)
+{
+	EXPECT_EQ(Geolocation::iso_numeric_code("AD", 2), 20);
+	EXPECT_EQ(Geolocation::iso_numeric_code("DE", 2), 276);
+	EXPECT_EQ(Geolocation::iso_numeric_code("FR", 2), 250);
+	EXPECT_EQ(Geolocation::iso_numeric_code("RU", 2), 643);
+	EXPECT_EQ(Geolocation::iso_numeric_code("US", 2), 840);
+	EXPECT_EQ(Geolocation::iso_numeric_code("ZW", 2), 716);
+
+	// the codes of the database are not terminated
+	EXPECT_EQ(Geolocation::iso_numeric_code("GBR", 2), 826);
+
+	EXPECT_EQ(Geolocation::iso_numeric_code("AA", 2), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("ZZ", 2), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("UK", 2), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("us", 2), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("DEU", 3), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("D", 1), 0);
+	EXPECT_EQ(Geolocation::iso_numeric_code("", 0), 0);
+}
+
+TEST(Geolocation, PrefixLength)
+{
+	// an IPv4 address looked up in the IPv4 subtree of an IPv6 database
+	EXPECT_EQ(CGeolocationCache::PrefixLength(120, AF_INET, 6), 24);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(128, AF_INET, 6), 32);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(96, AF_INET, 6), 0);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(80, AF_INET, 6), 0);
+
+	EXPECT_EQ(CGeolocationCache::PrefixLength(24, AF_INET, 4), 24);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(48, AF_INET, 4), 32);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(48, AF_INET6, 6), 48);
+	EXPECT_EQ(CGeolocationCache::PrefixLength(128, AF_INET6, 6), 128);
+}
+
+TEST(Geolocation, CachedNetworks)
+{
+	std::unique_ptr<CGeolocationCache> pCache = std::make_unique<CGeolocationCache>();
+	const unsigned char aAddr[16] = {192, 168, 17, 5};
+	pCache->Add(AF_INET, aAddr, CGeolocationCache::PrefixLength(116, AF_INET, 6), 276);
+
+	// the addresses of the /20 network share its country
+	int Country = -1;
+	const unsigned char aSameNetwork[16] = {192, 168, 31, 200};
+	EXPECT_TRUE(pCache->Find(AF_INET, aSameNetwork, &Country));
+	EXPECT_EQ(Country, 276);
+
+	const unsigned char aOtherNetwork[16] = {192, 168, 32, 1};
+	EXPECT_FALSE(pCache->Find(AF_INET, aOtherNetwork, &Country));
+	EXPECT_FALSE(pCache->Find(AF_INET6, aSameNetwork, &Country));
+
+	// without the netmask adjustment the IPv4 network would be a /32
+	const unsigned char aHost[16] = {10, 0, 0, 1};
+	pCache->Add(AF_INET, aHost, CGeolocationCache::PrefixLength(128, AF_INET, 6), 840);
+	const unsigned char aNextHost[16] = {10, 0, 0, 2};
+	EXPECT_TRUE(pCache->Find(AF_INET, aHost, &Country));
+	EXPECT_EQ(Country, 840);
+	EXPECT_FALSE(pCache->Find(AF_INET, aNextHost, &Country));
+
+	const unsigned char aAddr6[16] = {0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34};
+	pCache->Add(AF_INET6, aAddr6, 32, 250);
+	const unsigned char aSameNetwork6[16] = {0x20, 0x01, 0x0d, 0xb8, 0xff, 0xff, 1, 2, 3};
+	EXPECT_TRUE(pCache->Find(AF_INET6, aSameNetwork6, &Country));
+	EXPECT_EQ(Country, 250);
+}
+
+TEST(Geolocation, LeastRecentlyUsedNetworkReplaced)
+{
+	std::unique_ptr<CGeolocationCache> pCache = std::make_unique<CGeolocationCache>();
+	for(int i = 0; i < CGeolocationCache::CACHE_SIZE; i++)
+	{
+		const unsigned char aAddr[16] = {10, (unsigned char)i};
+		pCache->Add(AF_INET, aAddr, 16, i);
+	}
+
+	int Country;
+	const unsigned char aFirst[16] = {10, 0, 1, 1};
+	EXPECT_TRUE(pCache->Find(AF_INET, aFirst, &Country));
+	EXPECT_EQ(Country, 0);
+
+	// the first network was used again, the second one is replaced
+	const unsigned char aNew[16] = {11, 0};
+	pCache->Add(AF_INET, aNew, 16, 1000);
+	const unsigned char aSecond[16] = {10, 1, 1, 1};
+	EXPECT_FALSE(pCache->Find(AF_INET, aSecond, &Country));
+	EXPECT_TRUE(pCache->Find(AF_INET, aFirst, &Country));
+	EXPECT_TRUE(pCache->Find(AF_INET, aNew, &Country));
+	EXPECT_EQ(Country, 1000);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
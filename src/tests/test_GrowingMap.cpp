@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/infclass/growing_map.h>
+#include <tests/test_map.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The previous growth, scanning the whole grid on every tick. Returns the
+// cells reached on every tick in scan order.
+std::vector<std::vector<int>> ReferenceGrowth(const CCollision &Collision, vec2 SeedPos, int Radius)
+{
+	const int Length = 2 * Radius + 1;
+	std::vector<int> vMap(Length * Length);
+	for(int j = 0; j < Length; j++)
+	{
+		for(int i = 0; i < Length; i++)
+		{
+			vec2 Tile = SeedPos + vec2(32.0f * (i - Radius), 32.0f * (j - Radius));
+			vMap[j * Length + i] = Collision.CheckPoint(Tile) || distance(Tile, SeedPos) > Radius * 32.0f ? -2 : -1;
+		}
+	}
+	vMap[Radius * Length + Radius] = 0;
+
+	std::vector<std::vector<int>> vvSteps = {{Radius * Length + Radius}};
+	for(int Tick = 1;; Tick++)
+	{
+		std::vector<int> vStep;
+		for(int j = 0; j < Length; j++)
+		{
+			for(int i = 0; i < Length; i++)
+			{
+				const int k = j * Length + i;
+				if(vMap[k] != -1)
+					continue;
+				auto Reached = [&](int Cell) { return vMap[Cell] >= 0 && vMap[Cell] < Tick; };
+				if((i > 0 && Reached(k - 1)) || (i < Length - 1 && Reached(k + 1)) ||
+					(j > 0 && Reached(k - Length)) || (j < Length - 1 && Reached(k + Length)))
+				{
+					vMap[k] = Tick;
+					vStep.push_back(k);
+				}
+			}
+		}
+		if(vStep.empty())
+			break;
+		vvSteps.push_back(std::move(vStep));
+	}
+	return vvSteps;
+}
+
+vec2 RandomSeed(std::mt19937 &Rng, const CCollision &Collision)
+{
+	std::uniform_int_distribution<int> X(0, Collision.GetWidth() - 1);
+	std::uniform_int_distribution<int> Y(0, Collision.GetHeight() - 1);
+	return vec2(X(Rng) * 32.0f + 16.0f, Y(Rng) * 32.0f + 16.0f);
+}
+
+}
+
+TEST(GrowingMap, LayersMatchRescan)
+{
+	CTestMap Map;
+	if(!Map.Load("infc_skull.map"))
+		GTEST_SKIP() << "infc_skull.map is missing";
+
+	std::mt19937 Rng(5);
+	std::uniform_int_distribution<int> Radius(1, 20);
+	for(int n = 0; n < 500; n++)
+	{
+		const vec2 Seed = RandomSeed(Rng, Map.m_Collision);
+		const int R = Radius(Rng);
+
+		CGrowingMap GrowingMap;
+		GrowingMap.Init(&Map.m_Collision, Seed, R, 0);
+		const std::vector<std::vector<int>> vvExpected = ReferenceGrowth(Map.m_Collision, Seed, R);
+		ASSERT_EQ(GrowingMap.NumLayers(), (int)vvExpected.size());
+		for(int Layer = 0; Layer < GrowingMap.NumLayers(); Layer++)
+		{
+			const std::vector<int> vLayer(GrowingMap.LayerBegin(Layer), GrowingMap.LayerEnd(Layer));
+			ASSERT_EQ(vLayer, vvExpected[Layer]) << "seed " << n << " layer " << Layer;
+		}
+
+		EXPECT_EQ(GrowingMap.CellAt(Seed), R * GrowingMap.Length() + R);
+		EXPECT_EQ(GrowingMap.CellAt(Seed + vec2(32.0f * (R + 1), 0.0f)), -1);
+	}
+}
+
+// Run with --gtest_also_run_disabled_tests to compare the cost of growing
+// 50 simultaneous explosions with the previous full grid scans.
+TEST(GrowingMap, DISABLED_FiftyExplosionsCost)
+{
+	CTestMap Map;
+	if(!Map.Load("infc_skull.map"))
+		GTEST_SKIP() << "infc_skull.map is missing";
+
+	const int NumExplosions = 50;
+	const int NumRounds = 20;
+	for(int R : {4, 6, 16, 20})
+	{
+		std::mt19937 Rng(R);
+		std::vector<vec2> vSeeds(NumExplosions);
+		for(vec2 &Seed : vSeeds)
+			Seed = RandomSeed(Rng, Map.m_Collision);
+
+		int64_t ReferenceCells = 0;
+		int64_t Start = time_get();
+		for(int Round = 0; Round < NumRounds; Round++)
+		{
+			for(const vec2 &Seed : vSeeds)
+			{
+				for(const std::vector<int> &vStep : ReferenceGrowth(Map.m_Collision, Seed, R))
+					ReferenceCells += vStep.size();
+			}
+		}
+		const int64_t ReferenceTime = time_get() - Start;
+
+		int64_t Cells = 0;
+		Start = time_get();
+		for(int Round = 0; Round < NumRounds; Round++)
+		{
+			for(const vec2 &Seed : vSeeds)
+			{
+				CGrowingMap GrowingMap;
+				GrowingMap.Init(&Map.m_Collision, Seed, R, 0);
+				for(int Layer = 0; Layer < GrowingMap.NumLayers(); Layer++)
+				{
+					for(const int *pCell = GrowingMap.LayerBegin(Layer); pCell != GrowingMap.LayerEnd(Layer); pCell++)
+					{
+						GrowingMap.SetCellTick(*pCell, Layer);
+						Cells++;
+					}
+				}
+			}
+		}
+		const int64_t Time = time_get() - Start;
+
+		EXPECT_EQ(Cells, ReferenceCells);
+		std::printf("radius %2d: 50 explosions, rescan %8.1f us, layers %8.1f us\n", R,
+			ReferenceTime * 1e6 / time_freq() / NumRounds, Time * 1e6 / time_freq() / NumRounds);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/external/json-parser/json.h>
+#include <engine/storage.h>
+#include <teeuniverses/components/localization.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The translations of a language file, read independently of CLocalization
+struct CLanguageFile
+{
+	std::string m_Code;
+	std::map<std::string, std::string> m_Values;
+	std::map<std::string, std::pair<std::string, std::string>> m_OneAndOther;
+};
+
+std::vector<CLanguageFile> ReadLanguageFiles(IStorage *pStorage)
+{
+	std::vector<CLanguageFile> vFiles;
+	void *pIndexData;
+	unsigned IndexSize;
+	if(!pStorage->ReadFile("languages/index.json", IStorage::TYPE_ALL, &pIndexData, &IndexSize))
+		return vFiles;
+
+	json_value *pIndex = json_parse((const char *)pIndexData, IndexSize);
+	free(pIndexData);
+	if(!pIndex)
+		return vFiles;
+
+	const json_value &rIndices = (*pIndex)["language indices"];
+	for(unsigned i = 0; i < rIndices.u.array.length; i++)
+	{
+		CLanguageFile File;
+		File.m_Code = (const char *)rIndices[i]["file"];
+
+		char aPath[128];
+		str_format(aPath, sizeof(aPath), "languages/%s.json", File.m_Code.c_str());
+		void *pData;
+		unsigned Size;
+		if(!pStorage->ReadFile(aPath, IStorage::TYPE_ALL, &pData, &Size))
+			continue;
+		json_value *pJson = json_parse((const char *)pData, Size);
+		free(pData);
+		if(!pJson)
+			continue;
+
+		const json_value &rTranslation = (*pJson)["translation"];
+		for(unsigned j = 0; j < rTranslation.u.array.length; j++)
+		{
+			const char *pKey = rTranslation[j]["key"];
+			const char *pValue = rTranslation[j]["value"];
+			const char *pOne = rTranslation[j]["one"];
+			const char *pOther = rTranslation[j]["other"];
+			if(!pKey || !pKey[0])
+				continue;
+			if(pValue && pValue[0])
+				File.m_Values[pKey] = pValue;
+			else if(pOne && pOne[0] && pOther && pOther[0])
+				File.m_OneAndOther[pKey] = {pOne, pOther};
+		}
+		json_value_free(pJson);
+		vFiles.push_back(File);
+	}
+	json_value_free(pIndex);
+	return vFiles;
+}
+
+class CTestLocalization
+{
+public:
+	std::unique_ptr<IStorage> m_pStorage;
+	std::unique_ptr<CLocalization> m_pLocalization;
+
+	CTestLocalization()
+	{
+		m_pStorage.reset(CreateTempStorage("data"));
+		m_pLocalization = std::make_unique<CLocalization>(m_pStorage.get());
+		m_pLocalization->InitConfig(0, nullptr);
+		m_pLocalization->Init();
+	}
+};
+
+}
+
+TEST(Localization, MatchesLanguageFiles)
+{
+	CTestLocalization Test;
+	const std::vector<CLanguageFile> vFiles = ReadLanguageFiles(Test.m_pStorage.get());
+	if(vFiles.empty())
+		GTEST_SKIP() << "no languages in data/languages";
+
+	EXPECT_GT(Test.m_pLocalization->NumKeys(), 0);
+	for(const CLanguageFile &File : vFiles)
+	{
+		const char *pCode = File.m_Code.c_str();
+		for(const auto &[Key, Value] : File.m_Values)
+			EXPECT_STREQ(Test.m_pLocalization->Localize(pCode, Key.c_str()), Value.c_str()) << pCode << ": " << Key;
+		for(const auto &[Key, Values] : File.m_OneAndOther)
+		{
+			// the plural rules of the languages differ, compare the forms
+			// which are the same in all of them
+			if(File.m_Code == "fr" || File.m_Code == "de" || File.m_Code == "es" || File.m_Code == "it")
+			{
+				EXPECT_STREQ(Test.m_pLocalization->Localize_P(pCode, 1, Key.c_str()), Values.first.c_str()) << pCode << ": " << Key;
+				EXPECT_STREQ(Test.m_pLocalization->Localize_P(pCode, 5, Key.c_str()), Values.second.c_str()) << pCode << ": " << Key;
+			}
+		}
+	}
+}
+
+TEST(Localization, Fallbacks)
+{
+	CTestLocalization Test;
+	const std::vector<CLanguageFile> vFiles = ReadLanguageFiles(Test.m_pStorage.get());
+	if(vFiles.empty())
+		GTEST_SKIP() << "no languages in data/languages";
+
+	// unknown keys and languages without a translation give back the key
+	const char *pUnknown = "This text is not translated anywhere";
+	EXPECT_EQ(Test.m_pLocalization->Localize("fr", pUnknown), pUnknown);
+	EXPECT_EQ(Test.m_pLocalization->Localize_P("fr", 2, pUnknown), pUnknown);
+
+	const std::string &Key = vFiles.back().m_Values.empty() ? std::string() : vFiles.back().m_Values.begin()->first;
+	if(Key.empty())
+		return;
+	// "en" has no translation file, and unknown codes use the main language
+	EXPECT_STREQ(Test.m_pLocalization->Localize("en", Key.c_str()), Key.c_str());
+	EXPECT_STREQ(Test.m_pLocalization->Localize("xx", Key.c_str()), Key.c_str());
+	EXPECT_STREQ(Test.m_pLocalization->Localize(nullptr, Key.c_str()), Key.c_str());
+
+	// the keys do not have to be the same pointer as the ones interned
+	const std::string Copy = Key;
+	EXPECT_STREQ(Test.m_pLocalization->Localize(vFiles.back().m_Code.c_str(), Copy.c_str()), vFiles.back().m_Values.begin()->second.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,299 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The connection part of CNetClient, without the STUN support
+class CTestClient
+{
+public:
+	NETSOCKET m_Socket = nullptr;
+	CNetConnection m_Connection;
+	CNetPacketConstruct m_Packet;
+
+	bool Open(NETADDR BindAddr)
+	{
+		m_Socket = net_udp_create(BindAddr);
+		if(!m_Socket)
+			return false;
+		m_Connection.Init(m_Socket, false);
+		return true;
+	}
+
+	void Close()
+	{
+		if(m_Socket)
+			net_udp_close(m_Socket);
+		m_Socket = nullptr;
+	}
+
+	bool Online() const { return m_Connection.State() == NET_CONNSTATE_ONLINE; }
+
+	void Pump()
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		while((Bytes = net_udp_recv(m_Socket, &Addr, &pData)) > 0)
+		{
+			bool Sixup = false;
+			if(CNetBase::UnpackPacket(pData, Bytes, &m_Packet, Sixup) == 0 &&
+				!(m_Packet.m_Flags & NET_PACKETFLAG_CONNLESS) &&
+				m_Connection.State() != NET_CONNSTATE_OFFLINE && m_Connection.State() != NET_CONNSTATE_ERROR)
+				m_Connection.Feed(&m_Packet, &Addr);
+		}
+		m_Connection.Update();
+	}
+
+	void Send(const void *pData, int DataSize)
+	{
+		m_Connection.QueueChunk(0, DataSize, pData);
+		m_Connection.Flush();
+	}
+};
+
+// A server and a set of clients talking over the loopback interface
+class CLoopback
+{
+public:
+	CNetServer m_Server;
+	NETADDR m_ServerAddr;
+	std::vector<std::unique_ptr<CTestClient>> m_vpClients;
+	int m_NumNewClients = 0;
+
+	static int NewClient(int ClientId, void *pUser, bool Sixup)
+	{
+		static_cast<CLoopback *>(pUser)->m_NumNewClients++;
+		return 0;
+	}
+	static int NewClientNoAuth(int ClientId, void *pUser) { return NewClient(ClientId, pUser, false); }
+	static int ClientRejoin(int ClientId, void *pUser) { return 0; }
+	static int DelClient(int ClientId, EClientDropType Type, const char *pReason, void *pUser) { return 0; }
+
+	~CLoopback()
+	{
+		for(auto &pClient : m_vpClients)
+			pClient->Close();
+		m_Server.Close();
+	}
+
+	bool Open()
+	{
+		if(secure_random_init() != 0)
+			return false;
+		CNetBase::Init();
+		g_Config.m_ConnTimeout = 100;
+
+		mem_zero(&m_ServerAddr, sizeof(m_ServerAddr));
+		net_addr_from_str(&m_ServerAddr, "127.0.0.1");
+		for(int Port = 18400; Port < 18500; Port++)
+		{
+			m_ServerAddr.port = Port;
+			if(m_Server.Open(m_ServerAddr, nullptr, NET_MAX_CLIENTS, NET_MAX_CLIENTS))
+			{
+				m_Server.SetCallbacks(NewClient, NewClientNoAuth, ClientRejoin, DelClient, this);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Drains the packets of the server, storing the client indices
+	// received from each slot
+	void Pump(std::vector<int> *pIndices = nullptr)
+	{
+		CNetChunk Chunk;
+		SECURITY_TOKEN ResponseToken;
+		while(m_Server.Recv(&Chunk, &ResponseToken))
+		{
+			if(pIndices && Chunk.m_ClientId >= 0 && Chunk.m_DataSize == sizeof(int))
+				mem_copy(&(*pIndices)[Chunk.m_ClientId], Chunk.m_pData, sizeof(int));
+		}
+		m_Server.Update();
+		m_Server.Flush();
+		for(auto &pClient : m_vpClients)
+			pClient->Pump();
+	}
+
+	// Connects new clients and waits until the server accepted them
+	bool Connect(int NumClients)
+	{
+		NETADDR BindAddr;
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		net_addr_from_str(&BindAddr, "127.0.0.1");
+		BindAddr.port = 0;
+
+		const int Expected = m_NumNewClients + NumClients;
+		for(int i = 0; i < NumClients; i++)
+		{
+			std::unique_ptr<CTestClient> pClient = std::make_unique<CTestClient>();
+			if(!pClient->Open(BindAddr))
+				return false;
+			pClient->m_Connection.Connect(&m_ServerAddr, 1);
+			m_vpClients.push_back(std::move(pClient));
+		}
+
+		const int64_t Deadline = time_get() + time_freq() * 5;
+		while(m_NumNewClients < Expected && time_get() < Deadline)
+		{
+			Pump();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		return m_NumNewClients == Expected;
+	}
+
+	// Every client sends its index, returns the index per server slot
+	std::vector<int> IdentifyClients()
+	{
+		std::vector<int> vIndices(NET_MAX_CLIENTS, -1);
+		for(int i = 0; i < (int)m_vpClients.size(); i++)
+		{
+			if(m_vpClients[i]->Online())
+				m_vpClients[i]->Send(&i, sizeof(i));
+		}
+
+		const int64_t Deadline = time_get() + time_freq();
+		while(time_get() < Deadline)
+		{
+			Pump(&vIndices);
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		return vIndices;
+	}
+};
+
+}
+
+TEST(NetServer, ClientSlotLookup)
+{
+	CLoopback Loopback;
+	if(!Loopback.Open())
+		GTEST_SKIP() << "unable to open a loopback server";
+	ASSERT_TRUE(Loopback.Connect(NET_MAX_CLIENTS));
+
+	// The packets of every client are received on a slot of their own
+	const std::vector<int> vIndices = Loopback.IdentifyClients();
+	std::vector<bool> vSeen(NET_MAX_CLIENTS, false);
+	for(int Slot = 0; Slot < NET_MAX_CLIENTS; Slot++)
+	{
+		ASSERT_GE(vIndices[Slot], 0) << "slot " << Slot;
+		EXPECT_FALSE(vSeen[vIndices[Slot]]);
+		vSeen[vIndices[Slot]] = true;
+	}
+
+	// Dropped slots are reused by new clients, the others keep their client
+	int NumDropped = 0;
+	for(int Slot = 3; Slot < NET_MAX_CLIENTS; Slot += 8)
+	{
+		Loopback.m_Server.Drop(Slot, EClientDropType::Kick, "test");
+		NumDropped++;
+	}
+
+	ASSERT_TRUE(Loopback.Connect(NumDropped));
+	const std::vector<int> vNewIndices = Loopback.IdentifyClients();
+	for(int Slot = 0; Slot < NET_MAX_CLIENTS; Slot++)
+	{
+		if(Slot % 8 == 3)
+			EXPECT_GE(vNewIndices[Slot], NET_MAX_CLIENTS) << "slot " << Slot;
+		else
+			EXPECT_EQ(vNewIndices[Slot], vIndices[Slot]) << "slot " << Slot;
+	}
+}
+
+TEST(NetServer, BatchedUdpSend)
+{
+	NETADDR Addr;
+	mem_zero(&Addr, sizeof(Addr));
+	net_addr_from_str(&Addr, "127.0.0.1");
+
+	NETSOCKET Receiver = nullptr;
+	NETADDR ReceiverAddr = Addr;
+	for(int Port = 18500; Port < 18600 && !Receiver; Port++)
+	{
+		ReceiverAddr.port = Port;
+		Receiver = net_udp_create(ReceiverAddr);
+	}
+	if(!Receiver)
+		GTEST_SKIP() << "unable to open a loopback socket";
+	NETSOCKET Sender = net_udp_create(Addr);
+	ASSERT_TRUE(Sender);
+	net_udp_set_batching(Sender, true);
+
+	auto Receive = [&]() {
+		std::vector<int> vReceived;
+		const int64_t Deadline = time_get() + time_freq() / 10;
+		while(time_get() < Deadline)
+		{
+			NETADDR From;
+			unsigned char *pData;
+			int Bytes;
+			while((Bytes = net_udp_recv(Receiver, &From, &pData)) > 0)
+			{
+				int Value;
+				mem_copy(&Value, pData, sizeof(Value));
+				vReceived.push_back(Value);
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		return vReceived;
+	};
+
+	NETSTATS Stats;
+	net_stats(&Stats);
+	const uint64_t SendCalls = Stats.send_calls;
+
+	// The queue is sent when full, the rest waits for the flush
+	unsigned char aPacket[2000] = {0};
+	for(int i = 0; i < 130; i++)
+	{
+		mem_copy(aPacket, &i, sizeof(i));
+		EXPECT_EQ(net_udp_send(Sender, &ReceiverAddr, aPacket, 64), 64);
+	}
+	std::vector<int> vReceived = Receive();
+	net_udp_flush(Sender);
+	std::vector<int> vRest = Receive();
+#if defined(CONF_PLATFORM_LINUX)
+	EXPECT_EQ(vReceived.size(), 128u);
+	net_stats(&Stats);
+	EXPECT_EQ(Stats.send_calls - SendCalls, 2u);
+#endif
+	vReceived.insert(vReceived.end(), vRest.begin(), vRest.end());
+	ASSERT_EQ(vReceived.size(), 130u);
+	for(int i = 0; i < 130; i++)
+		EXPECT_EQ(vReceived[i], i);
+
+	// Packets too large for the queue do not overtake the queued ones
+	for(int i = 0; i < 3; i++)
+	{
+		mem_copy(aPacket, &i, sizeof(i));
+		net_udp_send(Sender, &ReceiverAddr, aPacket, 64);
+	}
+	const int Large = 3;
+	mem_copy(aPacket, &Large, sizeof(Large));
+	net_udp_send(Sender, &ReceiverAddr, aPacket, sizeof(aPacket));
+	EXPECT_EQ(Receive(), std::vector<int>({0, 1, 2, 3}));
+
+	// Closing the socket sends the queue
+	net_udp_send(Sender, &ReceiverAddr, aPacket, 64);
+	net_udp_close(Sender);
+	EXPECT_EQ(Receive().size(), 1u);
+
+	net_udp_close(Receiver);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/profiler.h>
+
+TEST(Profiler, StatsOfTheWindow)
+{
+	CProfiler::SetEnabled(true);
+	CProfiler::CZone *pZone = CProfiler::Zone("test/window");
+	EXPECT_EQ(CProfiler::Zone("test/window"), pZone);
+
+	// two calls in each tick, the sums go from 2 to 200 us
+	for(int Tick = 1; Tick <= 100; Tick++)
+	{
+		pZone->Add(Tick * 1000);
+		pZone->Add(Tick * 1000);
+		CProfiler::EndTick();
+	}
+
+	CProfiler::CStats Stats;
+	ASSERT_TRUE(CProfiler::GetStats(pZone, &Stats));
+	EXPECT_EQ(Stats.m_NumTicks, 100);
+	EXPECT_FLOAT_EQ(Stats.m_CallsPerTick, 2.0f);
+	EXPECT_EQ(Stats.m_Median, 100000);
+	EXPECT_EQ(Stats.m_Percentile99, 198000);
+	EXPECT_EQ(Stats.m_Max, 200000);
+
+	char aBuf[256];
+	CProfiler::FormatStats(pZone, Stats, aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "test/window: p50 100.0us p99 198.0us max 200.0us, 2.0 calls/tick over 100 ticks");
+
+	// the ticks the zone is not entered in are not part of its window
+	CProfiler::EndTick();
+	ASSERT_TRUE(CProfiler::GetStats(pZone, &Stats));
+	EXPECT_EQ(Stats.m_NumTicks, 100);
+
+	CProfiler::Reset();
+	EXPECT_FALSE(CProfiler::GetStats(pZone, &Stats));
+	CProfiler::SetEnabled(false);
+}
+
+TEST(Profiler, WindowWrapsAround)
+{
+	CProfiler::SetEnabled(true);
+	CProfiler::CZone *pZone = CProfiler::Zone("test/wrap");
+	for(int Tick = 0; Tick < CProfiler::WINDOW_TICKS; Tick++)
+	{
+		pZone->Add(1000000);
+		CProfiler::EndTick();
+	}
+	for(int Tick = 0; Tick < CProfiler::WINDOW_TICKS; Tick++)
+	{
+		pZone->Add(1000);
+		CProfiler::EndTick();
+	}
+
+	CProfiler::CStats Stats;
+	ASSERT_TRUE(CProfiler::GetStats(pZone, &Stats));
+	EXPECT_EQ(Stats.m_NumTicks, (int)CProfiler::WINDOW_TICKS);
+	EXPECT_EQ(Stats.m_Max, 1000);
+	CProfiler::SetEnabled(false);
+}
+
+TEST(Profiler, DisabledScopesDoNotRecord)
+{
+	CProfiler::SetEnabled(false);
+	CProfiler::CZone *pZone = CProfiler::Zone("test/disabled");
+	{
+		CProfileScope Scope(pZone);
+	}
+	CProfiler::SetEnabled(true);
+	CProfiler::EndTick();
+
+	CProfiler::CStats Stats;
+	EXPECT_FALSE(CProfiler::GetStats(pZone, &Stats));
+
+	{
+		CProfileScope Scope(pZone);
+	}
+	CProfiler::EndTick();
+	ASSERT_TRUE(CProfiler::GetStats(pZone, &Stats));
+	EXPECT_EQ(Stats.m_NumTicks, 1);
+	EXPECT_GE(Stats.m_Max, 0);
+	CProfiler::SetEnabled(false);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
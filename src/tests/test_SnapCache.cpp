@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/server.h>
+#include <engine/shared/snapshot.h>
+#include <game/server/gamecontext.h>
+#include <game/server/gameworld.h>
+#include <game/server/infclass/entities/infcentity.h>
+#include <tests/test_server.h>
+
+#include <vector>
+
+namespace {
+
+std::vector<char> FinishSnapshot(CServer *pServer)
+{
+	std::vector<char> vData(CSnapshot::MAX_SIZE);
+	vData.resize(pServer->m_SnapshotBuilder.Finish(vData.data()));
+	return vData;
+}
+
+// Adds the item, its data is only written after it was added like the
+// entities do
+void AddItem(CServer *pServer, int Type, int Id, int Size, int Seed)
+{
+	int *pData = static_cast<int *>(pServer->SnapNewItem(Type, Id, Size));
+	ASSERT_TRUE(pData);
+	for(int i = 0; i < Size / (int)sizeof(int); i++)
+		pData[i] = Seed * 1000 + i;
+}
+
+class CTestEntity : public CInfCEntity
+{
+public:
+	int m_NumSnaps = 0;
+	int m_Variant = 0;
+
+	CTestEntity(CGameContext *pGameContext) :
+		CInfCEntity(pGameContext, CGameWorld::ENTTYPE_LOOPER_WALL)
+	{
+		GameWorld()->InsertEntity(this);
+	}
+
+	void Snap(int SnappingClient) override
+	{
+		SnapCached(SnappingClient, m_Variant, [&]() {
+			m_NumSnaps++;
+			int *pData = static_cast<int *>(Server()->SnapNewItem(1, GetId(), 2 * sizeof(int)));
+			if(!pData)
+				return;
+			pData[0] = m_Variant;
+			pData[1] = m_NumSnaps;
+		});
+	}
+};
+
+}
+
+TEST(SnapCache, ReplayMatchesRecordedItems)
+{
+	CTestServer Test;
+	CServer *pServer = Test.m_pServer;
+
+	// the items before and after the recording are not part of it
+	pServer->m_SnapshotBuilder.Init();
+	AddItem(pServer, 3, 1, 8, 1);
+	pServer->SnapStartRecording();
+	AddItem(pServer, 1, 10, 16, 2);
+	AddItem(pServer, 2, 11, 4, 3);
+	AddItem(pServer, 1, 12, 0, 4);
+	AddItem(pServer, 5, 13, 40, 5);
+	std::vector<int> vRecording;
+	pServer->SnapStopRecording(&vRecording);
+	AddItem(pServer, 3, 2, 8, 6);
+	const std::vector<char> vRecorded = FinishSnapshot(pServer);
+
+	pServer->m_SnapshotBuilder.Init();
+	AddItem(pServer, 3, 1, 8, 1);
+	EXPECT_TRUE(pServer->SnapReplayItems(vRecording));
+	AddItem(pServer, 3, 2, 8, 6);
+	const std::vector<char> vReplayed = FinishSnapshot(pServer);
+
+	EXPECT_EQ(vReplayed, vRecorded);
+
+	// replayed alone, only the recorded items are in the snapshot
+	pServer->m_SnapshotBuilder.Init();
+	EXPECT_TRUE(pServer->SnapReplayItems(vRecording));
+	const std::vector<char> vAlone = FinishSnapshot(pServer);
+	const CSnapshot *pAlone = reinterpret_cast<const CSnapshot *>(vAlone.data());
+	ASSERT_EQ(pAlone->NumItems(), 4);
+	const int *pItem = static_cast<const int *>(pAlone->FindItem(5, 13));
+	ASSERT_TRUE(pItem);
+	EXPECT_EQ(pItem[9], 5009);
+	EXPECT_FALSE(pAlone->FindItem(3, 1));
+}
+
+TEST(SnapCache, ReplaysForSameKey)
+{
+	CTestServer Test;
+	CServer *pServer = Test.m_pServer;
+	CTestEntity *pEnt = new CTestEntity(Test.m_pGameContext);
+
+	// two clients with the same versions get the items of one snap
+	pServer->m_SnapshotBuilder.Init();
+	pEnt->Snap(0);
+	const std::vector<char> vFirst = FinishSnapshot(pServer);
+	pServer->m_SnapshotBuilder.Init();
+	pEnt->Snap(1);
+	const std::vector<char> vSecond = FinishSnapshot(pServer);
+	EXPECT_EQ(pEnt->m_NumSnaps, 1);
+	EXPECT_EQ(vSecond, vFirst);
+	const CSnapshot *pSecond = reinterpret_cast<const CSnapshot *>(vSecond.data());
+	ASSERT_EQ(pSecond->NumItems(), 1);
+	EXPECT_EQ(static_cast<const int *>(pSecond->FindItem(1, pEnt->GetId()))[1], 1);
+
+	// another variant is snapped again
+	pEnt->m_Variant = 1;
+	pServer->m_SnapshotBuilder.Init();
+	pEnt->Snap(2);
+	const std::vector<char> vOther = FinishSnapshot(pServer);
+	EXPECT_EQ(pEnt->m_NumSnaps, 2);
+	EXPECT_NE(vOther, vFirst);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,482 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Reference copy of the hash list based CreateDelta, the optimized one must
+// produce the exact same deltas.
+class CReferenceDelta
+{
+	enum
+	{
+		HASHLIST_SIZE = 256,
+		HASHLIST_BUCKET_SIZE = 64,
+		MAX_NETOBJSIZES = 64,
+	};
+
+	struct CItemList
+	{
+		int m_Num;
+		int m_aKeys[HASHLIST_BUCKET_SIZE];
+		int m_aIndex[HASHLIST_BUCKET_SIZE];
+	};
+
+	static size_t CalcHashId(int Key)
+	{
+		unsigned Hash = 5381;
+		for(unsigned Shift = 0; Shift < sizeof(int); Shift++)
+			Hash = ((Hash << 5) + Hash) + ((Key >> (Shift * 8)) & 0xFF);
+		return Hash % HASHLIST_SIZE;
+	}
+
+	static void GenerateHash(CItemList *pHashlist, const CSnapshot *pSnapshot)
+	{
+		for(int i = 0; i < HASHLIST_SIZE; i++)
+			pHashlist[i].m_Num = 0;
+
+		for(int i = 0; i < pSnapshot->NumItems(); i++)
+		{
+			int Key = pSnapshot->GetItem(i)->Key();
+			size_t HashId = CalcHashId(Key);
+			if(pHashlist[HashId].m_Num < HASHLIST_BUCKET_SIZE)
+			{
+				pHashlist[HashId].m_aIndex[pHashlist[HashId].m_Num] = i;
+				pHashlist[HashId].m_aKeys[pHashlist[HashId].m_Num] = Key;
+				pHashlist[HashId].m_Num++;
+			}
+		}
+	}
+
+	static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
+	{
+		size_t HashId = CalcHashId(Key);
+		for(int i = 0; i < pHashlist[HashId].m_Num; i++)
+		{
+			if(pHashlist[HashId].m_aKeys[i] == Key)
+				return pHashlist[HashId].m_aIndex[i];
+		}
+		return -1;
+	}
+
+	static int DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
+	{
+		int Needed = 0;
+		for(int i = 0; i < Size; i++)
+		{
+			pOut[i] = (unsigned)pCurrent[i] - (unsigned)pPast[i];
+			Needed |= pOut[i];
+		}
+		return Needed;
+	}
+
+	short m_aItemSizes[MAX_NETOBJSIZES] = {0};
+
+public:
+	void SetStaticsize(int ItemType, int Size)
+	{
+		if(ItemType >= 0 && ItemType < MAX_NETOBJSIZES)
+			m_aItemSizes[ItemType] = Size;
+	}
+
+	int CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData) const
+	{
+		CSnapshotDelta::CData *pDelta = (CSnapshotDelta::CData *)pDstData;
+		int *pData = (int *)pDelta->m_aData;
+
+		pDelta->m_NumDeletedItems = 0;
+		pDelta->m_NumUpdateItems = 0;
+		pDelta->m_NumTempItems = 0;
+
+		std::vector<CItemList> vHashlist(HASHLIST_SIZE);
+		GenerateHash(vHashlist.data(), pTo);
+
+		for(int i = 0; i < pFrom->NumItems(); i++)
+		{
+			const CSnapshotItem *pFromItem = pFrom->GetItem(i);
+			if(GetItemIndexHashed(pFromItem->Key(), vHashlist.data()) == -1)
+			{
+				pDelta->m_NumDeletedItems++;
+				*pData = pFromItem->Key();
+				pData++;
+			}
+		}
+
+		GenerateHash(vHashlist.data(), pFrom);
+
+		for(int i = 0; i < pTo->NumItems(); i++)
+		{
+			const int ItemSize = pTo->GetItemSize(i);
+			const CSnapshotItem *pCurItem = pTo->GetItem(i);
+			const int PastIndex = GetItemIndexHashed(pCurItem->Key(), vHashlist.data());
+			const bool IncludeSize = pCurItem->Type() >= MAX_NETOBJSIZES || !m_aItemSizes[pCurItem->Type()];
+
+			if(PastIndex != -1)
+			{
+				int *pItemDataDst = IncludeSize ? pData + 3 : pData + 2;
+				const CSnapshotItem *pPastItem = pFrom->GetItem(PastIndex);
+				if(DiffItem(pPastItem->Data(), pCurItem->Data(), pItemDataDst, ItemSize / sizeof(int32_t)))
+				{
+					*pData++ = pCurItem->Type();
+					*pData++ = pCurItem->Id();
+					if(IncludeSize)
+						*pData++ = ItemSize / sizeof(int32_t);
+					pData += ItemSize / sizeof(int32_t);
+					pDelta->m_NumUpdateItems++;
+				}
+			}
+			else
+			{
+				*pData++ = pCurItem->Type();
+				*pData++ = pCurItem->Id();
+				if(IncludeSize)
+					*pData++ = ItemSize / sizeof(int32_t);
+				mem_copy(pData, pCurItem->Data(), ItemSize);
+				pData += ItemSize / sizeof(int32_t);
+				pDelta->m_NumUpdateItems++;
+			}
+		}
+
+		if(!pDelta->m_NumDeletedItems && !pDelta->m_NumUpdateItems && !pDelta->m_NumTempItems)
+			return 0;
+
+		return (int)((char *)pData - (char *)pDstData);
+	}
+};
+
+struct CTestItem
+{
+	int m_Type;
+	int m_Id;
+	std::vector<int> m_vData;
+};
+
+struct CTestSnapshot
+{
+	std::vector<char> m_vData = std::vector<char>(CSnapshot::MAX_SIZE);
+	int m_Size = 0;
+
+	const CSnapshot *Get() const { return (const CSnapshot *)m_vData.data(); }
+};
+
+void BuildSnapshot(const std::vector<CTestItem> &vItems, CTestSnapshot *pSnapshot)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(const CTestItem &Item : vItems)
+	{
+		void *pData = Builder.NewItem(Item.m_Type, Item.m_Id, Item.m_vData.size() * sizeof(int));
+		ASSERT_NE(pData, nullptr);
+		mem_copy(pData, Item.m_vData.data(), Item.m_vData.size() * sizeof(int));
+	}
+	pSnapshot->m_Size = Builder.Finish(pSnapshot->m_vData.data());
+}
+
+// Static sizes of the item types used by the tests, 0 if not static
+int StaticSize(int Type)
+{
+	return Type % 3 == 0 ? 0 : 2 + Type % 7;
+}
+
+CTestItem RandomItem(std::mt19937 &Rng, int MaxId)
+{
+	CTestItem Item;
+	Item.m_Type = 1 + Rng() % 70;
+	Item.m_Id = Rng() % (MaxId + 1);
+	const int Size = StaticSize(Item.m_Type) ? StaticSize(Item.m_Type) : Rng() % 12;
+	for(int i = 0; i < Size; i++)
+		Item.m_vData.push_back(Rng() % 3 == 0 ? (int)Rng() : (int)(Rng() % 100) - 50);
+	return Item;
+}
+
+// Moves the items around, the same way entities spawn, move and disappear
+// between two ticks. Resized items can not be unpacked, the delta keeps
+// the size of the previous item.
+std::vector<CTestItem> NextTick(std::mt19937 &Rng, std::vector<CTestItem> vItems, int MaxId, bool Resize = true)
+{
+	std::vector<CTestItem> vNext;
+	for(CTestItem &Item : vItems)
+	{
+		switch(Rng() % 8)
+		{
+		case 0:
+			break; // removed
+		case 1:
+		case 2:
+			for(int &Value : Item.m_vData)
+				if(Rng() % 2)
+					Value += (int)(Rng() % 20) - 10;
+			vNext.push_back(Item);
+			break;
+		case 3:
+			if(Resize && !StaticSize(Item.m_Type))
+				Item.m_vData.push_back(Rng());
+			vNext.push_back(Item);
+			break;
+		default:
+			vNext.push_back(Item);
+			break;
+		}
+		if(Rng() % 10 == 0)
+			vNext.push_back(RandomItem(Rng, MaxId));
+	}
+	if(vNext.size() > 1 && Rng() % 4 == 0)
+		std::swap(vNext[Rng() % vNext.size()], vNext[Rng() % vNext.size()]);
+	return vNext;
+}
+
+// Snapshots created by the server never contain the same key twice
+std::vector<CTestItem> UniqueKeys(std::vector<CTestItem> vItems)
+{
+	std::vector<CTestItem> vUnique;
+	std::vector<int> vKeys;
+	for(CTestItem &Item : vItems)
+	{
+		const int Key = (Item.m_Type << 16) | Item.m_Id;
+		if(std::find(vKeys.begin(), vKeys.end(), Key) == vKeys.end())
+		{
+			vKeys.push_back(Key);
+			vUnique.push_back(std::move(Item));
+		}
+	}
+	return vUnique;
+}
+
+void ExpectSameDelta(const CSnapshotDelta &Delta, const CReferenceDelta &Reference, const CTestSnapshot &From, const CTestSnapshot &To)
+{
+	std::vector<char> vDelta(CSnapshot::MAX_SIZE * 2);
+	std::vector<char> vExpected(CSnapshot::MAX_SIZE * 2);
+	const int Size = Delta.CreateDelta(From.Get(), To.Get(), vDelta.data());
+	const int ExpectedSize = Reference.CreateDelta(From.Get(), To.Get(), vExpected.data());
+	ASSERT_EQ(Size, ExpectedSize);
+	EXPECT_EQ(mem_comp(vDelta.data(), vExpected.data(), maximum(Size, (int)(3 * sizeof(int)))), 0);
+}
+
+void SetStaticSizes(CSnapshotDelta *pDelta, CReferenceDelta *pReference)
+{
+	for(int Type = 0; Type < 64; Type++)
+	{
+		pDelta->SetStaticsize(Type, StaticSize(Type) * sizeof(int));
+		pReference->SetStaticsize(Type, StaticSize(Type) * sizeof(int));
+	}
+}
+
+}
+
+TEST(SnapshotDelta, MatchesReference)
+{
+	CSnapshotDelta Delta;
+	CReferenceDelta Reference;
+	SetStaticSizes(&Delta, &Reference);
+
+	std::mt19937 Rng(1337);
+	CTestSnapshot From;
+	CTestSnapshot To;
+	for(int Round = 0; Round < 300; Round++)
+	{
+		// small ids like the client ids and large ones like recycled snap ids
+		const int MaxId = Round % 2 ? 63 : 0xffff;
+		const int NumItems = Rng() % 400;
+		std::vector<CTestItem> vItems;
+		for(int i = 0; i < NumItems; i++)
+			vItems.push_back(RandomItem(Rng, MaxId));
+
+		BuildSnapshot(vItems, &From);
+		for(int Tick = 0; Tick < 5; Tick++)
+		{
+			vItems = NextTick(Rng, vItems, MaxId);
+			BuildSnapshot(vItems, &To);
+			ExpectSameDelta(Delta, Reference, From, To);
+			ExpectSameDelta(Delta, Reference, To, To);
+			std::swap(From, To);
+		}
+	}
+
+	// from and to the empty snapshot
+	CTestSnapshot Empty;
+	BuildSnapshot({}, &Empty);
+	ExpectSameDelta(Delta, Reference, Empty, From);
+	ExpectSameDelta(Delta, Reference, From, Empty);
+}
+
+TEST(SnapshotDelta, MatchesReferenceWithHashlistOverflow)
+{
+	CSnapshotDelta Delta;
+	CReferenceDelta Reference;
+	SetStaticSizes(&Delta, &Reference);
+
+	// the djb2 bucket only depends on the low byte of the id for a fixed
+	// type and id high byte, so one id per high byte fills a single bucket
+	std::mt19937 Rng(99);
+	std::vector<CTestItem> vItems;
+	for(int High = 0; High < 100; High++)
+	{
+		for(int Low = 0; Low < 256; Low++)
+		{
+			const int Key = (7 << 16) | (High << 8) | Low;
+			unsigned Hash = 5381;
+			for(unsigned Shift = 0; Shift < sizeof(int); Shift++)
+				Hash = ((Hash << 5) + Hash) + ((Key >> (Shift * 8)) & 0xFF);
+			if(Hash % 256 == 0)
+			{
+				vItems.push_back({7, (High << 8) | Low, {High, Low}});
+				break;
+			}
+		}
+	}
+	for(int i = 0; i < 50; i++)
+		vItems.push_back(RandomItem(Rng, 0xffff));
+
+	CTestSnapshot From;
+	CTestSnapshot To;
+	BuildSnapshot(vItems, &From);
+	for(int Tick = 0; Tick < 20; Tick++)
+	{
+		vItems = NextTick(Rng, vItems, 0xffff);
+		BuildSnapshot(vItems, &To);
+		ExpectSameDelta(Delta, Reference, From, To);
+		std::swap(From, To);
+	}
+}
+
+TEST(SnapshotDelta, UnpackRoundTrip)
+{
+	CSnapshotDelta Delta;
+	CReferenceDelta Reference;
+	SetStaticSizes(&Delta, &Reference);
+
+	std::mt19937 Rng(4242);
+	std::vector<CTestItem> vItems;
+	for(int i = 0; i < 200; i++)
+		vItems.push_back(RandomItem(Rng, 0xffff));
+
+	vItems = UniqueKeys(vItems);
+
+	CTestSnapshot From;
+	CTestSnapshot To;
+	BuildSnapshot(vItems, &From);
+	std::vector<char> vDelta(CSnapshot::MAX_SIZE * 2);
+	std::vector<char> vUnpacked(CSnapshot::MAX_SIZE);
+	for(int Tick = 0; Tick < 50; Tick++)
+	{
+		vItems = UniqueKeys(NextTick(Rng, vItems, 0xffff, false));
+		BuildSnapshot(vItems, &To);
+
+		const int DeltaSize = Delta.CreateDelta(From.Get(), To.Get(), vDelta.data());
+		if(DeltaSize == 0)
+			continue;
+		const int UnpackedSize = Delta.UnpackDelta(From.Get(), (CSnapshot *)vUnpacked.data(), vDelta.data(), DeltaSize);
+		ASSERT_EQ(UnpackedSize, To.m_Size);
+
+		// the unpacked snapshot has the items in another order
+		const CSnapshot *pUnpacked = (const CSnapshot *)vUnpacked.data();
+		ASSERT_EQ(pUnpacked->NumItems(), To.Get()->NumItems());
+		for(int i = 0; i < To.Get()->NumItems(); i++)
+		{
+			const CSnapshotItem *pItem = To.Get()->GetItem(i);
+			const int Index = pUnpacked->GetItemIndex(pItem->Key());
+			ASSERT_GE(Index, 0);
+			ASSERT_EQ(pUnpacked->GetItemSize(Index), To.Get()->GetItemSize(i));
+			EXPECT_EQ(mem_comp(pUnpacked->GetItem(Index)->Data(), pItem->Data(), To.Get()->GetItemSize(i)), 0);
+		}
+
+		std::swap(From, To);
+	}
+}
+
+TEST(SnapshotDelta, UnpackDataRate)
+{
+	// the data rate is the number of bits of the packed diffs
+	const int aPast[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+	const int aCurrent[] = {0, 1, -1, 63, -64, 64, -65, 8191, 1 << 20, 1 << 27, INT_MIN};
+
+	CSnapshotBuilder Builder;
+	std::vector<char> vFrom(CSnapshot::MAX_SIZE);
+	std::vector<char> vTo(CSnapshot::MAX_SIZE);
+	Builder.Init();
+	mem_copy(Builder.NewItem(3, 0, sizeof(aPast)), aPast, sizeof(aPast));
+	Builder.Finish(vFrom.data());
+	Builder.Init();
+	mem_copy(Builder.NewItem(3, 0, sizeof(aCurrent)), aCurrent, sizeof(aCurrent));
+	Builder.Finish(vTo.data());
+
+	int ExpectedRate = 0;
+	for(int Value : aCurrent)
+	{
+		if(Value == 0)
+		{
+			ExpectedRate += 1;
+		}
+		else
+		{
+			unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+			ExpectedRate += (CVariableInt::Pack(aBuf, Value, sizeof(aBuf)) - aBuf) * 8;
+		}
+	}
+
+	CSnapshotDelta Delta;
+	std::vector<char> vDelta(CSnapshot::MAX_SIZE * 2);
+	std::vector<char> vUnpacked(CSnapshot::MAX_SIZE);
+	const int DeltaSize = Delta.CreateDelta((const CSnapshot *)vFrom.data(), (const CSnapshot *)vTo.data(), vDelta.data());
+	ASSERT_GT(Delta.UnpackDelta((const CSnapshot *)vFrom.data(), (CSnapshot *)vUnpacked.data(), vDelta.data(), DeltaSize), 0);
+	EXPECT_EQ(Delta.GetDataRate(3), ExpectedRate);
+	EXPECT_EQ(Delta.GetDataUpdates(3), 1);
+}
+
+// Run with --gtest_also_run_disabled_tests to compare the delta creation
+// time with the reference implementation.
+TEST(SnapshotDelta, DISABLED_CreateDeltaCost)
+{
+	CSnapshotDelta Delta;
+	CReferenceDelta Reference;
+	SetStaticSizes(&Delta, &Reference);
+	std::vector<char> vDelta(CSnapshot::MAX_SIZE * 2);
+	const int NumRuns = 2000;
+
+	for(int NumItems : {32, 128, 256, 512, 900})
+	{
+		std::mt19937 Rng(NumItems);
+		std::vector<CTestItem> vItems;
+		for(int i = 0; i < NumItems; i++)
+			vItems.push_back(RandomItem(Rng, 4095));
+
+		CTestSnapshot From;
+		CTestSnapshot To;
+		BuildSnapshot(vItems, &From);
+		BuildSnapshot(NextTick(Rng, vItems, 4095), &To);
+
+		int64_t Checksum = 0;
+		const int64_t ReferenceStart = time_get();
+		for(int i = 0; i < NumRuns; i++)
+			Checksum += Reference.CreateDelta(From.Get(), To.Get(), vDelta.data());
+		const int64_t ReferenceTime = time_get() - ReferenceStart;
+
+		const int64_t Start = time_get();
+		for(int i = 0; i < NumRuns; i++)
+			Checksum -= Delta.CreateDelta(From.Get(), To.Get(), vDelta.data());
+		const int64_t Time = time_get() - Start;
+
+		EXPECT_EQ(Checksum, 0);
+		std::printf("%4d items: reference %8.2f us/delta, current %8.2f us/delta\n", NumItems,
+			ReferenceTime * 1e6 / time_freq() / NumRuns,
+			Time * 1e6 / time_freq() / NumRuns);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
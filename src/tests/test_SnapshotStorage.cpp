@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/snapshot.h>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct CStoredSnap
+{
+	int m_Tick;
+	std::vector<char> m_vData;
+	std::vector<char> m_vAltData;
+};
+
+std::vector<char> RandomData(std::mt19937 &Rng, int Size)
+{
+	std::vector<char> vData(Size);
+	for(char &c : vData)
+		c = Rng();
+	return vData;
+}
+
+void ExpectStored(CSnapshotStorage &Storage, const std::deque<CStoredSnap> &Expected)
+{
+	int Count = 0;
+	for(const CSnapshotStorage::CHolder *pHolder = Storage.m_pFirst; pHolder; pHolder = pHolder->m_pNext)
+		Count++;
+	ASSERT_EQ(Count, (int)Expected.size());
+
+	for(const CStoredSnap &Snap : Expected)
+	{
+		const CSnapshot *pData = nullptr;
+		const CSnapshot *pAltData = nullptr;
+		int64_t Tagtime = 0;
+		ASSERT_EQ(Storage.Get(Snap.m_Tick, &Tagtime, &pData, &pAltData), (int)Snap.m_vData.size());
+		EXPECT_EQ(Tagtime, Snap.m_Tick * 10);
+		EXPECT_EQ(mem_comp(pData, Snap.m_vData.data(), Snap.m_vData.size()), 0);
+		if(Snap.m_vAltData.empty())
+		{
+			EXPECT_EQ(pAltData, nullptr);
+		}
+		else
+		{
+			ASSERT_NE(pAltData, nullptr);
+			EXPECT_EQ(mem_comp(pAltData, Snap.m_vAltData.data(), Snap.m_vAltData.size()), 0);
+		}
+	}
+}
+
+}
+
+TEST(SnapshotStorage, BaseTest)
+{
+	CSnapshotStorage Storage;
+	EXPECT_EQ(Storage.Get(1, nullptr, nullptr, nullptr), -1);
+
+	char aData[64] = {1, 2, 3};
+	Storage.Add(1, 10, sizeof(aData), aData, 0, nullptr);
+	Storage.Add(2, 20, 16, aData, 8, aData);
+
+	const CSnapshot *pData = nullptr;
+	const CSnapshot *pAltData = nullptr;
+	EXPECT_EQ(Storage.Get(1, nullptr, &pData, &pAltData), (int)sizeof(aData));
+	EXPECT_EQ(pAltData, nullptr);
+	EXPECT_EQ(Storage.Get(2, nullptr, &pData, &pAltData), 16);
+	EXPECT_NE(pAltData, nullptr);
+
+	Storage.PurgeUntil(2);
+	EXPECT_EQ(Storage.Get(1, nullptr, nullptr, nullptr), -1);
+	EXPECT_EQ(Storage.Get(2, nullptr, nullptr, nullptr), 16);
+
+	Storage.PurgeAll();
+	EXPECT_EQ(Storage.m_pFirst, nullptr);
+	EXPECT_EQ(Storage.Get(2, nullptr, nullptr, nullptr), -1);
+}
+
+TEST(SnapshotStorage, RingKeepsHistory)
+{
+	std::mt19937 Rng(7);
+	std::uniform_int_distribution<int> Size(1, 16 * 1024);
+	std::uniform_int_distribution<int> History(1, 150);
+
+	CSnapshotStorage Storage;
+	std::deque<CStoredSnap> Expected;
+
+	int Keep = History(Rng);
+	for(int Tick = 1; Tick < 3000; Tick++)
+	{
+		if(Tick % 500 == 0)
+			Keep = History(Rng);
+
+		while(!Expected.empty() && Expected.front().m_Tick < Tick - Keep)
+			Expected.pop_front();
+		Storage.PurgeUntil(Tick - Keep);
+
+		CStoredSnap Snap;
+		Snap.m_Tick = Tick;
+		Snap.m_vData = RandomData(Rng, Size(Rng) & ~3);
+		if(Rng() % 4 == 0)
+			Snap.m_vAltData = RandomData(Rng, Size(Rng) & ~3);
+		Storage.Add(Tick, Tick * 10, Snap.m_vData.size(), Snap.m_vData.data(),
+			Snap.m_vAltData.size(), Snap.m_vAltData.empty() ? nullptr : Snap.m_vAltData.data());
+		Expected.push_back(std::move(Snap));
+
+		ExpectStored(Storage, Expected);
+		if(HasFatalFailure())
+			return;
+	}
+}
+
+TEST(SnapshotStorage, NoAllocationsInSteadyState)
+{
+	CSnapshotStorage Storage;
+	char aData[4096] = {0};
+
+	// warm up with 3 seconds of history
+	for(int Tick = 0; Tick < 150; Tick++)
+	{
+		Storage.PurgeUntil(Tick - 150);
+		Storage.Add(Tick, 0, sizeof(aData), aData, 0, nullptr);
+	}
+
+	const int64_t Allocations = CSnapshotStorage::NumAllocations();
+	for(int Tick = 150; Tick < 5000; Tick++)
+	{
+		Storage.PurgeUntil(Tick - 150);
+		Storage.Add(Tick, 0, sizeof(aData), aData, 0, nullptr);
+	}
+	EXPECT_EQ(CSnapshotStorage::NumAllocations(), Allocations);
+
+	// the arena is reused after a purge
+	Storage.PurgeAll();
+	Storage.Add(0, 0, sizeof(aData), aData, 0, nullptr);
+	EXPECT_EQ(CSnapshotStorage::NumAllocations(), Allocations);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <base/tl/ic_slab_allocator.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+TEST(IcSlabAllocator, SlotsAreAlignedAndReused)
+{
+	icSlabAllocator Allocator(100, 4, true);
+	EXPECT_EQ(Allocator.SlotSize(), 128u);
+	EXPECT_EQ(Allocator.Capacity(), 0);
+
+	std::vector<void *> vpSlots;
+	for(int i = 0; i < 6; i++)
+	{
+		void *pSlot = Allocator.Allocate();
+		EXPECT_EQ((uintptr_t)pSlot % icSlabAllocator::sAlignment, 0u);
+		for(void *pOther : vpSlots)
+			EXPECT_NE(pSlot, pOther);
+		vpSlots.push_back(pSlot);
+	}
+	EXPECT_EQ(Allocator.NumSlabs(), 2);
+	EXPECT_EQ(Allocator.Capacity(), 8);
+	EXPECT_EQ(Allocator.NumUsed(), 6);
+
+	// the last freed slot is handed out first
+	Allocator.Free(vpSlots[1]);
+	Allocator.Free(vpSlots[4]);
+	EXPECT_EQ(Allocator.NumUsed(), 4);
+	EXPECT_EQ(Allocator.Allocate(), vpSlots[4]);
+	EXPECT_EQ(Allocator.Allocate(), vpSlots[1]);
+
+	EXPECT_EQ(Allocator.NumSlabs(), 2);
+	EXPECT_EQ(Allocator.PeakUsed(), 6);
+	EXPECT_EQ(Allocator.NumAllocations(), 8);
+	Allocator.Free(nullptr);
+	EXPECT_EQ(Allocator.NumUsed(), 6);
+}
+
+TEST(IcSlabAllocator, FreedSlotsArePoisoned)
+{
+	icSlabAllocator Allocator(64, 2, true);
+	unsigned char *pSlot = static_cast<unsigned char *>(Allocator.Allocate());
+	std::memset(pSlot, 0, Allocator.SlotSize());
+	Allocator.Free(pSlot);
+	EXPECT_EQ(pSlot[Allocator.SlotSize() - 1], icSlabAllocator::sPoison);
+	EXPECT_EQ(Allocator.Allocate(), pSlot);
+}
+
+TEST(IcSlabAllocatorDeathTest, WriteAfterFree)
+{
+	icSlabAllocator Allocator(64, 2, true);
+	unsigned char *pSlot = static_cast<unsigned char *>(Allocator.Allocate());
+	Allocator.Free(pSlot);
+	pSlot[40] = 1;
+	EXPECT_DEATH(Allocator.Allocate(), "");
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
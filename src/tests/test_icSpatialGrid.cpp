@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <base/tl/ic_spatial_grid.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct CItem
+{
+	vec2 m_Pos;
+	icSpatialGrid<CItem>::CNode m_Node;
+};
+
+std::vector<const CItem *> QueryBox(const icSpatialGrid<CItem> &Grid, vec2 Min, vec2 Max)
+{
+	std::vector<const CItem *> vpResult;
+	Grid.Query(Min, Max, [&](CItem *pItem) {
+		if(pItem->m_Pos.x >= Min.x && pItem->m_Pos.x <= Max.x && pItem->m_Pos.y >= Min.y && pItem->m_Pos.y <= Max.y)
+			vpResult.push_back(pItem);
+	});
+	std::sort(vpResult.begin(), vpResult.end());
+	return vpResult;
+}
+
+std::vector<const CItem *> ScanBox(const std::vector<CItem> &vItems, const std::vector<bool> &vInserted, vec2 Min, vec2 Max)
+{
+	std::vector<const CItem *> vpResult;
+	for(std::size_t i = 0; i < vItems.size(); i++)
+	{
+		const CItem &Item = vItems[i];
+		if(vInserted[i] && Item.m_Pos.x >= Min.x && Item.m_Pos.x <= Max.x && Item.m_Pos.y >= Min.y && Item.m_Pos.y <= Max.y)
+			vpResult.push_back(&Item);
+	}
+	std::sort(vpResult.begin(), vpResult.end());
+	return vpResult;
+}
+
+}
+
+TEST(IcSpatialGrid, BaseTest)
+{
+	icSpatialGrid<CItem> Grid;
+	Grid.Init(1000.0f, 500.0f, 100.0f);
+	EXPECT_EQ(Grid.CellsX(), 10);
+	EXPECT_EQ(Grid.CellsY(), 5);
+
+	CItem aItems[3];
+	aItems[0].m_Pos = vec2(50.0f, 50.0f);
+	aItems[1].m_Pos = vec2(950.0f, 450.0f);
+	aItems[2].m_Pos = vec2(-5000.0f, 10000.0f); // Out of the area
+	for(CItem &Item : aItems)
+		Grid.Insert(&Item.m_Node, &Item, Item.m_Pos);
+	EXPECT_EQ(Grid.NumItems(), 3);
+	EXPECT_EQ(aItems[0].m_Node.Cell(), 0);
+	EXPECT_EQ(aItems[1].m_Node.Cell(), 49);
+	EXPECT_EQ(aItems[2].m_Node.Cell(), 40);
+
+	EXPECT_EQ(QueryBox(Grid, vec2(0.0f, 0.0f), vec2(100.0f, 100.0f)).size(), 1u);
+	EXPECT_EQ(QueryBox(Grid, vec2(-10000.0f, 0.0f), vec2(0.0f, 20000.0f)).size(), 1u);
+
+	aItems[0].m_Pos = vec2(940.0f, 440.0f);
+	Grid.Update(&aItems[0].m_Node, aItems[0].m_Pos);
+	EXPECT_EQ(aItems[0].m_Node.Cell(), 49);
+	EXPECT_EQ(QueryBox(Grid, vec2(900.0f, 400.0f), vec2(1000.0f, 500.0f)).size(), 2u);
+
+	Grid.Remove(&aItems[1].m_Node);
+	EXPECT_FALSE(aItems[1].m_Node.IsLinked());
+	EXPECT_EQ(Grid.NumItems(), 2);
+	EXPECT_EQ(QueryBox(Grid, vec2(900.0f, 400.0f), vec2(1000.0f, 500.0f)).size(), 1u);
+
+	// Removing an unlinked node is a no-op
+	Grid.Remove(&aItems[1].m_Node);
+	EXPECT_EQ(Grid.NumItems(), 2);
+}
+
+TEST(IcSpatialGrid, MatchesLinearScan)
+{
+	std::mt19937 Rng(1234);
+	std::uniform_real_distribution<float> Coord(-500.0f, 5500.0f);
+	std::uniform_real_distribution<float> Size(0.0f, 800.0f);
+
+	icSpatialGrid<CItem> Grid;
+	Grid.Init(5000.0f, 3000.0f, 256.0f);
+
+	std::vector<CItem> vItems(500);
+	std::vector<bool> vInserted(vItems.size(), false);
+
+	for(int Round = 0; Round < 200; Round++)
+	{
+		for(std::size_t i = 0; i < vItems.size(); i++)
+		{
+			CItem &Item = vItems[i];
+			switch(Rng() % 4)
+			{
+			case 0:
+				if(vInserted[i])
+				{
+					Grid.Remove(&Item.m_Node);
+					vInserted[i] = false;
+				}
+				else
+				{
+					Item.m_Pos = vec2(Coord(Rng), Coord(Rng));
+					Grid.Insert(&Item.m_Node, &Item, Item.m_Pos);
+					vInserted[i] = true;
+				}
+				break;
+			case 1:
+				Item.m_Pos = vec2(Coord(Rng), Coord(Rng));
+				Grid.Update(&Item.m_Node, Item.m_Pos);
+				break;
+			default:
+				break;
+			}
+		}
+
+		const vec2 Min(Coord(Rng), Coord(Rng));
+		const vec2 Max = Min + vec2(Size(Rng), Size(Rng));
+		EXPECT_EQ(QueryBox(Grid, Min, Max), ScanBox(vItems, vInserted, Min, Max));
+	}
+
+	EXPECT_EQ(Grid.NumItems(), std::count(vInserted.begin(), vInserted.end(), true));
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,40 @@
+#ifndef TESTS_TEST_MAP_H
+#define TESTS_TEST_MAP_H
+
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+#include <game/collision.h>
+#include <game/layers.h>
+
+#include <memory>
+
+// A map of data/maps with its layers and collision, loaded through a
+// kernel of its own
+class CTestMap
+{
+public:
+	std::unique_ptr<IKernel> m_pKernel;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	bool Load(const char *pMapName)
+	{
+		m_pKernel.reset(IKernel::Create());
+		m_pKernel->RegisterInterface(CreateTempStorage("data"));
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "maps/%s", pMapName);
+		if(!m_pMap->Load(aPath))
+			return false;
+
+		m_Layers.Init(m_pMap);
+		m_Collision.Init(&m_Layers);
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TESTS_TEST_SERVER_H
+#define TESTS_TEST_SERVER_H
+
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/server/server.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+#include <game/server/entity.h>
+#include <game/server/gamecontext.h>
+#include <game/server/gameworld.h>
+#include <teeuniverses/components/localization.h>
+
+#include <memory>
+
+// A game context which is not running, the entities only need the snap
+// ids and the snapshot builder of the server and the collision of the game
+class CTestServer
+{
+public:
+	IKernel *m_pKernel;
+	CServer *m_pServer;
+	std::unique_ptr<IConsole> m_pConsole;
+	CGameContext *m_pGameContext;
+
+	enum
+	{
+		WIDTH = 3200,
+		HEIGHT = 2400,
+	};
+
+	CTestServer()
+	{
+		m_pKernel = IKernel::Create();
+		m_pServer = CreateServer();
+		m_pKernel->RegisterInterface(static_cast<IServer *>(m_pServer));
+		IStorage *pStorage = CreateTempStorage(".");
+		m_pKernel->RegisterInterface(pStorage);
+		m_pServer->m_pLocalization = new CLocalization(pStorage);
+		m_pServer->m_pLocalization->InitConfig(0, nullptr);
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pKernel->RegisterInterface(m_pConsole.get(), false);
+		IConfigManager *pConfigManager = CreateConfigManager();
+		m_pKernel->RegisterInterface(pConfigManager);
+		m_pGameContext = static_cast<CGameContext *>(CreateGameServer());
+		m_pKernel->RegisterInterface(static_cast<IGameServer *>(m_pGameContext));
+		pConfigManager->Init();
+		m_pConsole->Init();
+		m_pGameContext->OnConsoleInit();
+
+		InitWorld(m_pGameContext->GameWorld());
+	}
+
+	~CTestServer()
+	{
+		DeleteEntities(m_pGameContext->GameWorld());
+		delete m_pKernel;
+	}
+
+	void InitWorld(CGameWorld *pWorld)
+	{
+		pWorld->SetGameServer(m_pGameContext);
+		pWorld->InitSpatialIndex(WIDTH, HEIGHT);
+	}
+
+	// The entities release their snap ids, so they are deleted while the
+	// server is still there
+	static void DeleteEntities(CGameWorld *pWorld)
+	{
+		for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+			while(CEntity *pEnt = pWorld->FindFirst(Type))
+				delete pEnt;
+	}
+};
+
+#endif
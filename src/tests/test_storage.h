@@ -0,0 +1,36 @@
+#ifndef TESTS_TEST_STORAGE_H
+#define TESTS_TEST_STORAGE_H
+
+#include <base/system.h>
+#include <engine/storage.h>
+
+#include <filesystem>
+#include <memory>
+
+// A storage saving into a directory of its own, which is removed with all
+// its contents at the end of the test. Every test executable passes its own
+// directory, so they can run in parallel.
+class CTestStorage
+{
+public:
+	std::unique_ptr<IStorage> m_pStorage;
+
+	CTestStorage(const char *pDirectory) :
+		m_pDirectory(pDirectory)
+	{
+		fs_makedir(m_pDirectory);
+		m_pStorage.reset(CreateTempStorage(m_pDirectory));
+	}
+
+	~CTestStorage()
+	{
+		m_pStorage.reset();
+		std::error_code Error;
+		std::filesystem::remove_all(m_pDirectory, Error);
+	}
+
+private:
+	const char *m_pDirectory;
+};
+
+#endif